@@ -207,6 +207,84 @@ pair<float, float> get_depth_from_index(const BinnedDepthIndex& depth_index, con
     return total;
 }
 
+static const uint64_t depth_index_magic = 0x4854504544475600; // "\0VGDEPTH"
+static const uint64_t depth_index_version = 1;
+
+void save_depth_index(const BinnedDepthIndex& depth_index, ostream& out_stream) {
+    auto write_word = [&](uint64_t word) {
+        out_stream.write((const char*)&word, sizeof(word));
+    };
+    write_word(depth_index_magic);
+    write_word(depth_index_version);
+
+    // write the paths in sorted order so the file doesn't depend on hashing
+    vector<string> path_names;
+    for (const auto& path_depths : depth_index) {
+        path_names.push_back(path_depths.first);
+    }
+    std::sort(path_names.begin(), path_names.end());
+    write_word(path_names.size());
+
+    for (const string& path_name : path_names) {
+        write_word(path_name.size());
+        out_stream.write(path_name.data(), path_name.size());
+        const map<size_t, map<size_t, pair<float, float>>>& scaled_depth_map = depth_index.at(path_name);
+        write_word(scaled_depth_map.size());
+        for (const auto& bin_size_depths : scaled_depth_map) {
+            write_word(bin_size_depths.first);
+            write_word(bin_size_depths.second.size());
+            for (const auto& bin_depth : bin_size_depths.second) {
+                write_word(bin_depth.first);
+                out_stream.write((const char*)&bin_depth.second.first, sizeof(float));
+                out_stream.write((const char*)&bin_depth.second.second, sizeof(float));
+            }
+        }
+    }
+}
+
+BinnedDepthIndex load_depth_index(istream& in_stream) {
+    auto read_word = [&]() {
+        uint64_t word;
+        in_stream.read((char*)&word, sizeof(word));
+        if (!in_stream) {
+            throw runtime_error("Error [load_depth_index]: truncated depth index");
+        }
+        return word;
+    };
+    if (read_word() != depth_index_magic) {
+        throw runtime_error("Error [load_depth_index]: input is not a depth index");
+    }
+    if (read_word() > depth_index_version) {
+        throw runtime_error("Error [load_depth_index]: unsupported depth index version");
+    }
+
+    BinnedDepthIndex depth_index;
+    size_t num_paths = read_word();
+    for (size_t i = 0; i < num_paths; ++i) {
+        string path_name(read_word(), '\0');
+        in_stream.read(&path_name[0], path_name.size());
+        map<size_t, map<size_t, pair<float, float>>>& scaled_depth_map = depth_index[path_name];
+        size_t num_bin_sizes = read_word();
+        for (size_t j = 0; j < num_bin_sizes; ++j) {
+            size_t bin_size = read_word();
+            map<size_t, pair<float, float>>& depth_map = scaled_depth_map[bin_size];
+            size_t num_bins = read_word();
+            // the bins were written in order, so we can always insert at the end
+            for (size_t k = 0; k < num_bins; ++k) {
+                size_t bin_start = read_word();
+                pair<float, float> depth;
+                in_stream.read((char*)&depth.first, sizeof(float));
+                in_stream.read((char*)&depth.second, sizeof(float));
+                depth_map.emplace_hint(depth_map.end(), bin_start, depth);
+            }
+        }
+    }
+    if (!in_stream) {
+        throw runtime_error("Error [load_depth_index]: truncated depth index");
+    }
+    return depth_index;
+}
+
 // draw (roughly) max_nodes nodes from the graph using the random seed
 static unordered_map<nid_t, size_t> sample_nodes(const HandleGraph& graph, size_t max_nodes, size_t random_seed) {
     default_random_engine generator(random_seed);
@@ -50,9 +50,20 @@ BinnedDepthIndex binned_packed_depth_index(const Packer& packer,
                                            bool include_deletions,
                                            bool std_err);
 
+/// The bin sizes vg call uses for its depth index (and vg depth uses when saving one)
+const size_t DEFAULT_MIN_DEPTH_BIN_SIZE = 50;
+const size_t DEFAULT_MAX_DEPTH_BIN_SIZE = 50000000;
+const double DEFAULT_DEPTH_BIN_GROWTH_FACTOR = 1.5;
+
 /// Query index created above
 pair<float, float> get_depth_from_index(const BinnedDepthIndex& depth_index, const string& path_name, size_t start_offset, size_t end_offset);
 
+/// Write an index created above to a (binary) stream, so it can be queried later without the pack
+void save_depth_index(const BinnedDepthIndex& depth_index, ostream& out_stream);
+
+/// Read an index written by save_depth_index().  Throws a runtime_error if the stream isn't a valid index
+BinnedDepthIndex load_depth_index(istream& in_stream);
+
 /// Return the mean and variance of coverage of randomly sampled nodes from a mappings file
 /// Nodes with less than min_coverage are ignored
 /// The input_filename can be - for stdin
@@ -0,0 +1,205 @@
+#include "graph_edit_distance.hpp"
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+
+//#define debug_graph_edit_distance
+
+namespace vg {
+namespace algorithms {
+
+using namespace std;
+
+static const uint64_t HIGH_BIT = uint64_t(1) << 63;
+
+inline size_t edit_distance_code(char c) {
+    switch (c) {
+        case 'A': case 'a': return 0;
+        case 'C': case 'c': return 1;
+        case 'G': case 'g': return 2;
+        case 'T': case 't': return 3;
+        default: return 4;
+    }
+}
+
+/// Advance one 64-row block of Myers' vertical delta vectors by one text character,
+/// given the horizontal delta entering the top of the block, and return the horizontal
+/// delta leaving the row marked by out_bit
+inline int advance_block(uint64_t& pv, uint64_t& mv, uint64_t eq, int h_in, uint64_t out_bit) {
+    uint64_t h_in_neg = h_in < 0 ? 1 : 0;
+    uint64_t xv = eq | mv;
+    eq |= h_in_neg;
+    uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+    uint64_t ph = mv | ~(xh | pv);
+    uint64_t mh = pv & xh;
+    int h_out = (ph & out_bit) ? 1 : ((mh & out_bit) ? -1 : 0);
+    ph <<= 1;
+    mh <<= 1;
+    mh |= h_in_neg;
+    ph |= (h_in > 0 ? 1 : 0);
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+    return h_out;
+}
+
+size_t dag_edit_distance(const HandleGraph& graph, const string& sequence, size_t max_dist) {
+
+    size_t m = sequence.size();
+    if (m == 0) {
+        return 0;
+    }
+
+    size_t num_blocks = (m + 63) / 64;
+    uint64_t last_bit = uint64_t(1) << ((m - 1) % 64);
+
+    // match masks for each character code, with the padding rows past the end of the
+    // sequence set to match so they never feed a carry back into the real rows
+    vector<uint64_t> peq(5 * num_blocks, 0);
+    for (size_t i = 0; i < m; ++i) {
+        size_t code = edit_distance_code(sequence[i]);
+        if (code < 4) {
+            peq[code * num_blocks + i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+    uint64_t padding = ~((last_bit << 1) - 1);
+    for (size_t code = 0; code < 5; ++code) {
+        peq[code * num_blocks + num_blocks - 1] |= padding;
+    }
+
+    // index the handles and count in-degrees
+    vector<handle_t> handles;
+    unordered_map<handle_t, size_t> handle_idx;
+    graph.for_each_handle([&](const handle_t& handle) {
+        handle_idx[handle] = handles.size();
+        handles.push_back(handle);
+    });
+
+    bool single_stranded = true;
+    vector<size_t> in_degree(handles.size(), 0);
+    for (size_t i = 0; i < handles.size() && single_stranded; ++i) {
+        graph.follow_edges(handles[i], false, [&](const handle_t& next) {
+            if (graph.get_is_reverse(next)) {
+                single_stranded = false;
+            }
+            else {
+                ++in_degree[handle_idx[next]];
+            }
+            return single_stranded;
+        });
+        graph.follow_edges(handles[i], true, [&](const handle_t& prev) {
+            if (graph.get_is_reverse(prev)) {
+                single_stranded = false;
+            }
+            return single_stranded;
+        });
+    }
+    if (!single_stranded) {
+#ifdef debug_graph_edit_distance
+        cerr << "graph is not single stranded, cannot bound edit distance" << endl;
+#endif
+        return 0;
+    }
+
+    // Kahn's algorithm for a topological order
+    vector<size_t> order;
+    order.reserve(handles.size());
+    for (size_t i = 0; i < handles.size(); ++i) {
+        if (in_degree[i] == 0) {
+            order.push_back(i);
+        }
+    }
+    for (size_t j = 0; j < order.size(); ++j) {
+        graph.follow_edges(handles[order[j]], false, [&](const handle_t& next) {
+            size_t k = handle_idx[next];
+            if (--in_degree[k] == 0) {
+                order.push_back(k);
+            }
+        });
+    }
+    if (order.size() < handles.size()) {
+#ifdef debug_graph_edit_distance
+        cerr << "graph is cyclic, cannot bound edit distance" << endl;
+#endif
+        return 0;
+    }
+
+    // the delta vectors of the DP column at the end of each node
+    vector<uint64_t> end_pv(handles.size() * num_blocks);
+    vector<uint64_t> end_mv(handles.size() * num_blocks);
+
+    vector<uint64_t> pv(num_blocks), mv(num_blocks);
+    vector<int64_t> column(m + 1);
+
+    // aligning against nothing deletes the whole sequence
+    size_t best = m;
+    for (size_t i : order) {
+        const handle_t& handle = handles[i];
+
+        // the column where a walk starts here, which costs the length of the sequence prefix
+        for (size_t k = 0; k <= m; ++k) {
+            column[k] = k;
+        }
+        // take the minimum with the final columns of the predecessors
+        graph.follow_edges(handle, true, [&](const handle_t& prev) {
+            const uint64_t* prev_pv = &end_pv[handle_idx[prev] * num_blocks];
+            const uint64_t* prev_mv = &end_mv[handle_idx[prev] * num_blocks];
+            int64_t score = 0;
+            for (size_t k = 0; k < m; ++k) {
+                uint64_t bit = uint64_t(1) << (k % 64);
+                score += ((prev_pv[k / 64] & bit) ? 1 : 0) - ((prev_mv[k / 64] & bit) ? 1 : 0);
+                column[k + 1] = min(column[k + 1], score);
+            }
+        });
+
+        // convert the merged column back to delta vectors
+        for (size_t b = 0; b < num_blocks; ++b) {
+            pv[b] = 0;
+            mv[b] = 0;
+        }
+        for (size_t k = 0; k < m; ++k) {
+            int64_t delta = column[k + 1] - column[k];
+            if (delta > 0) {
+                pv[k / 64] |= uint64_t(1) << (k % 64);
+            }
+            else if (delta < 0) {
+                mv[k / 64] |= uint64_t(1) << (k % 64);
+            }
+        }
+        int64_t score = column[m];
+
+        // advance the column along the node sequence, tracking the bottom row
+        string seq = graph.get_sequence(handle);
+        for (size_t j = 0; j < seq.size() && best > max_dist; ++j) {
+            const uint64_t* eq = &peq[edit_distance_code(seq[j]) * num_blocks];
+            // the top row is free since the walk can start anywhere
+            int h = 0;
+            for (size_t b = 0; b < num_blocks; ++b) {
+                h = advance_block(pv[b], mv[b], eq[b], h, b + 1 == num_blocks ? last_bit : HIGH_BIT);
+            }
+            score += h;
+            if (score < (int64_t) best) {
+                best = score;
+            }
+        }
+
+        if (best <= max_dist) {
+#ifdef debug_graph_edit_distance
+            cerr << "found edit distance " << best << " within limit " << max_dist << ", stopping early" << endl;
+#endif
+            return best;
+        }
+
+        copy(pv.begin(), pv.end(), end_pv.begin() + i * num_blocks);
+        copy(mv.begin(), mv.end(), end_mv.begin() + i * num_blocks);
+    }
+
+#ifdef debug_graph_edit_distance
+    cerr << "minimum edit distance of sequence to graph is " << best << endl;
+#endif
+
+    return best;
+}
+
+}
+}
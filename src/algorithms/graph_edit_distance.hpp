@@ -0,0 +1,26 @@
+#ifndef VG_ALGORITHMS_GRAPH_EDIT_DISTANCE_HPP_INCLUDED
+#define VG_ALGORITHMS_GRAPH_EDIT_DISTANCE_HPP_INCLUDED
+
+#include <string>
+
+#include "../handle.hpp"
+
+namespace vg {
+namespace algorithms {
+
+using namespace std;
+
+/// Returns the minimum unit-cost edit distance between the entire sequence and any
+/// substring of any walk through the graph, computed with Myers' bit-parallel algorithm
+/// along each node and an elementwise minimum over predecessors where walks join. Only
+/// the forward orientation of each node is walked, so bidirected graphs should be
+/// strand-split first. Characters other than ACGT in the sequence never match.
+/// Returns as soon as any distance <= max_dist is found, so the result is exact only when
+/// it is greater than max_dist. If the graph has a directed cycle or an edge onto a
+/// reverse strand, returns 0 (which is still a valid lower bound).
+size_t dag_edit_distance(const HandleGraph& graph, const string& sequence, size_t max_dist = 0);
+
+}
+}
+
+#endif
@@ -202,6 +202,8 @@ void augment_impl(MutablePathMutableHandleGraph* graph,
     assert(!packed_mode || packer != nullptr);
     
     unordered_map<id_t, set<pos_t>> breakpoints;
+    // in unpacked mode we collect the breakpoints for each thread separately and merge them after
+    vector<unordered_map<id_t, set<pos_t>>> thread_breakpoints(packed_mode ? 0 : get_thread_count());
         
     // First pass: find the breakpoints
     iterate_gam((function<void(Alignment&)>)[&](Alignment& aln) {
@@ -234,14 +236,25 @@ void augment_impl(MutablePathMutableHandleGraph* graph,
             } else {
                 // note: we cannot pass non-zero min_baseq here.  it relies on filter_breakpoints_by_coverage
                 // to work correctly, and must be passed in only via find_packed_breakpoints.
-                find_breakpoints(simplified_path, breakpoints, break_at_ends, "", 0, 1.);
+                find_breakpoints(simplified_path, thread_breakpoints[omp_get_thread_num()], break_at_ends, "", 0, 1.);
             }
-        }, false, packed_mode);
+        }, false, true);
 
     if (packed_mode) {
         // Filter the breakpoints by coverage
         breakpoints = filter_breakpoints_by_coverage(*packer, min_bp_coverage);
     } else {
+        // Merge (and deduplicate) the breakpoints found by each thread
+        for (auto& bp_map : thread_breakpoints) {
+            if (breakpoints.empty()) {
+                breakpoints = std::move(bp_map);
+            } else {
+                for (auto& kv : bp_map) {
+                    breakpoints[kv.first].insert(kv.second.begin(), kv.second.end());
+                }
+            }
+            bp_map.clear();
+        }
         // Invert the breakpoints that are on the reverse strand
         breakpoints = forwardize_breakpoints(graph, breakpoints);
     }
@@ -588,28 +601,29 @@ map<pos_t, id_t> ensure_breakpoints(MutableHandleGraph* graph,
     // old nodes.
     map<pos_t, id_t> toReturn;
 
-    for(auto& kv : breakpoints) {
+    // Go through the nodes in ID order, so the new IDs don't depend on how the
+    // breakpoints were hashed
+    vector<id_t> original_node_ids;
+    original_node_ids.reserve(breakpoints.size());
+    for (auto& kv : breakpoints) {
+        original_node_ids.push_back(kv.first);
+    }
+    std::sort(original_node_ids.begin(), original_node_ids.end());
+
+    for (id_t original_node_id : original_node_ids) {
         // Go through all the nodes we need to break up
-        auto original_node_id = kv.first;
+        const set<pos_t>& node_breakpoints = breakpoints.at(original_node_id);
 
         // Save the original node length. We don't want to break here (or later)
         // because that would be off the end.
         id_t original_node_length = graph->get_length(graph->get_handle(original_node_id));
 
-        // We are going through the breakpoints left to right, so we need to
-        // keep the node pointer for the right part that still needs further
-        // dividing.
-        handle_t right_part = graph->get_handle(original_node_id);
-        handle_t left_part;
-
-        pos_t last_bp = make_pos_t(original_node_id, false, 0);
-        // How far into the original node does our right part start?
-        id_t current_offset = 0;
-
-        for(auto breakpoint : kv.second) {
-            // For every point at which we need to make a new node, in ascending
-            // order (due to the way sets store ints)...
-
+        // Collect all the offsets to break at, in ascending order (due to the way sets
+        // store positions), so we can divide the node (and rewrite the paths through it)
+        // just once.
+        vector<size_t> offsets;
+        offsets.reserve(node_breakpoints.size());
+        for (auto breakpoint : node_breakpoints) {
             // ensure that we're on the forward strand (should be the case due to forwardize_breakpoints)
             assert(!is_rev(breakpoint));
 
@@ -619,53 +633,38 @@ map<pos_t, id_t> ensure_breakpoints(MutableHandleGraph* graph,
                 continue;
             }
 
-            // How far in do we need to break the remaining right part? And how
-            // many bases will be in this new left part?
-            id_t divide_offset = offset(breakpoint) - current_offset;
-
-
-#ifdef debug
-            cerr << "Need to divide original " << original_node_id << " at " << breakpoint << "/" <<
-
-                original_node_length << endl;
-            cerr << "Translates to " << graph->get_id(right_part) << " at " << divide_offset << "/" <<
-                graph->get_length(right_part) << endl;
-            cerr << "divide offset is " << divide_offset << endl;
-#endif
-
-            if (offset(breakpoint) <= 0) { cerr << "breakpoint is " << breakpoint << endl; }
-            assert(offset(breakpoint) > 0);
             if (offset(breakpoint) >= original_node_length) { cerr << "breakpoint is " << breakpoint << endl; }
             assert(offset(breakpoint) < original_node_length);
-
-            // Make a new left part and right part. This updates all the
-            // existing perfect match paths in the graph.
-            std::tie(left_part, right_part) = graph->divide_handle(right_part, divide_offset);
+            offsets.push_back(offset(breakpoint));
+        }
 
 #ifdef debug
-
-            cerr << "Produced " << graph->get_id(left_part) << " (" << graph->get_length(left_part) << " bp)" << endl;
-            cerr << "Left " << graph->get_id(right_part) << " (" << graph->get_length(right_part) << " bp)" << endl;
+        cerr << "Need to divide original " << original_node_id << " at " << offsets.size() << " offsets of "
+             << original_node_length << endl;
 #endif
 
-            // The left part is now done. We know it started at current_offset
-            // and ended before breakpoint, so record it by start position.
+        // Make all the parts. This updates all the existing perfect match paths in the graph.
+        vector<handle_t> parts;
+        if (offsets.empty()) {
+            parts.push_back(graph->get_handle(original_node_id));
+        } else {
+            parts = graph->divide_handle(graph->get_handle(original_node_id), offsets);
+        }
+        assert(parts.size() == offsets.size() + 1);
 
-            // record forward and reverse
-            toReturn[last_bp] = graph->get_id(left_part);
-            toReturn[reverse(breakpoint, original_node_length)] = graph->get_id(left_part);
+        for (size_t i = 0; i < parts.size(); ++i) {
+            // Record each part by the positions of its start on both strands of the original node
+            size_t part_start = i == 0 ? 0 : offsets[i - 1];
+            size_t part_end = i == offsets.size() ? original_node_length : offsets[i];
 
-            // Record that more sequence has been consumed
-            current_offset += divide_offset;
-            last_bp = breakpoint;
+#ifdef debug
+            cerr << "Produced " << graph->get_id(parts[i]) << " (" << graph->get_length(parts[i]) << " bp)" << endl;
+#endif
 
+            toReturn[make_pos_t(original_node_id, false, part_start)] = graph->get_id(parts[i]);
+            toReturn[make_pos_t(original_node_id, true, original_node_length - part_end)] = graph->get_id(parts[i]);
         }
 
-        // Now the right part is done too. It's going to be the part
-        // corresponding to the remainder of the original node.
-        toReturn[last_bp] = graph->get_id(right_part);
-        toReturn[make_pos_t(original_node_id, true, 0)] = graph->get_id(right_part);
-
         // and record the start and end of the node
         toReturn[make_pos_t(original_node_id, true, original_node_length)] = 0;
         toReturn[make_pos_t(original_node_id, false, original_node_length)] = 0;
@@ -585,30 +585,32 @@ void Deconstructor::get_traversals(const handle_t& snarl_start, const handle_t&
     // add in the gbwt traversals
     // after this, all traversals are treated the same, with metadata embedded in their names
     if (gbwt_trav_finder.get() != nullptr) {
-        const gbwt::GBWT& gbwt_index = gbwt_trav_finder->get_gbwt();
-        pair<vector<Traversal>, vector<gbwt::size_type>> thread_travs = gbwt_trav_finder->find_path_traversals(snarl_start, snarl_end);
+        // get the unique traversals and expand them out to one per haplotype path, using the
+        // names we looked up up front rather than rebuilding them from the metadata here
+        pair<vector<Traversal>, vector<vector<gbwt::size_type>>> thread_travs =
+            gbwt_trav_finder->find_gbwt_traversals(snarl_start, snarl_end, true);
         for (int i = 0; i < thread_travs.first.size(); ++i) {
-            // We need to get a bunch of metadata about the path, but the GBWT
-            // we have might not even have structured path names stored.
-            gbwt::size_type path_id = gbwt::Path::id(thread_travs.second[i]);
-            if (!gbwt_index.hasMetadata() || !gbwt_index.metadata.hasPathNames() || path_id >= gbwt_index.metadata.paths()) {
-                continue;
-            }
-            
-            PathSense sense = gbwtgraph::get_path_sense(gbwt_index, path_id, gbwt_reference_samples);
-            
-            if (sense == PathSense::HAPLOTYPE) {
+            const vector<gbwt::size_type>& paths = thread_travs.second[i];
+            // find the last path we'll use so we can move the traversal into it rather than copy
+            int64_t last_used = -1;
+            for (int64_t j = 0; j < paths.size(); ++j) {
+                gbwt::size_type path_id = gbwt::Path::id(paths[j]);
                 // we count on convention of reference as embedded path above, so only use haplotype paths here.
                 // todo: would be nice to be more flexible...
-                string path_name = PathMetadata::create_path_name(
-                    sense,
-                    gbwtgraph::get_path_sample_name(gbwt_index, path_id, sense),
-                    gbwtgraph::get_path_locus_name(gbwt_index, path_id, sense),
-                    gbwtgraph::get_path_haplotype(gbwt_index, path_id, sense),
-                    gbwtgraph::get_path_phase_block(gbwt_index, path_id, sense),
-                    gbwtgraph::get_path_subrange(gbwt_index, path_id, sense));
-                out_trav_path_names.push_back(path_name);
-                out_travs.push_back(std::move(thread_travs.first[i]));
+                if (path_id < gbwt_path_names.size() && !gbwt_path_names[path_id].empty()) {
+                    last_used = j;
+                }
+            }
+            for (int64_t j = 0; j <= last_used; ++j) {
+                gbwt::size_type path_id = gbwt::Path::id(paths[j]);
+                if (path_id < gbwt_path_names.size() && !gbwt_path_names[path_id].empty()) {
+                    out_trav_path_names.push_back(gbwt_path_names[path_id]);
+                    if (j == last_used) {
+                        out_travs.push_back(std::move(thread_travs.first[i]));
+                    } else {
+                        out_travs.push_back(thread_travs.first[i]);
+                    }
+                }
             }
         }
     }
@@ -864,26 +866,8 @@ bool Deconstructor::deconstruct_site(const handle_t& snarl_start, const handle_t
         vcflib::Variant v;
         v.quality = 60;
 
-        // in VCF we usually just want the contig
-        string contig_name = PathMetadata::parse_locus_name(ref_trav_name);
-        if (contig_name == PathMetadata::NO_LOCUS_NAME) {
-            contig_name = ref_trav_name;
-        } else if (long_ref_contig) {
-            // the sample name isn't unique enough, so put a full ugly name in the vcf
-            if (PathMetadata::parse_sense(ref_trav_name) == PathSense::GENERIC) {
-                contig_name = ref_trav_name;
-            } else {
-                contig_name = PathMetadata::create_path_name(PathSense::REFERENCE,
-                                                             PathMetadata::parse_sample_name(ref_trav_name),
-                                                             contig_name,
-                                                             PathMetadata::parse_haplotype(ref_trav_name),
-                                                             PathMetadata::NO_PHASE_BLOCK,
-                                                             PathMetadata::NO_SUBRANGE);
-            }
-        }
-            
         // write variant's sequenceName (VCF contig)
-        v.sequenceName = contig_name;
+        v.sequenceName = get_vcf_contig_name(ref_trav_name);
 
         // Map our snarl endpoints to oriented positions in the embedded path in the graph
         handle_t first_path_handle;
@@ -1141,17 +1125,11 @@ string Deconstructor::get_vcf_header() {
     // add in the GBWT sample names
     if (gbwt) {
         // add in sample names from the gbwt
-        for (size_t i = 0; i < gbwt->metadata.paths(); i++) {
-            PathSense sense = gbwtgraph::get_path_sense(*gbwt, i, gbwt_reference_samples);
-            if (sense == PathSense::HAPLOTYPE) {
-                string path_name = PathMetadata::create_path_name(
-                    sense,
-                    gbwtgraph::get_path_sample_name(*gbwt, i, sense),
-                    gbwtgraph::get_path_locus_name(*gbwt, i, sense),
-                    gbwtgraph::get_path_haplotype(*gbwt, i, sense),
-                    gbwtgraph::get_path_phase_block(*gbwt, i, sense),
-                    gbwtgraph::get_path_subrange(*gbwt, i, sense));
+        for (size_t i = 0; i < gbwt_path_names.size(); i++) {
+            const string& path_name = gbwt_path_names[i];
+            if (!path_name.empty()) {
                 if (!this->ref_paths.count(path_name)) {
+                    PathSense sense = PathSense::HAPLOTYPE;
                     string sample_name = gbwtgraph::get_path_sample_name(*gbwt, i, sense);
                     if (!ref_samples.count(sample_name)) {
                         auto phase = gbwtgraph::get_path_haplotype(*gbwt, i, sense);
@@ -1290,32 +1268,141 @@ string Deconstructor::add_contigs_to_vcf_header(const string& vcf_header) const
     return patched_header.str();
 }
 
-void Deconstructor::deconstruct_graph(SnarlManager* snarl_manager) {
+string Deconstructor::get_vcf_contig_name(const string& ref_path_name) const {
+    // in VCF we usually just want the contig
+    string contig_name = PathMetadata::parse_locus_name(ref_path_name);
+    if (contig_name == PathMetadata::NO_LOCUS_NAME) {
+        contig_name = ref_path_name;
+    } else if (long_ref_contig) {
+        // the sample name isn't unique enough, so put a full ugly name in the vcf
+        if (PathMetadata::parse_sense(ref_path_name) == PathSense::GENERIC) {
+            contig_name = ref_path_name;
+        } else {
+            contig_name = PathMetadata::create_path_name(PathSense::REFERENCE,
+                                                         PathMetadata::parse_sample_name(ref_path_name),
+                                                         contig_name,
+                                                         PathMetadata::parse_haplotype(ref_path_name),
+                                                         PathMetadata::NO_PHASE_BLOCK,
+                                                         PathMetadata::NO_SUBRANGE);
+        }
+    }
+    return contig_name;
+}
 
-    vector<const Snarl*> snarls;
-    vector<const Snarl*> queue;
+bool Deconstructor::get_site_position(const Snarl* snarl, pair<string, size_t>& position) const {
+    handle_t snarl_start = graph->get_handle(snarl->start().node_id(), snarl->start().backward());
+    handle_t snarl_end = graph->get_handle(snarl->end().node_id(), snarl->end().backward());
+
+    // the lowest offset of each reference path on the start node
+    unordered_map<path_handle_t, size_t> start_offsets;
+    graph->for_each_step_on_handle(snarl_start, [&](step_handle_t step_handle) {
+            path_handle_t path_handle = graph->get_path_handle_of_step(step_handle);
+            if (ref_paths.count(graph->get_path_name(path_handle))) {
+                size_t offset = graph->get_position_of_step(step_handle);
+                auto it = start_offsets.find(path_handle);
+                if (it == start_offsets.end()) {
+                    start_offsets[path_handle] = offset;
+                } else {
+                    it->second = std::min(it->second, offset);
+                }
+            }
+            return true;
+        });
 
-    // read all our snarls into a list
-    snarl_manager->for_each_top_level_snarl([&](const Snarl* snarl) {
-        queue.push_back(snarl);
-    });
-    if (include_nested) {
+    // deconstruct_site() writes the variant at (or after) the first base of whichever end comes first
+    // on the reference path it picks, so the minimum over all the candidate paths is a safe bound
+    bool found = false;
+    if (!start_offsets.empty()) {
+        graph->for_each_step_on_handle(snarl_end, [&](step_handle_t step_handle) {
+                path_handle_t path_handle = graph->get_path_handle_of_step(step_handle);
+                auto it = start_offsets.find(path_handle);
+                if (it != start_offsets.end()) {
+                    string path_name = graph->get_path_name(path_handle);
+                    subrange_t subrange;
+                    Paths::strip_subrange(path_name, &subrange);
+                    size_t sub_offset = subrange == PathMetadata::NO_SUBRANGE ? 0 : subrange.first;
+                    pair<string, size_t> path_position = make_pair(get_vcf_contig_name(path_name),
+                                                                   std::min(it->second, (size_t)graph->get_position_of_step(step_handle)) + sub_offset);
+                    if (!found || path_position < position) {
+                        position = path_position;
+                        found = true;
+                    }
+                }
+                return true;
+            });
+    }
+    return found;
+}
+
+void Deconstructor::deconstruct_graph(SnarlManager* snarl_manager) {
+
+    // get the snarls to deconstruct for a top-level snarl: just itself, or its whole tree if include_nested
+    auto get_site_snarls = [&](const Snarl* top_level_snarl, vector<const Snarl*>& snarls) {
+        vector<const Snarl*> queue = {top_level_snarl};
         while (!queue.empty()) {
             const Snarl* snarl = queue.back();
             queue.pop_back();
             snarls.push_back(snarl);
-            const vector<const Snarl*>& children = snarl_manager->children_of(snarl);
-            queue.insert(queue.end(), children.begin(), children.end());
+            if (include_nested) {
+                const vector<const Snarl*>& children = snarl_manager->children_of(snarl);
+                queue.insert(queue.end(), children.begin(), children.end());
+            }
         }
-    } else {
-        swap(snarls, queue);
-    }
+    };
 
-    // process the whole shebang in parallel
+    auto deconstruct_snarls = [&](const vector<const Snarl*>& snarls) {
+        // process the whole shebang in parallel
 #pragma omp parallel for schedule(dynamic,1)
-    for (size_t i = 0; i < snarls.size(); i++) {
-        deconstruct_site(graph->get_handle(snarls[i]->start().node_id(), snarls[i]->start().backward()),
-                         graph->get_handle(snarls[i]->end().node_id(), snarls[i]->end().backward()));
+        for (size_t i = 0; i < snarls.size(); i++) {
+            deconstruct_site(graph->get_handle(snarls[i]->start().node_id(), snarls[i]->start().backward()),
+                             graph->get_handle(snarls[i]->end().node_id(), snarls[i]->end().backward()));
+        }
+    };
+
+    const vector<const Snarl*>& top_level_snarls = snarl_manager->top_level_snarls();
+
+    if (window_size == 0) {
+        // read all our snarls into a list
+        vector<const Snarl*> snarls;
+        for (const Snarl* snarl : top_level_snarls) {
+            get_site_snarls(snarl, snarls);
+        }
+        deconstruct_snarls(snarls);
+        return;
+    }
+
+    // sort the top-level snarls by (has no position, lowest position in their tree, index) so that
+    // we can write out everything before the next window once a window is done.
+    vector<tuple<bool, pair<string, size_t>, size_t>> order(top_level_snarls.size());
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < top_level_snarls.size(); ++i) {
+        vector<const Snarl*> snarls;
+        get_site_snarls(top_level_snarls[i], snarls);
+        bool has_position = false;
+        pair<string, size_t> position;
+        for (const Snarl* snarl : snarls) {
+            pair<string, size_t> snarl_position;
+            if (get_site_position(snarl, snarl_position) && (!has_position || snarl_position < position)) {
+                position = snarl_position;
+                has_position = true;
+            }
+        }
+        order[i] = make_tuple(!has_position, position, i);
+    }
+    std::sort(order.begin(), order.end());
+
+    for (size_t window_start = 0; window_start < order.size(); window_start += window_size) {
+        size_t window_end = std::min(order.size(), window_start + window_size);
+        vector<const Snarl*> snarls;
+        for (size_t i = window_start; i < window_end; ++i) {
+            get_site_snarls(top_level_snarls[get<2>(order[i])], snarls);
+        }
+        deconstruct_snarls(snarls);
+
+        // snarls without a position can't make variants, so whatever's left goes out at the end
+        if (window_end < order.size() && get<0>(order[window_end]) == false) {
+            flush_variants(cout, &get<1>(order[window_end]), snarl_manager);
+        }
     }
 }
 
@@ -1426,22 +1513,53 @@ void Deconstructor::deconstruct(vector<string> ref_paths, const PathPositionHand
         gbwt_trav_finder = unique_ptr<GBWTTraversalFinder>(new GBWTTraversalFinder(*graph, *gbwt));
     }
 
+    // the gbwt path metadata is the same for every site, so we look it up once here
+    // rather than for every traversal
+    gbwt_path_names.clear();
+    if (gbwt != nullptr && gbwt->hasMetadata() && gbwt->metadata.hasPathNames()) {
+        gbwt_path_names.resize(gbwt->metadata.paths());
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (size_t i = 0; i < gbwt_path_names.size(); ++i) {
+            PathSense sense = gbwtgraph::get_path_sense(*gbwt, i, gbwt_reference_samples);
+            if (sense == PathSense::HAPLOTYPE) {
+                gbwt_path_names[i] = PathMetadata::create_path_name(
+                    sense,
+                    gbwtgraph::get_path_sample_name(*gbwt, i, sense),
+                    gbwtgraph::get_path_locus_name(*gbwt, i, sense),
+                    gbwtgraph::get_path_haplotype(*gbwt, i, sense),
+                    gbwtgraph::get_path_phase_block(*gbwt, i, sense),
+                    gbwtgraph::get_path_subrange(*gbwt, i, sense));
+            }
+        }
+    }
+
     string hstr = this->get_vcf_header();
     assert(output_vcf.openForOutput(hstr));
 
     if (nested_decomposition) {
         deconstruct_graph_top_down(snarl_manager);
     } else {
+        if (window_size > 0) {
+            // all the contigs are reference paths, so we can write the header before
+            // streaming out the variants
+            cout << this->add_contigs_to_vcf_header(output_vcf.header) << endl;
+        }
         deconstruct_graph(snarl_manager);
     }
 
-    string patched_header = this->add_contigs_to_vcf_header(output_vcf.header);
-    cout << patched_header << endl;
+    if (nested_decomposition || window_size == 0) {
+        string patched_header = this->add_contigs_to_vcf_header(output_vcf.header);
+        cout << patched_header << endl;
+    }
 
-    // write variants in sorted order
+    // write (the rest of the) variants in sorted order
     write_variants(cout, snarl_manager);
 }
 
+void Deconstructor::set_window_size(size_t window_size) {
+    this->window_size = window_size;
+}
+
 
 }
 
@@ -49,6 +49,12 @@ public:
                      gbwt::GBWT* gbwt = nullptr,
                      bool nested_decomposition = false,
                      bool star_allele = false);
+
+    // deconstruct the top-level snarls (and their children with include_nested) in windows of
+    // this many, sorted by reference position, writing out the finished variants after each window
+    // so the whole VCF never has to be buffered.  0 (the default) buffers everything.
+    // not supported with nested_decomposition, which needs all the contigs before it can write the header
+    void set_window_size(size_t window_size);
     
 private:
 
@@ -61,8 +67,16 @@ private:
     string add_contigs_to_vcf_header(const string& vcf_header) const;
     
     // deconstruct all snarls in parallel (ie nesting relationship ignored)
+    // with a window size, the output is streamed to cout as the windows are finished
     void deconstruct_graph(SnarlManager* snarl_manager);
 
+    // get a lower bound on the (contig, position) of any variant deconstruct_site() could write
+    // for the snarl.  returns false if no reference path touches both its ends
+    bool get_site_position(const Snarl* snarl, pair<string, size_t>& position) const;
+
+    // get the VCF contig name to use for a reference path
+    string get_vcf_contig_name(const string& ref_path_name) const;
+
     // deconstruct all top-level snarls in parallel
     // nested snarls are processed after their parents in the same thread
     // (same logic as vg call)
@@ -152,6 +166,9 @@ private:
     unique_ptr<GBWTTraversalFinder> gbwt_trav_finder;
     // When using the gbwt we need some precomputed information to ask about stored paths.
     unordered_set<string> gbwt_reference_samples;
+    // the full name of each gbwt path, computed once up front (empty for non-haplotype paths,
+    // which we don't use as samples)
+    vector<string> gbwt_path_names;
     
     // infer ploidys from gbwt when possible
     unordered_map<string, pair<int, int>> gbwt_sample_to_phase_range;
@@ -207,6 +224,9 @@ private:
     // ex: a big containing deletion
     // only works with nested_decomposition
     bool star_allele = false;
+
+    // number of top-level snarls to deconstruct before writing out variants (0 = write at the end)
+    size_t window_size = 0;
 };
 
 
@@ -2,6 +2,10 @@
 #include "gbwt_helper.hpp"
 
 #include <vg/io/vpkg.hpp>
+#include <gbwtgraph/index.h>
+
+#include <algorithm>
+#include <omp.h>
 
 namespace vg {
 
@@ -164,6 +168,107 @@ void save_minimizer(const gbwtgraph::DefaultMinimizerIndex& index, const std::st
 
 //------------------------------------------------------------------------------
 
+void index_haplotypes_sharded(const gbwtgraph::GBWTGraph& graph, gbwtgraph::DefaultMinimizerIndex& index,
+                              const std::function<gbwtgraph::Payload(nid_t)>& get_payload, size_t shards) {
+
+    typedef gbwtgraph::DefaultMinimizerIndex::minimizer_type minimizer_type;
+    typedef std::pair<minimizer_type, pos_t> hit_type;
+
+    // Hits within a shard are ordered by hash and then by position. The position
+    // determines the kmer, so this is a total order on distinct hits.
+    auto hit_less = [](const hit_type& a, const hit_type& b) {
+        if (a.first.hash != b.first.hash) {
+            return a.first.hash < b.first.hash;
+        }
+        return a.second < b.second;
+    };
+    auto hit_equal = [](const hit_type& a, const hit_type& b) {
+        return a.first.key == b.first.key && a.second == b.second;
+    };
+    auto sort_and_deduplicate = [&](std::vector<hit_type>& hits) {
+        std::sort(hits.begin(), hits.end(), hit_less);
+        hits.erase(std::unique(hits.begin(), hits.end(), hit_equal), hits.end());
+    };
+
+    shards = std::max(shards, size_t(1));
+    int threads = omp_get_max_threads();
+    constexpr size_t BUFFER_SIZE = 1024;
+
+    // Each thread collects the hits for each shard separately, so that no locking
+    // is needed. A thread deduplicates its hits for a shard when they have doubled
+    // in size since the last time, which keeps memory proportional to the number
+    // of distinct hits.
+    std::vector<std::vector<std::vector<hit_type>>> thread_hits(threads, std::vector<std::vector<hit_type>>(shards));
+    std::vector<std::vector<size_t>> thread_deduplicated(threads, std::vector<size_t>(shards, 0));
+
+    auto find_minimizers = [&](const std::vector<handle_t>& traversal, const std::string& seq) {
+        std::vector<minimizer_type> minimizers = index.minimizers(seq);
+        auto iter = traversal.begin();
+        size_t node_start = 0;
+        int thread_id = omp_get_thread_num();
+        for (minimizer_type& minimizer : minimizers) {
+            if (minimizer.empty()) {
+                continue;
+            }
+            // Find the node covering the starting position of the minimizer.
+            size_t node_length = graph.get_length(*iter);
+            while (node_start + node_length <= minimizer.offset) {
+                node_start += node_length;
+                ++iter;
+                node_length = graph.get_length(*iter);
+            }
+            pos_t pos = make_pos_t(graph.get_id(*iter), graph.get_is_reverse(*iter), minimizer.offset - node_start);
+            if (minimizer.is_reverse) {
+                pos = reverse_base_pos(pos, node_length);
+            }
+            size_t shard = minimizer.hash % shards;
+            std::vector<hit_type>& hits = thread_hits[thread_id][shard];
+            hits.emplace_back(minimizer, pos);
+            size_t& deduplicated = thread_deduplicated[thread_id][shard];
+            if (hits.size() >= 2 * std::max(deduplicated, BUFFER_SIZE)) {
+                sort_and_deduplicate(hits);
+                deduplicated = hits.size();
+            }
+        }
+    };
+    gbwtgraph::for_each_haplotype_window(graph, index.window_bp(), find_minimizers, (threads > 1));
+
+    // Compute the payloads once per node.
+    std::vector<nid_t> nodes;
+    graph.for_each_handle([&](const handle_t& handle) {
+        nodes.push_back(graph.get_id(handle));
+    });
+    std::sort(nodes.begin(), nodes.end());
+    std::vector<gbwtgraph::Payload> payloads(nodes.size());
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (size_t i = 0; i < nodes.size(); i++) {
+        payloads[i] = get_payload(nodes[i]);
+    }
+
+    // Finish the shards in parallel and stream them into the index in order. Only
+    // one thread can modify the index at a time, but the other threads keep
+    // finishing the later shards in the meantime.
+    #pragma omp parallel for schedule(dynamic, 1) ordered
+    for (size_t shard = 0; shard < shards; shard++) {
+        std::vector<hit_type> hits;
+        for (int thread_id = 0; thread_id < threads; thread_id++) {
+            std::vector<hit_type>& buffer = thread_hits[thread_id][shard];
+            hits.insert(hits.end(), buffer.begin(), buffer.end());
+            std::vector<hit_type>().swap(buffer);
+        }
+        sort_and_deduplicate(hits);
+        #pragma omp ordered
+        {
+            for (const hit_type& hit : hits) {
+                size_t node_rank = std::lower_bound(nodes.begin(), nodes.end(), id(hit.second)) - nodes.begin();
+                index.insert(hit.first, hit.second, payloads[node_rank]);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
 /// Return a mapping of the original segment ids to a list of chopped node ids
 /// (mimicking logic and interface from function of same name in gbwt_helper.cpp)
 unordered_map<string, vector<nid_t>> load_translation_map(const gbwtgraph::GBWTGraph& graph) {
@@ -9,6 +9,7 @@
 #include <gbwtgraph/gbz.h>
 #include <gbwtgraph/minimizer.h>
 #include "position.hpp"
+#include <functional>
 #include <unordered_map>
 #include <vector>
 
@@ -60,6 +61,20 @@ void save_minimizer(const gbwtgraph::DefaultMinimizerIndex& index, const std::st
 
 //------------------------------------------------------------------------------
 
+/**
+ * Insert the minimizers of the haplotype windows in the graph into the index,
+ * like gbwtgraph::index_haplotypes(), but without a global lock. Each thread
+ * collects its own hits into shards by minimizer hash, and the shards are
+ * merged, sorted, and deduplicated independently. The payload depends only on
+ * the node and is computed once per node. Finished shards are streamed into the
+ * index in shard order while the later ones are still being merged, so the
+ * result does not depend on the number of threads.
+ */
+void index_haplotypes_sharded(const gbwtgraph::GBWTGraph& graph, gbwtgraph::DefaultMinimizerIndex& index,
+                              const std::function<gbwtgraph::Payload(nid_t)>& get_payload, size_t shards);
+
+//------------------------------------------------------------------------------
+
 /// Return a mapping of the original segment ids to a list of chopped node ids
 std::unordered_map<std::string, std::vector<nid_t>> load_translation_map(const gbwtgraph::GBWTGraph& graph);
 
@@ -18,6 +18,75 @@ void GraphCaller::set_show_progress(bool show_progress) {
     this->show_progress = show_progress;
 }
 
+void GraphCaller::set_window_size(size_t window_size, function<void(const pair<string, size_t>*)> finish_window) {
+    this->window_size = window_size;
+    this->finish_window = finish_window;
+}
+
+bool GraphCaller::get_output_position(const HandleGraph& graph, const Snarl& snarl, pair<string, size_t>& position) const {
+    return false;
+}
+
+void GraphCaller::add_snarl_tree(const Snarl* snarl, vector<const Snarl*>& snarls) const {
+    snarls.push_back(snarl);
+    for (size_t i = snarls.size() - 1; i < snarls.size(); ++i) {
+        const vector<const Snarl*>& children = snarl_manager.children_of(snarls[i]);
+        snarls.insert(snarls.end(), children.begin(), children.end());
+    }
+}
+
+void GraphCaller::call_in_windows(const HandleGraph& graph, size_t count,
+                                  const function<void(size_t, vector<const Snarl*>&)>& get_snarls,
+                                  const function<void(size_t)>& process_item,
+                                  const function<void()>& process_children) {
+
+    // sort the items by (has no position, lowest position in their tree, index) so the unplaced
+    // ones go last.  a nested child can be placed even if its top-level item isn't, so we look at
+    // every snarl that the item could end up calling
+    vector<tuple<bool, pair<string, size_t>, size_t>> order(count);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < count; ++i) {
+        vector<const Snarl*> snarls;
+        get_snarls(i, snarls);
+        bool has_position = false;
+        pair<string, size_t> position;
+        for (const Snarl* snarl : snarls) {
+            pair<string, size_t> snarl_position;
+            if (get_output_position(graph, *snarl, snarl_position) && (!has_position || snarl_position < position)) {
+                position = snarl_position;
+                has_position = true;
+            }
+        }
+        order[i] = make_tuple(!has_position, position, i);
+    }
+    std::sort(order.begin(), order.end());
+
+    for (size_t window_start = 0; window_start < count; window_start += window_size) {
+        size_t window_end = std::min(count, window_start + window_size);
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = window_start; i < window_end; ++i) {
+            process_item(get<2>(order[i]));
+        }
+        process_children();
+
+        if (finish_window) {
+            if (window_end == count) {
+                finish_window(nullptr);
+            } else if (get<0>(order[window_end]) == false) {
+                // nothing left to do can output before the next window's first position
+                finish_window(&get<1>(order[window_end]));
+            }
+        }
+        if (show_progress) {
+            cerr << "[vg call]: Finished window of " << (window_end - window_start) << " top-level items ("
+                 << window_end << "/" << count << ")" << endl;
+        }
+    }
+    if (count == 0 && finish_window) {
+        finish_window(nullptr);
+    }
+}
+
 void GraphCaller::call_top_level_snarls(const HandleGraph& graph, RecurseType recurse_type) {
 
     // Used to recurse on children of parents that can't be called
@@ -62,26 +131,41 @@ void GraphCaller::call_top_level_snarls(const HandleGraph& graph, RecurseType re
         }
     };
 
-    // Start with the top level snarls
-    snarl_manager.for_each_top_level_snarl_parallel(process_snarl);
-    if (show_progress) cerr << "[vg call]: Finished processing " << top_snarl_count << " top-level snarls" << endl;
-
-    top_level = false;
-
-    // Then recurse on any children the snarl caller failed to handle
-    while (!std::all_of(snarl_queue.begin(), snarl_queue.end(),
-                        [](const vector<const Snarl*>& snarl_vec) {return snarl_vec.empty();})) {
-        vector<const Snarl*> cur_queue;
-        for (vector<const Snarl*>& thread_queue : snarl_queue) {
-            cur_queue.reserve(cur_queue.size() + thread_queue.size());
-            std::move(thread_queue.begin(), thread_queue.end(), std::back_inserter(cur_queue));
-            thread_queue.clear();
-        }
+    // Recurse on any children the snarl caller failed to handle
+    auto process_children = [&]() {
+        top_level = false;
+        while (!std::all_of(snarl_queue.begin(), snarl_queue.end(),
+                            [](const vector<const Snarl*>& snarl_vec) {return snarl_vec.empty();})) {
+            vector<const Snarl*> cur_queue;
+            for (vector<const Snarl*>& thread_queue : snarl_queue) {
+                cur_queue.reserve(cur_queue.size() + thread_queue.size());
+                std::move(thread_queue.begin(), thread_queue.end(), std::back_inserter(cur_queue));
+                thread_queue.clear();
+            }
 
 #pragma omp parallel for schedule(dynamic, 1)
-        for (int i = 0; i < cur_queue.size(); ++i) {
-            process_snarl(cur_queue[i]);
+            for (int i = 0; i < cur_queue.size(); ++i) {
+                process_snarl(cur_queue[i]);
+            }
         }
+        top_level = true;
+    };
+
+    if (window_size == 0) {
+        // Start with the top level snarls
+        snarl_manager.for_each_top_level_snarl_parallel(process_snarl);
+        if (show_progress) cerr << "[vg call]: Finished processing " << top_snarl_count << " top-level snarls" << endl;
+
+        // Then do the children
+        process_children();
+    } else {
+        // Do the top level snarls and their children a window at a time
+        const vector<const Snarl*>& top_level_snarls = snarl_manager.top_level_snarls();
+        call_in_windows(graph, top_level_snarls.size(),
+                        [&](size_t i, vector<const Snarl*>& snarls) { add_snarl_tree(top_level_snarls[i], snarls); },
+                        [&](size_t i) { process_snarl(top_level_snarls[i]); },
+                        process_children);
+        if (show_progress) cerr << "[vg call]: Finished processing " << top_snarl_count << " top-level snarls" << endl;
     }
     if (show_progress && nested_snarl_count > 0) cerr << "[vg call]: Finished processing " << nested_snarl_count << " nested snarls" << endl;
   
@@ -137,24 +221,45 @@ void GraphCaller::call_top_level_chains(const HandleGraph& graph, size_t max_edg
         }
     };
 
-    // Start with the top level snarls
-    snarl_manager.for_each_top_level_chain_parallel(process_chain);
-
-    // Then recurse on any children the snarl caller failed to handle
-    while (!std::all_of(chain_queue.begin(), chain_queue.end(),
-                        [](const vector<Chain>& chain_vec) {return chain_vec.empty();})) {
-        vector<Chain> cur_queue;
-        for (vector<Chain>& thread_queue : chain_queue) {
-            cur_queue.reserve(cur_queue.size() + thread_queue.size());
-            std::move(thread_queue.begin(), thread_queue.end(), std::back_inserter(cur_queue));
-            thread_queue.clear();
-        }
+    // Recurse on any children the snarl caller failed to handle
+    auto process_children = [&]() {
+        while (!std::all_of(chain_queue.begin(), chain_queue.end(),
+                            [](const vector<Chain>& chain_vec) {return chain_vec.empty();})) {
+            vector<Chain> cur_queue;
+            for (vector<Chain>& thread_queue : chain_queue) {
+                cur_queue.reserve(cur_queue.size() + thread_queue.size());
+                std::move(thread_queue.begin(), thread_queue.end(), std::back_inserter(cur_queue));
+                thread_queue.clear();
+            }
 
 #pragma omp parallel for schedule(dynamic, 1)
-        for (int i = 0; i < cur_queue.size(); ++i) {
-            process_chain(&cur_queue[i]);
+            for (int i = 0; i < cur_queue.size(); ++i) {
+                process_chain(&cur_queue[i]);
+            }
         }
-    
+    };
+
+    if (window_size == 0) {
+        // Start with the top level chains
+        snarl_manager.for_each_top_level_chain_parallel(process_chain);
+
+        // Then do the children
+        process_children();
+    } else {
+        // Do the top level chains and their children a window at a time, placing each chain
+        // by the first of its snarls and their children
+        vector<const Chain*> top_level_chains;
+        snarl_manager.for_each_top_level_chain([&](const Chain* chain) {
+                top_level_chains.push_back(chain);
+            });
+        call_in_windows(graph, top_level_chains.size(),
+                        [&](size_t i, vector<const Snarl*>& snarls) {
+                            for (const pair<const Snarl*, bool>& link : *top_level_chains[i]) {
+                                add_snarl_tree(link.first, snarls);
+                            }
+                        },
+                        [&](size_t i) { process_chain(top_level_chains[i]); },
+                        process_children);
     }
 }
 
@@ -255,25 +360,47 @@ bool VCFOutputCaller::add_variant(vcflib::Variant& var) const {
 }
 
 void VCFOutputCaller::write_variants(ostream& out_stream, const SnarlManager* snarl_manager) {
+    flush_variants(out_stream, nullptr, snarl_manager);
+}
+
+void VCFOutputCaller::flush_variants(ostream& out_stream, const pair<string, size_t>* next_position,
+                                     const SnarlManager* snarl_manager) {
     assert(include_nested == false || snarl_manager != nullptr);
     if (include_nested) {
+        // a top-level snarl's whole tree is called in the same window, so the new variants
+        // are all we need to look at to find their parents
         update_nesting_info_tags(snarl_manager);
     }
-    vector<pair<pair<string, size_t>, string>> all_variants;
-    for (const auto& buf : output_variants) {
-        all_variants.reserve(all_variants.size() + buf.size());
-        std::move(buf.begin(), buf.end(), std::back_inserter(all_variants));
-    }
-    std::sort(all_variants.begin(), all_variants.end(), [](const pair<pair<string, size_t>, string>& v1,
-                                                           const pair<pair<string, size_t>, string>& v2) {
-            return v1.first.first < v2.first.first || (v1.first.first == v2.first.first && v1.first.second < v2.first.second);
-        });
-    for (auto v : all_variants) {
+    auto variant_less = [](const pair<pair<string, size_t>, string>& v1,
+                           const pair<pair<string, size_t>, string>& v2) {
+        return v1.first.first < v2.first.first || (v1.first.first == v2.first.first && v1.first.second < v2.first.second);
+    };
+    
+    // merge the new variants into the reorder buffer
+    size_t old_size = reorder_buffer.size();
+    for (auto& buf : output_variants) {
+        reorder_buffer.reserve(reorder_buffer.size() + buf.size());
+        std::move(buf.begin(), buf.end(), std::back_inserter(reorder_buffer));
+        buf.clear();
+    }
+    std::sort(reorder_buffer.begin() + old_size, reorder_buffer.end(), variant_less);
+    std::inplace_merge(reorder_buffer.begin(), reorder_buffer.begin() + old_size, reorder_buffer.end(), variant_less);
+
+    // nothing still to come can sort before next_position, so everything before it is ready
+    auto flush_end = reorder_buffer.end();
+    if (next_position != nullptr) {
+        flush_end = std::lower_bound(reorder_buffer.begin(), reorder_buffer.end(), *next_position,
+                                     [](const pair<pair<string, size_t>, string>& v, const pair<string, size_t>& position) {
+                                         return v.first < position;
+                                     });
+    }
+    for (auto v = reorder_buffer.begin(); v != flush_end; ++v) {
         string dest;
-        int ret = zstdutil::DecompressString(v.second, dest);
+        int ret = zstdutil::DecompressString(v->second, dest);
         assert(ret == 0);
         out_stream << dest << endl;
     }
+    reorder_buffer.erase(reorder_buffer.begin(), flush_end);
 }
 
 static int countAlts(vcflib::Variant& var, int alleleIndex) {
@@ -449,6 +576,22 @@ bool VCFOutputCaller::emit_variant(const PathPositionHandleGraph& graph, SnarlCa
                                    const vector<int>& genotype, int ref_trav_idx, const unique_ptr<SnarlCaller::CallInfo>& call_info,
                                    const string& ref_path_name, int ref_offset, bool genotype_snarls, int ploidy,
                                    function<string(const vector<SnarlTraversal>&, const vector<int>&, int, int, int)> trav_to_string) {
+    return emit_variant(graph, {&snarl_caller}, {sample_name}, snarl, called_traversals, {genotype}, ref_trav_idx, {&call_info},
+                        ref_path_name, ref_offset, genotype_snarls, ploidy, trav_to_string);
+}
+
+bool VCFOutputCaller::emit_variant(const PathPositionHandleGraph& graph, const vector<SnarlCaller*>& snarl_callers,
+                                   const vector<string>& sample_names,
+                                   const Snarl& snarl, const vector<SnarlTraversal>& called_traversals,
+                                   const vector<vector<int>>& genotypes, int ref_trav_idx,
+                                   const vector<const unique_ptr<SnarlCaller::CallInfo>*>& call_infos,
+                                   const string& ref_path_name, int ref_offset, bool genotype_snarls, int ploidy,
+                                   function<string(const vector<SnarlTraversal>&, const vector<int>&, int, int, int)> trav_to_string) {
+
+    assert(!genotypes.empty() && genotypes.size() == sample_names.size() &&
+           genotypes.size() == snarl_callers.size() && genotypes.size() == call_infos.size());
+    // the first sample's genotype is used wherever the allele strings need a genotype for context
+    const vector<int>& genotype = genotypes.front();
     
 #ifdef debug
     cerr << "emitting variant for " << pb2json(snarl) << endl;
@@ -458,8 +601,10 @@ bool VCFOutputCaller::emit_variant(const PathPositionHandleGraph& graph, SnarlCa
         }
         cerr << "ct[" << i << "]=" << pb2json(called_traversals[i]) << endl;
     }
-    for (int i = 0; i < genotype.size(); ++i) {
-        cerr << "gt[" << i << "]=" << genotype[i] << endl;
+    for (int s = 0; s < genotypes.size(); ++s) {
+        for (int i = 0; i < genotypes[s].size(); ++i) {
+            cerr << sample_names[s] << " gt[" << i << "]=" << genotypes[s][i] << endl;
+        }
     }
 #endif
 
@@ -472,26 +617,28 @@ bool VCFOutputCaller::emit_variant(const PathPositionHandleGraph& graph, SnarlCa
     vcflib::Variant out_variant;
 
     vector<SnarlTraversal> site_traversals = {called_traversals[ref_trav_idx]};
-    vector<int> site_genotype;
+    vector<vector<int>> site_genotypes(genotypes.size());
     auto ref_gt_it = std::find(genotype.begin(), genotype.end(), ref_trav_idx);
     out_variant.ref = trav_to_string(called_traversals, genotype, ref_trav_idx,
                                      ref_gt_it != genotype.end() ? ref_gt_it - genotype.begin() : 0,
                                      ref_trav_idx);
     
-    // deduplicate alleles and compute the site traversals and genotype
+    // deduplicate alleles (across all the samples) and compute the site traversals and genotypes
     map<string, int> allele_to_gt;    
-    allele_to_gt[out_variant.ref] = 0;    
-    for (int i = 0; i < genotype.size(); ++i) {
-        if (genotype[i] == ref_trav_idx) {
-            site_genotype.push_back(0);
-        } else {
-            string allele_string = trav_to_string(called_traversals, genotype, genotype[i], i, ref_trav_idx);
-            if (allele_to_gt.count(allele_string)) {
-                site_genotype.push_back(allele_to_gt[allele_string]);
+    allele_to_gt[out_variant.ref] = 0;
+    for (int s = 0; s < genotypes.size(); ++s) {
+        for (int i = 0; i < genotypes[s].size(); ++i) {
+            if (genotypes[s][i] == ref_trav_idx) {
+                site_genotypes[s].push_back(0);
             } else {
-                site_traversals.push_back(called_traversals[genotype[i]]);
-                site_genotype.push_back(allele_to_gt.size());
-                allele_to_gt[allele_string] = site_genotype.back();
+                string allele_string = trav_to_string(called_traversals, genotypes[s], genotypes[s][i], i, ref_trav_idx);
+                if (allele_to_gt.count(allele_string)) {
+                    site_genotypes[s].push_back(allele_to_gt[allele_string]);
+                } else {
+                    site_traversals.push_back(called_traversals[genotypes[s][i]]);
+                    site_genotypes[s].push_back(allele_to_gt.size());
+                    allele_to_gt[allele_string] = site_genotypes[s].back();
+                }
             }
         }
     }
@@ -555,31 +702,70 @@ bool VCFOutputCaller::emit_variant(const PathPositionHandleGraph& graph, SnarlCa
     out_variant.filter = "PASS";
     out_variant.updateAlleleIndexes();
 
-    // add the genotype
+    // add the genotypes
     out_variant.format.push_back("GT");
-    auto& genotype_vector = out_variant.samples[sample_name]["GT"];
-    
-    stringstream vcf_gt;
-    if (!genotype.empty()) {
-        for (int i = 0; i < site_genotype.size(); ++i) {
-            vcf_gt << site_genotype[i];
-            if (i != site_genotype.size() - 1) {
-                vcf_gt << "/";
+    for (int s = 0; s < genotypes.size(); ++s) {
+        stringstream vcf_gt;
+        if (!genotypes[s].empty()) {
+            for (int i = 0; i < site_genotypes[s].size(); ++i) {
+                vcf_gt << site_genotypes[s][i];
+                if (i != site_genotypes[s].size() - 1) {
+                    vcf_gt << "/";
+                }
             }
-        }
-    } else {
-        for (int i = 0; i < ploidy; ++i) {
-            vcf_gt << ".";
-            if (i != ploidy - 1) {
-                vcf_gt << "/";
+        } else {
+            for (int i = 0; i < ploidy; ++i) {
+                vcf_gt << ".";
+                if (i != ploidy - 1) {
+                    vcf_gt << "/";
+                }
             }
         }
+        out_variant.samples[sample_names[s]]["GT"].push_back(vcf_gt.str());
     }
-                    
-    genotype_vector.push_back(vcf_gt.str());
 
     // add some support info
-    snarl_caller.update_vcf_info(snarl, site_traversals, site_genotype, call_info, sample_name, out_variant);
+    if (genotypes.size() == 1) {
+        snarl_callers[0]->update_vcf_info(snarl, site_traversals, site_genotypes[0], *call_infos[0], sample_names[0], out_variant);
+    } else {
+        // the callers write site-level fields (QUAL, FILTER, INFO) as if theirs was the only
+        // sample, so give each one a scratch copy and merge them: the INFO comes from the first
+        // sample but with the depths summed, the quality is the best one and the site passes if
+        // any sample passes
+        bool any_pass = false;
+        string first_filter;
+        double total_depth = 0;
+        bool has_depth = false;
+        out_variant.quality = 0;
+        // every scratch copy starts from the INFO as it was before any caller touched it, so
+        // that the fields the callers append to (like DP) only ever hold the one sample's value
+        const auto site_info = out_variant.info;
+        for (int s = 0; s < genotypes.size(); ++s) {
+            vcflib::Variant sample_variant = out_variant;
+            sample_variant.info = site_info;
+            sample_variant.format.clear();
+            sample_variant.samples.clear();
+            snarl_callers[s]->update_vcf_info(snarl, site_traversals, site_genotypes[s], *call_infos[s], sample_names[s], sample_variant);
+            if (s == 0) {
+                out_variant.format.insert(out_variant.format.end(), sample_variant.format.begin(), sample_variant.format.end());
+                first_filter = sample_variant.filter;
+                out_variant.info = sample_variant.info;
+            }
+            for (auto& field : sample_variant.samples[sample_names[s]]) {
+                out_variant.samples[sample_names[s]][field.first] = std::move(field.second);
+            }
+            if (sample_variant.info.count("DP") && !sample_variant.info["DP"].empty()) {
+                total_depth += parse<double>(sample_variant.info["DP"].front());
+                has_depth = true;
+            }
+            out_variant.quality = max(out_variant.quality, sample_variant.quality);
+            any_pass = any_pass || sample_variant.filter == "PASS";
+        }
+        if (has_depth) {
+            out_variant.info["DP"] = {std::to_string((int64_t)round(total_depth))};
+        }
+        out_variant.filter = any_pass ? "PASS" : first_filter;
+    }
 
     // if genotype_snarls, then we only flatten up to the snarl endpoints
     // (this is when we are in genotyping mode and want consistent calls regardless of the sample)
@@ -597,11 +783,12 @@ bool VCFOutputCaller::emit_variant(const PathPositionHandleGraph& graph, SnarlCa
     for (int i = 0; i < site_traversals.size(); ++i) {
         cerr << " site trav[" << i << "]=" << pb2json(site_traversals[i]) << endl;
     }
-    for (int i = 0; i < site_genotype.size(); ++i) {
-        cerr << " site geno[" << i << "]=" << site_genotype[i] << endl;
+    for (int s = 0; s < site_genotypes.size(); ++s) {
+        for (int i = 0; i < site_genotypes[s].size(); ++i) {
+            cerr << " " << sample_names[s] << " site geno[" << i << "]=" << site_genotypes[s][i] << endl;
+        }
     }
 #endif
-
     if (genotype_snarls || !out_variant.alt.empty()) {
         bool added = add_variant(out_variant);
         if (!added) {
@@ -696,6 +883,71 @@ tuple<int64_t, int64_t, bool, step_handle_t, step_handle_t> VCFOutputCaller::get
     }
 }
 
+string VCFOutputCaller::get_ref_path_name(const PathHandleGraph& graph, const Snarl& snarl,
+                                          const unordered_set<string>& ref_path_set) const {
+    set<string> start_path_names;
+    graph.for_each_step_on_handle(graph.get_handle(snarl.start().node_id()), [&](step_handle_t step_handle) {
+            string name = graph.get_path_name(graph.get_path_handle_of_step(step_handle));
+            if (!Paths::is_alt(name) && (ref_path_set.empty() || ref_path_set.count(name))) {
+                start_path_names.insert(name);
+            }
+            return true;
+        });
+    
+    set<string> end_path_names;
+    if (!start_path_names.empty()) {
+        graph.for_each_step_on_handle(graph.get_handle(snarl.end().node_id()), [&](step_handle_t step_handle) {
+                string name = graph.get_path_name(graph.get_path_handle_of_step(step_handle));
+                if (!Paths::is_alt(name) && (ref_path_set.empty() || ref_path_set.count(name))) {
+                    end_path_names.insert(name);
+                }
+                return true;
+            });
+    }
+    
+    // we do the full intersection (instead of more quickly finding the first common path)
+    // so that we always take the lexicographically lowest path, rather than depending
+    // on the order of iteration which could change between implementations / runs.
+    vector<string> common_names;
+    std::set_intersection(start_path_names.begin(), start_path_names.end(),
+                          end_path_names.begin(), end_path_names.end(),
+                          std::back_inserter(common_names));
+
+    return common_names.empty() ? string() : common_names.front();
+}
+
+bool VCFOutputCaller::get_vcf_position(const PathPositionHandleGraph& graph, const Snarl& snarl,
+                                       const unordered_set<string>& ref_path_set,
+                                       const map<string, size_t>& ref_offsets,
+                                       pair<string, size_t>& position) const {
+    if (snarl.start().node_id() == snarl.end().node_id() ||
+        !graph.has_node(snarl.start().node_id()) || !graph.has_node(snarl.end().node_id())) {
+        return false;
+    }
+
+    string ref_path_name = get_ref_path_name(graph, snarl, ref_path_set);
+    if (ref_path_name.empty()) {
+        return false;
+    }
+
+    int64_t ref_start = get<0>(get_ref_interval(graph, snarl, ref_path_name));
+    if (ref_start == -1) {
+        return false;
+    }
+
+    // name the contig the same way as emit_variant()
+    subrange_t subrange;
+    string basepath_name = Paths::strip_subrange(ref_path_name, &subrange);
+    size_t basepath_offset = subrange == PathMetadata::NO_SUBRANGE ? 0 : subrange.first;
+    string contig_name = PathMetadata::parse_locus_name(basepath_name);
+    if (contig_name != PathMetadata::NO_LOCUS_NAME) {
+        basepath_name = contig_name;
+    }
+    auto offset = ref_offsets.find(ref_path_name);
+    position = make_pair(basepath_name, ref_start + (offset != ref_offsets.end() ? offset->second : 0) + 1 + basepath_offset);
+    return true;
+}
+
 pair<string, int64_t> VCFOutputCaller::get_ref_position(const PathPositionHandleGraph& graph, const Snarl& snarl, const string& ref_path_name,
                                                         int64_t ref_path_offset) const {
 
@@ -1009,18 +1261,19 @@ SnarlTraversal GAFOutputCaller::pad_traversal(const PathHandleGraph& graph, cons
 
 void VCFOutputCaller::update_nesting_info_tags(const SnarlManager* snarl_manager) {
 
-    // index the snarl tree by name
-    unordered_map<string, const Snarl*> name_to_snarl;
-    Snarl flipped_snarl;
-    snarl_manager->for_each_snarl_preorder([&](const Snarl* snarl) {
-            name_to_snarl[print_snarl(*snarl)] = snarl;
-            // also add a map from the flipped snarl (as call sometimes messes with orientation)
-            flipped_snarl.mutable_start()->set_node_id(snarl->end().node_id());
-            flipped_snarl.mutable_start()->set_backward(!snarl->end().backward());
-            flipped_snarl.mutable_end()->set_node_id(snarl->start().node_id());
-            flipped_snarl.mutable_end()->set_backward(!snarl->start().backward());
-            name_to_snarl[print_snarl(flipped_snarl)] = snarl;
-        });
+    // index the snarl tree by name (just once, as we can be called for each window)
+    if (name_to_snarl.empty()) {
+        Snarl flipped_snarl;
+        snarl_manager->for_each_snarl_preorder([&](const Snarl* snarl) {
+                name_to_snarl[print_snarl(*snarl)] = snarl;
+                // also add a map from the flipped snarl (as call sometimes messes with orientation)
+                flipped_snarl.mutable_start()->set_node_id(snarl->end().node_id());
+                flipped_snarl.mutable_start()->set_backward(!snarl->end().backward());
+                flipped_snarl.mutable_end()->set_node_id(snarl->start().node_id());
+                flipped_snarl.mutable_end()->set_backward(!snarl->start().backward());
+                name_to_snarl[print_snarl(flipped_snarl)] = snarl;
+            });
+    }
 
     // pass 1) index sites in vcf
     // (todo: this could be done more quickly upstream)
@@ -1694,7 +1947,9 @@ FlowCaller::FlowCaller(const PathPositionHandleGraph& graph,
     traversals_only(traversals_only),
     gaf_output(gaf_output),
     genotype_snarls(genotype_snarls),
-    allele_length_range(allele_length_range)
+    allele_length_range(allele_length_range),
+    sample_callers({&snarl_caller}),
+    sample_names({sample_name})
 {
     for (int i = 0; i < ref_paths.size(); ++i) {
         ref_offsets[ref_paths[i]] = i < ref_path_offsets.size() ? ref_path_offsets[i] : 0;
@@ -1708,6 +1963,12 @@ FlowCaller::~FlowCaller() {
 
 }
 
+void FlowCaller::add_sample(SupportBasedSnarlCaller& sample_caller, const string& sample_name) {
+    assert(!gaf_output);
+    sample_callers.push_back(&sample_caller);
+    sample_names.push_back(sample_name);
+}
+
 bool FlowCaller::call_snarl(const Snarl& managed_snarl) {
 
     // todo: In order to experiment with merging consecutive snarls to make longer traversals,
@@ -1740,45 +2001,13 @@ bool FlowCaller::call_snarl(const Snarl& managed_snarl) {
         greedy_avg_flow = length > len_threshold;
     }
     
-    handle_t start_handle = graph.get_handle(snarl.start().node_id(), snarl.start().backward());
-    handle_t end_handle = graph.get_handle(snarl.end().node_id(), snarl.end().backward());
-
     // as we're writing to VCF, we need a reference path through the snarl.  we
     // look it up directly from the graph, and abort if we can't find one
-    set<string> start_path_names;
-    graph.for_each_step_on_handle(start_handle, [&](step_handle_t step_handle) {
-            string name = graph.get_path_name(graph.get_path_handle_of_step(step_handle));
-            if (!Paths::is_alt(name) && (ref_path_set.empty() || ref_path_set.count(name))) {
-                start_path_names.insert(name);
-            }
-            return true;
-        });
-    
-    set<string> end_path_names;
-    if (!start_path_names.empty()) {
-        graph.for_each_step_on_handle(end_handle, [&](step_handle_t step_handle) {
-                string name = graph.get_path_name(graph.get_path_handle_of_step(step_handle));
-                if (!Paths::is_alt(name) && (ref_path_set.empty() || ref_path_set.count(name))) {                
-                    end_path_names.insert(name);
-                }
-                return true;
-            });
-    }
-    
-    // we do the full intersection (instead of more quickly finding the first common path)
-    // so that we always take the lexicographically lowest path, rather than depending
-    // on the order of iteration which could change between implementations / runs.
-    vector<string> common_names;
-    std::set_intersection(start_path_names.begin(), start_path_names.end(),
-                          end_path_names.begin(), end_path_names.end(),
-                          std::back_inserter(common_names));
-
-    if (common_names.empty()) {
+    string ref_path_name = get_ref_path_name(graph, snarl, ref_path_set);
+    if (ref_path_name.empty()) {
         return false;
     }
 
-    string& ref_path_name = common_names.front();
-
     // find the reference traversal and coordinates using the path position graph interface
     tuple<int64_t, int64_t, bool, step_handle_t, step_handle_t> ref_interval = get_ref_interval(graph, snarl, ref_path_name);
     if (get<0>(ref_interval) == -1) {
@@ -1878,6 +2107,28 @@ bool FlowCaller::call_snarl(const Snarl& managed_snarl) {
         assert(gaf_output);
         pair<string, int64_t> pos_info = get_ref_position(graph, snarl, ref_path_name, ref_offsets[ref_path_name]);
         emit_gaf_traversals(graph, print_snarl(snarl), travs, ref_trav_idx, pos_info.first, pos_info.second, &support_finder);
+    } else if (sample_callers.size() > 1) {
+        // genotype every sample on the same traversals, and write them all out in one record
+        int ploidy = ref_ploidies[ref_path_name];
+        vector<vector<int>> sample_genotypes(sample_callers.size());
+        vector<unique_ptr<SnarlCaller::CallInfo>> sample_call_infos(sample_callers.size());
+        vector<const unique_ptr<SnarlCaller::CallInfo>*> sample_call_info_ptrs(sample_callers.size());
+        bool any_called = false;
+        for (size_t i = 0; i < sample_callers.size(); ++i) {
+            std::tie(sample_genotypes[i], sample_call_infos[i]) =
+                sample_callers[i]->genotype(snarl, travs, ref_trav_idx, ploidy, ref_path_name,
+                                            make_pair(get<0>(ref_interval), get<1>(ref_interval)));
+            assert(sample_genotypes[i].empty() || sample_genotypes[i].size() == ploidy);
+            sample_call_info_ptrs[i] = &sample_call_infos[i];
+            any_called = any_called || sample_genotypes[i].size() == ploidy;
+        }
+
+        bool added = emit_variant(graph, sample_callers, sample_names, snarl, travs, sample_genotypes, ref_trav_idx,
+                                  sample_call_info_ptrs, ref_path_name, ref_offsets[ref_path_name], genotype_snarls, ploidy);
+
+        // samples that couldn't be called just get missing genotypes: recursing on the children
+        // would call the site a second time for the samples that could
+        ret_val = any_called && added;
     } else {
         // use our support caller to choose our genotype
         vector<int> trav_genotype;
@@ -1903,14 +2154,23 @@ bool FlowCaller::call_snarl(const Snarl& managed_snarl) {
     return ret_val;
 }
 
+bool FlowCaller::get_output_position(const HandleGraph& graph, const Snarl& snarl, pair<string, size_t>& position) const {
+    return !gaf_output && get_vcf_position(this->graph, snarl, ref_path_set, ref_offsets, position);
+}
+
 string FlowCaller::vcf_header(const PathHandleGraph& graph, const vector<string>& contigs,
                               const vector<size_t>& contig_length_overrides) const {
     string header = VCFOutputCaller::vcf_header(graph, contigs, contig_length_overrides);
     header += "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n";
     snarl_caller.update_vcf_header(header);
     header += "##FILTER=<ID=PASS,Description=\"All filters passed\">\n";
-    header += "##SAMPLE=<ID=" + sample_name + ">\n";
-    header += "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\t" + sample_name;
+    for (const string& name : sample_names) {
+        header += "##SAMPLE=<ID=" + name + ">\n";
+    }
+    header += "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+    for (const string& name : sample_names) {
+        header += "\t" + name;
+    }
     assert(output_vcf.openForOutput(header));
     header += "\n";
     return header;
@@ -1981,50 +2241,14 @@ bool NestedFlowCaller::call_snarl_recursive(const Snarl& managed_snarl, int max_
     CallRecord& record = call_table[managed_snarl];
     
     // get some reference information if possible
-    // todo: make a function
-    
-    handle_t start_handle = graph.get_handle(snarl.start().node_id(), snarl.start().backward());
-    handle_t end_handle = graph.get_handle(snarl.end().node_id(), snarl.end().backward());
-
-    // as we're writing to VCF, we need a reference path through the snarl.  we
-    // look it up directly from the graph, and abort if we can't find one
-    set<string> start_path_names;
-    graph.for_each_step_on_handle(start_handle, [&](step_handle_t step_handle) {
-            string name = graph.get_path_name(graph.get_path_handle_of_step(step_handle));
-            if (!Paths::is_alt(name) && (ref_path_set.empty() || ref_path_set.count(name))) {
-                start_path_names.insert(name);
-            }
-            return true;
-        });
-    
-    set<string> end_path_names;
-    if (!start_path_names.empty()) {
-        graph.for_each_step_on_handle(end_handle, [&](step_handle_t step_handle) {
-                string name = graph.get_path_name(graph.get_path_handle_of_step(step_handle));
-                if (!Paths::is_alt(name) && (ref_path_set.empty() || ref_path_set.count(name))) {                
-                    end_path_names.insert(name);
-                }
-                return true;
-            });
-    }
-    
-    // we do the full intersection (instead of more quickly finding the first common path)
-    // so that we always take the lexicographically lowest path, rather than depending
-    // on the order of iteration which could change between implementations / runs.
-    vector<string> common_names;
-    std::set_intersection(start_path_names.begin(), start_path_names.end(),
-                          end_path_names.begin(), end_path_names.end(),
-                          std::back_inserter(common_names));
-
-    string ref_path_name;
+    string ref_path_name = get_ref_path_name(graph, snarl, ref_path_set);
     SnarlTraversal ref_trav;
     int ref_trav_idx = -1;
     tuple<int64_t, int64_t, bool, step_handle_t, step_handle_t> ref_interval;
     string gt_ref_path_name;
     pair<size_t, size_t> gt_ref_interval;
     
-    if (!common_names.empty()) {
-        ref_path_name = common_names.front();
+    if (!ref_path_name.empty()) {
 
         // find the reference traversal and coordinates using the path position graph interface
         ref_interval = get_ref_interval(graph, snarl, ref_path_name);
@@ -2364,6 +2588,10 @@ string NestedFlowCaller::flatten_alt_allele(const string& nested_allele, int all
 
 
 
+bool NestedFlowCaller::get_output_position(const HandleGraph& graph, const Snarl& snarl, pair<string, size_t>& position) const {
+    return !gaf_output && get_vcf_position(this->graph, snarl, ref_path_set, ref_offsets, position);
+}
+
 string NestedFlowCaller::vcf_header(const PathHandleGraph& graph, const vector<string>& contigs,
                               const vector<size_t>& contig_length_overrides) const {
     string header = VCFOutputCaller::vcf_header(graph, contigs, contig_length_overrides);
@@ -54,10 +54,33 @@ public:
     /// toggle progress messages
     void set_show_progress(bool show_progress);
 
+    /// Process the top-level snarls (or chains) in windows of this many, in the order of their
+    /// output positions (see get_output_position()).  Once a window and all its children are done,
+    /// finish_window is called with the position of the first snarl in the next window, or with
+    /// nullptr once there's nothing left that has a position.  0 processes everything in one go.
+    void set_window_size(size_t window_size, function<void(const pair<string, size_t>*)> finish_window);
+
 protected:
 
     /// Break up a chain into bits that we want to call using size heuristics
     vector<Chain> break_chain(const HandleGraph& graph, const Chain& chain, size_t max_edges, size_t max_trivial);
+
+    /// Get the position that a snarl's output will be sorted by. Output from the snarl (and its
+    /// children) must never sort before this position.  Returns false if there is no such position,
+    /// which is the default.
+    virtual bool get_output_position(const HandleGraph& graph, const Snarl& snarl, pair<string, size_t>& position) const;
+
+    /// Add a snarl and all its descendants to snarls
+    void add_snarl_tree(const Snarl* snarl, vector<const Snarl*>& snarls) const;
+
+    /// Run process_item on count top-level items in windows, sorted by the smallest output position of
+    /// the snarls that get_snarls gives for each (which must include all their descendants), and with
+    /// process_children run on the queued-up children after each window.  Items without a position
+    /// anywhere in their trees can't make any output, and go in the last window.
+    void call_in_windows(const HandleGraph& graph, size_t count,
+                         const function<void(size_t, vector<const Snarl*>&)>& get_snarls,
+                         const function<void(size_t)>& process_item,
+                         const function<void()>& process_children);
     
 protected:
 
@@ -69,6 +92,12 @@ protected:
 
     /// Toggle progress messages
     bool show_progress;
+
+    /// Number of top-level snarls (or chains) per window (0 = no windows)
+    size_t window_size = 0;
+
+    /// Called after each window is done
+    function<void(const pair<string, size_t>*)> finish_window;
 };
 
 /**
@@ -92,6 +121,13 @@ public:
     /// snarl_manager needed if include_nested is true
     void write_variants(ostream& out_stream, const SnarlManager* snarl_manager = nullptr);
 
+    /// Move the variants added since the last call into the reorder buffer, then write out
+    /// (and drop) all the buffered variants that sort before next_position, or all of them if
+    /// it's nullptr.  Used to stream output as windows of snarls are finished.
+    /// snarl_manager needed if include_nested is true
+    void flush_variants(ostream& out_stream, const pair<string, size_t>* next_position,
+                        const SnarlManager* snarl_manager = nullptr);
+
     /// Run vcffixup from vcflib
     void vcf_fixup(vcflib::Variant& var) const;
 
@@ -121,12 +157,32 @@ protected:
                       const string& ref_path_name, int ref_offset, bool genotype_snarls, int ploidy,
                       function<string(const vector<SnarlTraversal>&, const vector<int>&, int, int, int)> trav_to_string = nullptr);
 
+    /// print one multi-sample vcf variant, with a genotype (and caller and call info) for each of
+    /// the named samples.  the alleles are the union of those called in every sample
+    bool emit_variant(const PathPositionHandleGraph& graph, const vector<SnarlCaller*>& snarl_callers,
+                      const vector<string>& sample_names,
+                      const Snarl& snarl, const vector<SnarlTraversal>& called_traversals,
+                      const vector<vector<int>>& genotypes, int ref_trav_idx,
+                      const vector<const unique_ptr<SnarlCaller::CallInfo>*>& call_infos,
+                      const string& ref_path_name, int ref_offset, bool genotype_snarls, int ploidy,
+                      function<string(const vector<SnarlTraversal>&, const vector<int>&, int, int, int)> trav_to_string = nullptr);
+
     /// get the interval of a snarl from our reference path using the PathPositionHandleGraph interface
     /// the bool is true if the snarl's backward on the path
     /// first returned value -1 if no traversal found 
     tuple<int64_t, int64_t, bool, step_handle_t, step_handle_t> get_ref_interval(const PathPositionHandleGraph& graph, const Snarl& snarl,
                                                                                  const string& ref_path_name) const;
 
+    /// get the lexicographically lowest non-alt reference path (restricted to ref_path_set if
+    /// it's not empty) that touches both ends of the snarl. returns "" if there isn't one
+    string get_ref_path_name(const PathHandleGraph& graph, const Snarl& snarl, const unordered_set<string>& ref_path_set) const;
+
+    /// get the (contig, 1-based position) that emit_variant() would start a snarl's variant at before
+    /// any flattening, using the lexicographically lowest reference path through the snarl (as the
+    /// callers do). returns false if no reference path goes through it
+    bool get_vcf_position(const PathPositionHandleGraph& graph, const Snarl& snarl, const unordered_set<string>& ref_path_set,
+                          const map<string, size_t>& ref_offsets, pair<string, size_t>& position) const;
+
     /// used for making gaf traversal names
     pair<string, int64_t> get_ref_position(const PathPositionHandleGraph& graph, const Snarl& snarl, const string& ref_path_name,
                                            int64_t ref_path_offset) const;
@@ -160,6 +216,12 @@ protected:
     /// variants stored as strings (and position key pairs) because vcflib::Variant in-memory struct so huge
     mutable vector<vector<pair<pair<string, size_t>, string>>> output_variants;
 
+    /// sorted variants that have been flushed from output_variants but can't be written yet
+    vector<pair<pair<string, size_t>, string>> reorder_buffer;
+
+    /// snarl tree indexed by name (built on demand by update_nesting_info_tags)
+    unordered_map<string, const Snarl*> name_to_snarl;
+
     /// print up to this many uncalled alleles when doing ref-genotpes in -a mode
     size_t max_uncalled_alleles = 5;
 
@@ -397,8 +459,16 @@ public:
     virtual string vcf_header(const PathHandleGraph& graph, const vector<string>& contigs,
                               const vector<size_t>& contig_length_overrides = {}) const;
 
+    /// Genotype another sample (with its own support caller) alongside the one given to the constructor.
+    /// Each snarl's traversals are found once and then genotyped in every sample, and the VCF gets
+    /// one column per sample.  Not supported with GAF output
+    void add_sample(SupportBasedSnarlCaller& sample_caller, const string& sample_name);
+
 protected:
 
+    /// sort snarls by where their variants go in the VCF
+    virtual bool get_output_position(const HandleGraph& graph, const Snarl& snarl, pair<string, size_t>& position) const;
+
     /// the graph
     const PathPositionHandleGraph& graph;
 
@@ -438,6 +508,10 @@ protected:
     /// 1) its largest allele is >= allele_length_range.first and
     /// 2) all alleles are < allele_length_range.second
     pair<size_t, size_t> allele_length_range;
+
+    /// the support caller and name of each sample we genotype (the first ones are from the constructor)
+    vector<SnarlCaller*> sample_callers;
+    vector<string> sample_names;
 };
 
 class SnarlGraph;
@@ -476,6 +550,9 @@ public:
 
 protected:
 
+    /// sort snarls by where their variants go in the VCF
+    virtual bool get_output_position(const HandleGraph& graph, const Snarl& snarl, pair<string, size_t>& position) const;
+
     /// stuff we remember for each snarl call, to be used when genotyping its parent
     struct CallRecord {
         vector<SnarlTraversal> travs;
@@ -7,9 +7,12 @@
 #include <sstream>
 #include <vector>
 #include <map>
+#include <deque>
 #include <random>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <exception>
 #include <chrono>
 #include <cctype>
 #include <cstdio>
@@ -18,6 +21,7 @@
 #include <regex>
 #include <omp.h>
 #include <sys/stat.h>
+#include <sys/types.h>
 #include <sys/wait.h>
 
 #include <bdsg/hash_graph.hpp>
@@ -53,7 +57,9 @@
 #include "snarl_distance_index.hpp"
 #include "gfa.hpp"
 #include "job_schedule.hpp"
+#include "memusage.hpp"
 #include "path.hpp"
+#include "version.hpp"
 
 #include "io/save_handle_graph.hpp"
 
@@ -114,6 +120,7 @@ int IndexingParameters::downsample_threshold = 3;
 int IndexingParameters::downsample_context_length = gbwtgraph::PATH_COVER_DEFAULT_K;
 double IndexingParameters::max_memory_proportion = 0.75;
 double IndexingParameters::thread_chunk_inflation_factor = 2.0;
+int IndexingParameters::max_concurrent_recipes = 4;
 IndexingParameters::Verbosity IndexingParameters::verbosity = IndexingParameters::Basic;
 
 void copy_file(const string& from_fp, const string& to_fp) {
@@ -138,6 +145,15 @@ int64_t get_file_size(const string& filename) {
     return infile.tellg();
 }
 
+// return file modification time, or -1 if the file can't be accessed
+int64_t get_file_mtime(const string& filename) {
+    struct stat file_stat;
+    if (stat(filename.c_str(), &file_stat) != 0) {
+        return -1;
+    }
+    return file_stat.st_mtime;
+}
+
 bool is_gzipped(const string& filename) {
     if (filename.size() > 2 && filename.substr(filename.size() - 3, 3) == ".gz") {
         return true;
@@ -1777,7 +1793,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
                                                  approx_graph_load_memory(chunk_filename));
         }
         
-        JobSchedule schedule(approx_job_requirements, strip_chunk);
+        JobSchedule schedule(approx_job_requirements, strip_chunk, "strip-alt-paths");
         schedule.execute(plan->target_memory_usage());
         
         // return the filename(s)
@@ -2104,7 +2120,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
         
         // construct the jobs in parallel, trying to use multithreading while also
         // restraining memory usage
-        JobSchedule schedule(approx_job_requirements, make_graph);
+        JobSchedule schedule(approx_job_requirements, make_graph, "construct");
         schedule.execute(plan->target_memory_usage());
         
         // merge the ID spaces if we need to
@@ -2146,7 +2162,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
                 vg::io::save_handle_graph(graph.get(), outfile);
             };
             
-            JobSchedule schedule(approx_job_requirements, increment_node_ids);
+            JobSchedule schedule(approx_job_requirements, increment_node_ids, "increment-ids");
             schedule.execute(plan->target_memory_usage());
         }
         
@@ -2604,7 +2620,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
         
         {
             // Do all the GBWT jobs
-            JobSchedule schedule(approx_job_requirements, gbwt_job);
+            JobSchedule schedule(approx_job_requirements, gbwt_job, "gbwt");
             schedule.execute(target_memory_usage);
         }
         
@@ -2645,6 +2661,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
         return all_outputs;
     };
     
+    auto gbwt_recipe =
     registry.register_recipe({"GBWT"}, {"Chunked VCF w/ Phasing", "VG w/ Variant Paths"},
                              [make_gbwt](const vector<const IndexFile*>& inputs,
                                  const IndexingPlan* plan,
@@ -2660,6 +2677,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
         return make_gbwt(inputs, true, plan, constructing);
     });
     
+    auto spliced_gbwt_recipe =
     registry.register_recipe({"Spliced GBWT"}, {"Chunked VCF w/ Phasing", "Spliced VG w/ Variant Paths"},
                              [make_gbwt](const vector<const IndexFile*>& inputs,
                                  const IndexingPlan* plan,
@@ -2680,6 +2698,10 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
         return make_gbwt(inputs, false, plan, constructing);
     });
     
+    // these set the GBWT library's global verbosity
+    registry.register_exclusive(gbwt_recipe);
+    registry.register_exclusive(spliced_gbwt_recipe);
+    
     // Giraffe will prefer to use a downsampled haplotype GBWT if possible
     registry.register_recipe({"Giraffe GBWT"}, {"GBWT", "XG"},
                              [](const vector<const IndexFile*>& inputs,
@@ -3023,7 +3045,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
                                                  approx_graph_load_memory(graph_filenames[i]));
         }
         
-        JobSchedule schedule(approx_job_requirements, haplo_tx_job);
+        JobSchedule schedule(approx_job_requirements, haplo_tx_job, "haplo-tx-gbwt");
         schedule.execute(target_memory_usage);
         
         if (making_hsts) {
@@ -3280,6 +3302,14 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
     registry.register_generalization(vg_rna_gbz_full, vg_rna_gbz_graph_only);
     registry.register_generalization(vg_rna_gbz_liftover_full, vg_rna_gbz_liftover_graph_only);
     
+    // these set the GBWT library's global verbosity
+    registry.register_exclusive(vg_rna_graph_only);
+    registry.register_exclusive(vg_rna_full);
+    registry.register_exclusive(vg_rna_gbz_graph_only);
+    registry.register_exclusive(vg_rna_gbz_full);
+    registry.register_exclusive(vg_rna_gbz_liftover_graph_only);
+    registry.register_exclusive(vg_rna_gbz_liftover_full);
+    
     ////////////////////////////////////
     // Info Table Recipes
     ////////////////////////////////////
@@ -3405,7 +3435,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
         
         mutex unfold_lock;
         
-        auto prune_job = [&](int64_t i) {
+        auto prune_job = [&](int64_t i, int64_t job_memory_budget, int job_threads) {
             ifstream infile_vg;
             init_in(infile_vg, graph_names[i]);
             
@@ -3461,13 +3491,17 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
                 else {
                     // we can expand out complex regions using haplotypes as well as paths
                     
-                    // TODO: can't do this fully in parallel because each chunk needs to modify
-                    // the same mapping
+                    // the components can be unfolded in parallel, but each chunk needs to
+                    // modify the same mapping when the unfolded nodes get their IDs
                     // TODO: it's a bit inelegant that i keep overwriting the mapping...
                     PhaseUnfolder unfolder(*unpruned_graph, *gbwt_index, max_node_id + 1);
+                    bool show_progress = IndexingParameters::verbosity >= IndexingParameters::Debug;
+                    // stay within the resources that the prune schedule granted this job
+                    auto unfolded_components = unfolder.unfold_components(*graph, show_progress,
+                                                                          job_memory_budget, job_threads);
                     unfold_lock.lock();
                     unfolder.read_mapping(mapping_name);
-                    unfolder.unfold(*graph, IndexingParameters::verbosity >= IndexingParameters::Debug);
+                    unfolder.merge_components(unfolded_components, *graph, show_progress);
                     unfolder.write_mapping(mapping_name);
                     unfold_lock.unlock();
                 }
@@ -3491,7 +3525,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
                                                  (using_haplotypes ? 1 : 2) * approx_graph_load_memory(graph_names[i]));
         }
         
-        JobSchedule schedule(approx_job_requirements, prune_job);
+        JobSchedule schedule(approx_job_requirements, prune_job, "prune");
         schedule.execute(target_memory_usage);
         
         return all_outputs;
@@ -3683,6 +3717,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
         return all_outputs;
     };
     
+    auto gcsa_haplotype_pruned_recipe =
     registry.register_recipe({"GCSA", "LCP"}, {"Haplotype-Pruned VG", "Unfolded NodeMapping"},
                              [construct_gcsa](const vector<const IndexFile*>& inputs,
                                  const IndexingPlan* plan,
@@ -3692,6 +3727,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
         return construct_gcsa(inputs, plan, constructing);
     });
     
+    auto gcsa_pruned_recipe =
     registry.register_recipe({"GCSA", "LCP"}, {"Pruned VG"},
                              [construct_gcsa](const vector<const IndexFile*>& inputs,
                                  const IndexingPlan* plan,
@@ -3701,6 +3737,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
         return construct_gcsa(inputs, plan, constructing);
     });
     
+    auto spliced_gcsa_haplotype_pruned_recipe =
     registry.register_recipe({"Spliced GCSA", "Spliced LCP"}, {"Haplotype-Pruned Spliced VG", "Unfolded Spliced NodeMapping"},
                              [construct_gcsa](const vector<const IndexFile*>& inputs,
                                  const IndexingPlan* plan,
@@ -3710,6 +3747,7 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
         return construct_gcsa(inputs, plan, constructing);
     });
     
+    auto spliced_gcsa_pruned_recipe =
     registry.register_recipe({"Spliced GCSA", "Spliced LCP"}, {"Pruned Spliced VG"},
                              [construct_gcsa](const vector<const IndexFile*>& inputs,
                                  const IndexingPlan* plan,
@@ -3719,6 +3757,13 @@ IndexRegistry VGIndexes::get_vg_index_registry() {
         return construct_gcsa(inputs, plan, constructing);
     });
     
+    // these set the GCSA library's global verbosity, and they change the pruning parameters
+    // when they rewind the plan
+    registry.register_exclusive(gcsa_haplotype_pruned_recipe);
+    registry.register_exclusive(gcsa_pruned_recipe);
+    registry.register_exclusive(spliced_gcsa_haplotype_pruned_recipe);
+    registry.register_exclusive(spliced_gcsa_pruned_recipe);
+    
     ////////////////////////////////////
     // Snarls Recipes
     ////////////////////////////////////
@@ -4167,11 +4212,15 @@ bool IndexingPlan::is_intermediate(const IndexName& identifier) const {
 }
 
 int64_t IndexingPlan::target_memory_usage() const {
-    return IndexingParameters::max_memory_proportion * registry->get_target_memory_usage();
+    return IndexingParameters::max_memory_proportion * literal_target_memory_usage();
 }
 
 int64_t IndexingPlan::literal_target_memory_usage() const {
-    return registry->get_target_memory_usage();
+    if (memory_fraction >= 1.0) {
+        // avoid overflowing the default of no limit
+        return registry->get_target_memory_usage();
+    }
+    return memory_fraction * registry->get_target_memory_usage();
 }
     
 string IndexingPlan::output_filepath(const IndexName& identifier) const {
@@ -4246,7 +4295,10 @@ IndexRegistry::IndexRegistry(IndexRegistry&& other) :
     registered_suffixes(std::move(other.registered_suffixes)),
     work_dir(std::move(other.work_dir)),
     output_prefix(std::move(other.output_prefix)),
-    keep_intermediates(std::move(other.keep_intermediates)) {
+    keep_intermediates(std::move(other.keep_intermediates)),
+    cache_dir(std::move(other.cache_dir)),
+    target_memory_usage(other.target_memory_usage),
+    recipe_reports(std::move(other.recipe_reports)) {
     
     // Make sure other doesn't delete our work dir when it goes away
     other.work_dir.clear();
@@ -4259,6 +4311,9 @@ IndexRegistry& IndexRegistry::operator=(IndexRegistry&& other) {
     work_dir = std::move(other.work_dir);
     output_prefix = std::move(other.output_prefix);
     keep_intermediates = std::move(other.keep_intermediates);
+    cache_dir = std::move(other.cache_dir);
+    target_memory_usage = other.target_memory_usage;
+    recipe_reports = std::move(other.recipe_reports);
     
     // Make sure other doesn't delete our work dir when it goes away
     other.work_dir.clear();
@@ -4287,63 +4342,257 @@ void IndexRegistry::make_indexes(const vector<IndexName>& identifiers) {
     // to keep track of which indexes are aliases of others
     AliasGraph alias_graph;
     
-    list<RecipeName> steps_remaining(plan.get_steps().begin(), plan.get_steps().end());
-    list<RecipeName> steps_completed;
+    const auto& steps = plan.get_steps();
+    
+    // the earlier steps that create the inputs of each step
+    vector<vector<size_t>> step_dependencies(steps.size());
+    map<RecipeName, size_t> step_index;
+    for (size_t i = 0; i < steps.size(); ++i) {
+        step_index[steps[i]] = i;
+        auto inputs = get_recipe(steps[i]).input_group();
+        for (size_t j = 0; j < i; ++j) {
+            for (const auto& output : steps[j].first) {
+                if (inputs.count(output)) {
+                    step_dependencies[i].push_back(j);
+                    break;
+                }
+            }
+        }
+    }
+    
+    // make sure the work directory exists before any recipes start asking for it concurrently
+    get_work_dir();
+    
+    recipe_reports.clear();
+    
+    // the resources available to divide between concurrent recipes
+    const int total_threads = get_thread_count();
+    int free_threads = total_threads;
+    double free_memory_fraction = 1.0;
+    size_t max_concurrent = max(IndexingParameters::max_concurrent_recipes, 1);
+    
+    struct RunningStep {
+        thread worker;
+        int num_threads;
+        double memory_fraction;
+        chrono::time_point<chrono::steady_clock> start_time;
+        size_t peak_rss_kb;
+    };
+    map<size_t, RunningStep> running;
+    vector<bool> completed(steps.size(), false);
+    
+    // results passed back from the worker threads
+    mutex results_mutex;
+    condition_variable results_cv;
+    deque<size_t> finished;
+    vector<vector<vector<string>>> step_results(steps.size());
+    vector<exception_ptr> step_errors(steps.size());
+    
+    // the cache keys of each step, and of the indexes they construct
+    vector<string> step_cache_keys(steps.size());
+    map<IndexName, string> index_cache_keys;
+    
+    // set when a recipe fails, so that we stop launching recipes and let the others finish
+    bool draining = false;
+    vector<exception_ptr> errors;
     
     // execute the plan
-    while (!steps_remaining.empty()) {
-        // get the next step
-        auto step = move(steps_remaining.front());
-        steps_remaining.pop_front();
-        steps_completed.push_back(step);
+    while (true) {
         
-        // do the recipe
-        try {
-            auto recipe_results = execute_recipe(step, &plan, alias_graph);
+        bool exclusive_running = false;
+        for (const auto& running_record : running) {
+            exclusive_running = exclusive_running || get_recipe(steps[running_record.first]).exclusive;
+        }
+        
+        if (!draining && !exclusive_running && free_threads > 0 && running.size() < max_concurrent) {
+            // find the steps whose inputs are all finished
+            vector<size_t> ready;
+            for (size_t i = 0; i < steps.size(); ++i) {
+                if (completed[i] || running.count(i)) {
+                    continue;
+                }
+                bool inputs_finished = true;
+                for (size_t j : step_dependencies[i]) {
+                    inputs_finished = inputs_finished && completed[j];
+                }
+                if (inputs_finished) {
+                    ready.push_back(i);
+                }
+            }
             
-            // the recipe executed successfully
-            assert(recipe_results.size() == step.first.size());
+            // recipes that modify global state are executed alone, once the others have finished
+            auto exclusive_step = find_if(ready.begin(), ready.end(), [&](size_t i) {
+                return get_recipe(steps[i]).exclusive;
+            });
+            if (exclusive_step != ready.end()) {
+                if (running.empty()) {
+                    ready = vector<size_t>(1, *exclusive_step);
+                }
+                else {
+                    ready.clear();
+                }
+            }
             
-            // record the results
-            auto it = step.first.begin();
-            for (const auto& results : recipe_results) {
-                auto index = get_index(*it);
-                // don't overwrite directly-provided inputs
-                if (!index->was_provided_directly()) {
-                    // and assign the new (or first) ones
-                    index->assign_constructed(results);
+            // launch as many as we can, dividing the free resources evenly between them
+            size_t num_to_launch = min(ready.size(), min<size_t>(max_concurrent - running.size(), free_threads));
+            for (size_t k = 0; k < num_to_launch; ++k) {
+                size_t i = ready[k];
+                
+                auto& running_step = running[i];
+                running_step.num_threads = free_threads / (num_to_launch - k);
+                running_step.memory_fraction = free_memory_fraction / (num_to_launch - k);
+                running_step.start_time = chrono::steady_clock::now();
+                running_step.peak_rss_kb = get_current_rss_kb();
+                free_threads -= running_step.num_threads;
+                free_memory_fraction -= running_step.memory_fraction;
+                
+                IndexingPlan step_plan = plan;
+                step_plan.memory_fraction = running_step.memory_fraction;
+                
+#ifdef debug_index_registry
+                cerr << "launching recipe for " << to_string(steps[i].first) << " with " << running_step.num_threads << " threads and " << running_step.memory_fraction << " of the memory target" << endl;
+#endif
+                
+                // the key the step's outputs are cached under, if we're caching
+                string cache_key;
+                if (!cache_dir.empty()) {
+                    cache_key = recipe_cache_key(steps[i], index_cache_keys);
+                    step_cache_keys[i] = cache_key;
                 }
-                ++it;
+                
+                int num_threads = running_step.num_threads;
+                running_step.worker = thread([&, i, num_threads, step_plan, cache_key]() {
+                    // OpenMP settings do not carry over into new threads
+                    omp_set_num_threads(num_threads);
+                    vector<vector<string>> recipe_results;
+                    exception_ptr error;
+                    try {
+                        if (cache_key.empty() || !restore_cached_recipe(steps[i], &step_plan, cache_key, recipe_results)) {
+                            recipe_results = execute_recipe(steps[i], &step_plan, alias_graph);
+                            if (!cache_key.empty()) {
+                                cache_recipe(steps[i], cache_key, recipe_results);
+                            }
+                        }
+                    }
+                    catch (...) {
+                        error = current_exception();
+                    }
+                    lock_guard<mutex> lock(results_mutex);
+                    step_results[i] = std::move(recipe_results);
+                    step_errors[i] = error;
+                    finished.push_back(i);
+                    results_cv.notify_one();
+                });
             }
         }
-        catch (RewindPlanException& ex) {
-            
-            // the recipe failed, but we can rewind and retry following the recipe with
-            // modified parameters (which should have been set by the exception-throwing code)
-            if (IndexingParameters::verbosity != IndexingParameters::None) {
-                cerr << ex.what() << endl;
-            }
-            // gather the recipes we're going to need to re-attempt
-            const auto& rewinding_indexes = ex.get_indexes();
-            set<RecipeName> dependent_recipes;
-            for (const auto& index_name : rewinding_indexes) {
-                assert(index_registry.count(index_name));
-                for (const auto& recipe : plan.dependents(index_name)) {
-                    dependent_recipes.insert(recipe);
+        
+        if (running.empty()) {
+            if (!errors.empty()) {
+                // everything has stopped, now we can deal with the failures
+                for (auto& error : errors) {
+                    try {
+                        rethrow_exception(error);
+                    }
+                    catch (RewindPlanException& ex) {
+                        
+                        // the recipe failed, but we can rewind and retry following the recipe with
+                        // modified parameters (which should have been set by the exception-throwing code)
+                        if (IndexingParameters::verbosity != IndexingParameters::None) {
+                            cerr << ex.what() << endl;
+                        }
+                        // mark the recipes we're going to need to re-attempt as incomplete
+                        for (const auto& index_name : ex.get_indexes()) {
+                            assert(index_registry.count(index_name));
+                            for (const auto& recipe : plan.dependents(index_name)) {
+                                completed[step_index.at(recipe)] = false;
+                            }
+                        }
+                    }
                 }
+                errors.clear();
+                draining = false;
+                continue;
             }
-            
-            // move rewound steps back onto the queue
-            vector<list<RecipeName>::iterator> to_move;
-            for (auto it = steps_completed.rbegin(); it != steps_completed.rend(); ++it) {
-                if (dependent_recipes.count(*it)) {
-                    to_move.push_back(--it.base());
+            if (find(completed.begin(), completed.end(), false) == completed.end()) {
+                break;
+            }
+            // the steps are topologically ordered, so something should always be ready
+            cerr << "error:[IndexRegistry] no recipes can be executed in the plan" << endl;
+            exit(1);
+        }
+        
+        // wait for a recipe to finish, keeping track of the memory high water mark in the meantime
+        vector<size_t> newly_finished;
+        {
+            unique_lock<mutex> lock(results_mutex);
+            while (finished.empty()) {
+                results_cv.wait_for(lock, chrono::milliseconds(100));
+                size_t rss_kb = get_current_rss_kb();
+                for (auto& running_step : running) {
+                    running_step.second.peak_rss_kb = max(running_step.second.peak_rss_kb, rss_kb);
                 }
             }
-            for (auto& it : to_move) {
-                steps_remaining.emplace_front(*it);
-                steps_completed.erase(it);
+            newly_finished.assign(finished.begin(), finished.end());
+            finished.clear();
+        }
+        
+        for (size_t i : newly_finished) {
+            auto& running_step = running.at(i);
+            running_step.worker.join();
+            
+            free_threads += running_step.num_threads;
+            free_memory_fraction += running_step.memory_fraction;
+            
+            if (step_errors[i]) {
+                // something went wrong, stop launching new recipes until we've handled it
+                errors.push_back(step_errors[i]);
+                step_errors[i] = nullptr;
+                draining = true;
             }
+            else {
+                // the recipe executed successfully
+                const auto& step = steps[i];
+                auto& recipe_results = step_results[i];
+                assert(recipe_results.size() == step.first.size());
+                
+                // record the results
+                auto it = step.first.begin();
+                for (const auto& results : recipe_results) {
+                    auto index = get_index(*it);
+                    // don't overwrite directly-provided inputs
+                    if (!index->was_provided_directly()) {
+                        // and assign the new (or first) ones
+                        index->assign_constructed(results);
+                    }
+                    ++it;
+                }
+                recipe_results.clear();
+                completed[i] = true;
+                
+                if (!step_cache_keys[i].empty()) {
+                    // later recipes identify these outputs by the recipe that made them
+                    for (const auto& output : step.first) {
+                        index_cache_keys[output] = sha1sum(step_cache_keys[i] + "\t" + output);
+                    }
+                }
+                
+                RecipeReport report;
+                report.recipe = step;
+                report.wall_time_seconds = chrono::duration<double>(chrono::steady_clock::now() - running_step.start_time).count();
+                report.peak_rss_kb = max(running_step.peak_rss_kb, get_current_rss_kb());
+                report.num_threads = running_step.num_threads;
+                IndexingPlan step_plan = plan;
+                step_plan.memory_fraction = running_step.memory_fraction;
+                report.memory_budget = step_plan.literal_target_memory_usage();
+                recipe_reports.push_back(report);
+                
+                if (IndexingParameters::verbosity >= IndexingParameters::Basic) {
+                    cerr << "[IndexRegistry]: Finished " << to_string(step.first) << " in " << report.wall_time_seconds
+                         << " s using " << report.num_threads << " thread" << (report.num_threads == 1 ? "" : "s")
+                         << ", peak RSS " << report.peak_rss_kb / 1024 << " MB." << endl;
+                }
+            }
+            running.erase(i);
         }
     }
 #ifdef debug_index_registry
@@ -4401,6 +4650,176 @@ void IndexRegistry::make_indexes(const vector<IndexName>& identifiers) {
     // different set of indexes, you will need to call reset() yourself.
 }
 
+const vector<IndexRegistry::RecipeReport>& IndexRegistry::get_recipe_reports() const {
+    return recipe_reports;
+}
+
+void IndexRegistry::set_cache_dir(const string& dir) {
+    if (!dir.empty() && mkdir(dir.c_str(), 0777) != 0 && errno != EEXIST) {
+        cerr << "error:[IndexRegistry] could not create cache directory " << dir << endl;
+        exit(1);
+    }
+    cache_dir = dir;
+}
+
+/// Describe all of the parameters that can change the contents of an index
+static string indexing_parameters_fingerprint() {
+    stringstream strm;
+    strm << (int) IndexingParameters::mut_graph_impl << '\t'
+         << IndexingParameters::max_node_size << '\t'
+         << IndexingParameters::pruning_max_node_degree << '\t'
+         << IndexingParameters::pruning_walk_length << '\t'
+         << IndexingParameters::pruning_max_edge_count << '\t'
+         << IndexingParameters::pruning_min_component_size << '\t'
+         << IndexingParameters::gcsa_initial_kmer_length << '\t'
+         << IndexingParameters::gcsa_doubling_steps << '\t'
+         << IndexingParameters::gbwt_insert_batch_size << '\t'
+         << IndexingParameters::gbwt_sampling_interval << '\t'
+         << IndexingParameters::bidirectional_haplo_tx_gbwt << '\t'
+         << IndexingParameters::gff_feature_name << '\t'
+         << IndexingParameters::gff_transcript_tag << '\t'
+         << IndexingParameters::use_bounded_syncmers << '\t'
+         << IndexingParameters::minimizer_k << '\t'
+         << IndexingParameters::minimizer_w << '\t'
+         << IndexingParameters::minimizer_s << '\t'
+         << IndexingParameters::path_cover_depth << '\t'
+         << IndexingParameters::giraffe_gbwt_downsample << '\t'
+         << IndexingParameters::downsample_context_length << '\t'
+         << IndexingParameters::downsample_threshold << '\t'
+         << IndexingParameters::thread_chunk_inflation_factor;
+    return strm.str();
+}
+
+string IndexRegistry::recipe_cache_key(const RecipeName& recipe_name,
+                                       const map<IndexName, string>& index_cache_keys) const {
+    stringstream strm;
+    // a different build of vg might construct the indexes differently
+    strm << Version::get_long() << '\n';
+    strm << to_string(recipe_name.first) << '\t' << recipe_name.second << '\n';
+    for (const IndexFile* input : get_recipe(recipe_name).inputs) {
+        strm << input->get_identifier() << '\t';
+        auto it = index_cache_keys.find(input->get_identifier());
+        if (it != index_cache_keys.end()) {
+            // we made this index, so we know what it was made from
+            strm << it->second;
+        }
+        else {
+            // identify input files by their path, size, and modification time rather than
+            // hashing (possibly enormous) contents
+            for (const auto& filename : input->get_filenames()) {
+                struct stat file_stat;
+                strm << filename << ':';
+                if (stat(filename.c_str(), &file_stat) == 0) {
+                    strm << file_stat.st_size << ':' << file_stat.st_mtime;
+                }
+                strm << ';';
+            }
+        }
+        strm << '\n';
+    }
+    strm << indexing_parameters_fingerprint();
+    return sha1sum(strm.str());
+}
+
+bool IndexRegistry::restore_cached_recipe(const RecipeName& recipe_name, const IndexingPlan* plan,
+                                          const string& key, vector<vector<string>>& results_out) const {
+    
+    string entry_dir = cache_dir + "/" + key;
+    ifstream manifest(entry_dir + "/manifest.tsv");
+    if (!manifest) {
+        return false;
+    }
+    
+    // the recorded sizes and modification times of each output's files
+    map<IndexName, vector<pair<int64_t, int64_t>>> file_stats;
+    string line;
+    while (getline(manifest, line)) {
+        stringstream strm(line);
+        string identifier;
+        int64_t size, mtime;
+        if (getline(strm, identifier, '\t') && (strm >> size >> mtime)) {
+            file_stats[identifier].emplace_back(size, mtime);
+        }
+    }
+    
+    // make sure the entry is complete and unmodified before we use any of it
+    for (const auto& output : recipe_name.first) {
+        if (!file_stats.count(output)) {
+            return false;
+        }
+        const auto& stats = file_stats[output];
+        for (size_t j = 0; j < stats.size(); ++j) {
+            string cached_filename = entry_dir + "/" + sha1sum(output) + "." + std::to_string(j);
+            if (get_file_size(cached_filename) != stats[j].first
+                || get_file_mtime(cached_filename) != stats[j].second) {
+                return false;
+            }
+        }
+    }
+    
+    if (IndexingParameters::verbosity >= IndexingParameters::Basic) {
+        cerr << "[IndexRegistry]: Restoring " << to_string(recipe_name.first) << " from cache." << endl;
+    }
+    
+    results_out.clear();
+    for (const auto& output : recipe_name.first) {
+        results_out.emplace_back();
+        size_t num_files = file_stats[output].size();
+        for (size_t j = 0; j < num_files; ++j) {
+            string cached_filename = entry_dir + "/" + sha1sum(output) + "." + std::to_string(j);
+            string filename = plan->output_filepath(output, j, num_files);
+            // note: we copy rather than hard link so that later runs that overwrite
+            // this output can't modify the cache
+            copy_file(cached_filename, filename);
+            results_out.back().push_back(filename);
+        }
+    }
+    return true;
+}
+
+void IndexRegistry::cache_recipe(const RecipeName& recipe_name, const string& key,
+                                 const vector<vector<string>>& results) const {
+    
+    // recipes that only alias their inputs are cheap to redo, and we don't want copies of the inputs
+    const auto& recipe = get_recipe(recipe_name);
+    for (const IndexFile* input : recipe.inputs) {
+        for (const auto& input_filename : input->get_filenames()) {
+            for (const auto& output_filenames : results) {
+                if (find(output_filenames.begin(), output_filenames.end(), input_filename) != output_filenames.end()) {
+                    return;
+                }
+            }
+        }
+    }
+    
+    string entry_dir = cache_dir + "/" + key;
+    if (mkdir(entry_dir.c_str(), 0777) != 0 && errno != EEXIST) {
+        cerr << "warning:[IndexRegistry] could not create cache entry " << entry_dir << endl;
+        return;
+    }
+    
+    stringstream manifest;
+    auto it = recipe_name.first.begin();
+    for (const auto& output_filenames : results) {
+        for (size_t j = 0; j < output_filenames.size(); ++j) {
+            string cached_filename = entry_dir + "/" + sha1sum(*it) + "." + std::to_string(j);
+            copy_file(output_filenames[j], cached_filename);
+            manifest << *it << '\t' << get_file_size(cached_filename) << '\t' << get_file_mtime(cached_filename) << '\n';
+        }
+        ++it;
+    }
+    
+    // the manifest goes in last, so that it only exists for complete entries
+    string manifest_filename = entry_dir + "/manifest.tsv";
+    {
+        ofstream manifest_file(manifest_filename + ".tmp");
+        manifest_file << manifest.str();
+    }
+    if (rename((manifest_filename + ".tmp").c_str(), manifest_filename.c_str()) != 0) {
+        cerr << "warning:[IndexRegistry] could not write cache manifest " << manifest_filename << endl;
+    }
+}
+
 void IndexRegistry::register_index(const IndexName& identifier, const string& suffix) {
     // Add this index to the registry
     if (identifier.empty()) {
@@ -4602,6 +5021,10 @@ void IndexRegistry::register_generalization(const RecipeName& generalizer, const
     generalizations[generalizee] = generalizer;
 }
 
+void IndexRegistry::register_exclusive(const RecipeName& recipe) {
+    recipe_registry.at(recipe.first).at(recipe.second).exclusive = true;
+}
+
 IndexFile* IndexRegistry::get_index(const IndexName& identifier) {
     return index_registry.at(identifier).get();
 }
@@ -5473,7 +5896,7 @@ void IndexFile::reset() {
 
 IndexRecipe::IndexRecipe(const vector<const IndexFile*>& inputs,
                          const RecipeFunc& exec) :
-    exec(exec), inputs(inputs)
+    exec(exec), inputs(inputs), exclusive(false)
 {
     // nothing more to do
 }
@@ -5493,6 +5916,7 @@ IndexGroup IndexRecipe::input_group() const {
 
 void AliasGraph::register_alias(const IndexName& aliasor, const IndexFile* aliasee) {
     assert(aliasee->get_identifier() != aliasor);
+    lock_guard<mutex> lock(graph_mutex);
     graph[aliasee->get_identifier()].emplace_back(aliasor);
 }
 
@@ -11,6 +11,7 @@
 #include <memory>
 #include <stdexcept>
 #include <limits>
+#include <mutex>
 
 namespace vg {
 
@@ -114,6 +115,8 @@ struct IndexingParameters {
     static double max_memory_proportion;
     // aim to have X timese as many chunks as threads [2]
     static double thread_chunk_inflation_factor;
+    // the maximum number of independent recipes that will be executed at the same time [4]
+    static int max_concurrent_recipes;
     // whether indexing algorithms will log progress (if available) [Basic]
     static Verbosity verbosity;
 };
@@ -172,6 +175,10 @@ public:
     
 protected:
     
+    /// The fraction of the registry's memory target that this plan's recipes may use. Less than
+    /// 1 when the recipe shares the memory budget with others executing concurrently.
+    double memory_fraction = 1.0;
+    
     /// The steps to be invoked in the plan. May be empty before the plan is
     /// actually planned.
     vector<RecipeName> steps;
@@ -235,6 +242,10 @@ public:
     /// by the generalization must be semantically identical to those of the generalizee
     void register_generalization(const RecipeName& generalizer, const RecipeName& generalizee);
     
+    /// Indicate that a recipe modifies global state (e.g. a library's verbosity or the
+    /// IndexingParameters), so it must not be executed concurrently with any other recipe
+    void register_exclusive(const RecipeName& recipe);
+    
     /// Indicate a serialized file that contains some identified index
     void provide(const IndexName& identifier, const string& filename);
     
@@ -266,8 +277,31 @@ public:
     /// If provided inputs cannot create the desired indexes, throws a
     /// InsufficientInputException.
     /// When completed, all requested index files will be available via require().
+    /// Recipes whose inputs are all finished are executed concurrently (up to
+    /// IndexingParameters::max_concurrent_recipes), dividing the threads and memory target.
+    /// Exclusive recipes are executed alone.
     void make_indexes(const vector<IndexName>& identifiers);
     
+    /// The resources used by a recipe executed in make_indexes
+    struct RecipeReport {
+        RecipeName recipe;
+        double wall_time_seconds;
+        /// The peak RSS of the whole process while the recipe was executing
+        size_t peak_rss_kb;
+        int num_threads;
+        int64_t memory_budget;
+    };
+    
+    /// Get the resources used by each recipe executed by the most recent make_indexes,
+    /// in the order they finished
+    const vector<RecipeReport>& get_recipe_reports() const;
+    
+    /// Keep the outputs of recipes in a persistent directory, keyed on the recipe, its
+    /// inputs, the indexing parameters, and the build of vg. Recipes whose outputs are
+    /// already there (with their recorded sizes and modification times) are restored
+    /// instead of executed.
+    void set_cache_dir(const string& dir);
+    
     /// Returns the recipe graph in dot format
     string to_dot() const;
     
@@ -299,6 +333,20 @@ protected:
     vector<vector<string>> execute_recipe(const RecipeName& recipe_name, const IndexingPlan* plan,
                                           AliasGraph& alias_graph);
     
+    /// Get the key that identifies the outputs of a recipe in the cache, given the keys of
+    /// the indexes that were constructed so far
+    string recipe_cache_key(const RecipeName& recipe_name,
+                            const map<IndexName, string>& index_cache_keys) const;
+    
+    /// Copy a recipe's outputs out of the cache into the plan, if they are there. Returns
+    /// true if successful.
+    bool restore_cached_recipe(const RecipeName& recipe_name, const IndexingPlan* plan,
+                               const string& key, vector<vector<string>>& results_out) const;
+    
+    /// Add a recipe's outputs to the cache
+    void cache_recipe(const RecipeName& recipe_name, const string& key,
+                      const vector<vector<string>>& results) const;
+    
     /// access index file
     IndexFile* get_index(const IndexName& identifier);
     
@@ -333,8 +381,14 @@ protected:
     /// should intermediate files end up in the scratch or the output directory?
     bool keep_intermediates = false;
     
+    /// persistent directory for recipe outputs, or empty for no caching
+    string cache_dir;
+    
     /// the max memory we will *attempt* to use
     int64_t target_memory_usage = numeric_limits<int64_t>::max();
+    
+    /// the resources used by the recipes in the most recent make_indexes
+    vector<RecipeReport> recipe_reports;
 };
 
 /**
@@ -397,6 +451,8 @@ struct IndexRecipe {
     IndexGroup input_group() const;
     vector<const IndexFile*> inputs;
     RecipeFunc exec;
+    // must be executed without any other recipes running
+    bool exclusive;
 };
 
 /**
@@ -421,6 +477,9 @@ private:
     // graph aliasees to their aliasors
     unordered_map<IndexName, vector<IndexName>> graph;
     
+    // recipes may register aliases concurrently
+    mutex graph_mutex;
+    
 };
 
 
@@ -7,19 +7,46 @@
 #include <chrono>
 #include <mutex>
 #include <atomic>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <cstdio>
+#include <omp.h>
 
 #include "utility.hpp"
+#include "memusage.hpp"
+
+//#define debug_job_schedule
 
 namespace vg {
 
 using namespace std;
 
+string JobSchedule::cost_cache_filename = "";
+mutex JobSchedule::cost_cache_mutex;
+atomic<int64_t> JobSchedule::num_executing(0);
+atomic<int64_t> JobSchedule::num_started(0);
+
+JobSchedule::JobSchedule(const vector<pair<int64_t, int64_t>>& job_requirements,
+                         const function<void(int64_t)>& job_func,
+                         const string& cost_model_name)
+    : JobSchedule(job_requirements, [job_func](int64_t i, int64_t memory_budget, int num_threads) { job_func(i); },
+                  cost_model_name)
+{
+    // nothing more to do
+}
+
 JobSchedule::JobSchedule(const vector<pair<int64_t, int64_t>>& job_requirements,
-                         const function<void(int64_t)>& job_func)
-    : job_func(job_func)
+                         const function<void(int64_t, int64_t, int)>& job_func,
+                         const string& cost_model_name)
+    : job_func(job_func), cost_model_name(cost_model_name)
 {
+    if (!cost_model_name.empty()) {
+        cost_ratio = cached_cost_ratio(cost_model_name);
+    }
     for (int64_t i = 0; i < job_requirements.size(); ++i) {
-        queue.emplace_back(job_requirements[i].second, i);
+        queue.emplace_back(job_requirements[i].second * cost_ratio, i);
     }
     // sort in decreasing order by time required
     queue.sort([&](const pair<int64_t, int64_t>& a,
@@ -28,14 +55,55 @@ JobSchedule::JobSchedule(const vector<pair<int64_t, int64_t>>& job_requirements,
     });
 }
 
-void JobSchedule::execute(int64_t target_memory_usage) {
+list<pair<int64_t, int64_t>>::const_iterator JobSchedule::next_job(const list<pair<int64_t, int64_t>>& queue,
+                                                                   int64_t est_memory_usage,
+                                                                   int64_t measured_memory_usage,
+                                                                   int64_t target_memory_usage) {
+    if (est_memory_usage == 0) {
+        // even if we don't have the memory budget to do this job, we're
+        // going to have to at some point and the memory situation will
+        // never get any better than this
+        return queue.begin();
+    }
+    // find the longest-running job that can be done with the available
+    // memory budget, according to both the estimates and the measurements
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if (it->first + est_memory_usage <= target_memory_usage &&
+            it->first + measured_memory_usage <= target_memory_usage) {
+            return it;
+        }
+    }
+    return queue.end();
+}
+
+void JobSchedule::execute(int64_t target_memory_usage, int num_threads) {
+    
+    // other schedules that execute while this one does will show up in our measurements
+    int64_t started_count = num_started.fetch_add(1) + 1;
+    bool overlapped = num_executing.fetch_add(1) > 0;
     
     atomic<int64_t> est_memory_usage(0);
+    // the memory the process has acquired since the schedule started
+    int64_t baseline_memory_usage = get_current_rss_kb() * 1024;
+    atomic<int64_t> measured_memory_usage(0);
+    // high water marks, to compare the estimates to reality
+    int64_t peak_est_memory_usage = 0;
+    int64_t peak_measured_memory_usage = 0;
+    
     mutex queue_lock;
-    int num_threads = get_thread_count();
+    if (num_threads <= 0) {
+        num_threads = get_thread_count();
+    }
+    // divide the resources between the jobs that can run at once
+    int num_workers = min<int64_t>(num_threads, queue.size());
+    int job_threads = max(num_threads / max(num_workers, 1), 1);
+    int64_t job_memory_share = target_memory_usage / max(num_workers, 1);
+    atomic<int> num_working(num_workers);
     vector<thread> workers;
-    for (int i = 0; i < num_threads; ++i) {
+    for (int i = 0; i < num_workers; ++i) {
         workers.emplace_back([&]() {
+            // OpenMP settings do not carry over into new threads
+            omp_set_num_threads(job_threads);
             while (true) {
                 
                 int64_t job_memory = -1, job_idx = -1;
@@ -45,26 +113,14 @@ void JobSchedule::execute(int64_t target_memory_usage) {
                     queue_lock.unlock();
                     break;
                 }
-                if (est_memory_usage.load() == 0) {
-                    // even if we don't have the memory budget to do this job, we're
-                    // going to have to at some point and the memory situation will
-                    // never get any better than this
-                    tie(job_memory, job_idx) = queue.front();
-                    queue.pop_front();
+                auto it = next_job(queue, est_memory_usage.load(), measured_memory_usage.load(),
+                                   target_memory_usage);
+                if (it != queue.end()) {
+                    tie(job_memory, job_idx) = *it;
+                    queue.erase(it);
                     est_memory_usage.fetch_add(job_memory);
                 }
-                else {
-                    // find the longest-running job that can be done with the available
-                    // memory budget
-                    for (auto it = queue.begin(); it != queue.end(); ++it) {
-                        if (it->first + est_memory_usage.load() <= target_memory_usage) {
-                            tie(job_memory, job_idx) = *it;
-                            queue.erase(it);
-                            est_memory_usage.fetch_add(job_memory);
-                            break;
-                        }
-                    }
-                }
+                peak_est_memory_usage = max(peak_est_memory_usage, est_memory_usage.load());
                 queue_lock.unlock();
                 
                 if (job_idx == -1) {
@@ -74,16 +130,120 @@ void JobSchedule::execute(int64_t target_memory_usage) {
                 }
                 else {
                     // we think we have enough memory available to attempt this job
-                    job_func(job_idx);
+                    job_func(job_idx, max(job_memory, job_memory_share), job_threads);
                     est_memory_usage.fetch_sub(job_memory);
                 }
             }
+            num_working.fetch_sub(1);
         });
     }
+    
+    // sample the actual memory usage while the workers go
+    do {
+        int64_t current_memory_usage = get_current_rss_kb() * 1024;
+        // if memory that was held when we started is released (e.g. by another schedule), charge
+        // our jobs from the new low point so that they aren't credited with it
+        baseline_memory_usage = min(baseline_memory_usage, current_memory_usage);
+        int64_t measured = current_memory_usage - baseline_memory_usage;
+        measured_memory_usage.store(measured);
+        peak_measured_memory_usage = max(peak_measured_memory_usage, measured);
+        if (num_working.load() > 0) {
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+    } while (num_working.load() > 0);
+    
     // barrier sync
     for (auto& worker : workers) {
         worker.join();
     }
+    
+    num_executing.fetch_sub(1);
+    overlapped = overlapped || num_started.load() != started_count;
+    
+#ifdef debug_job_schedule
+    if (overlapped) {
+        cerr << "schedule " << cost_model_name << " overlapped with another schedule, not updating its cost ratio" << endl;
+    }
+#endif
+    
+    // the measurements can't be attributed to this schedule if another one was running too
+    if (!overlapped && !cost_model_name.empty() && peak_est_memory_usage > 0 && peak_measured_memory_usage > 0) {
+        // how far off were the (already scaled) estimates?
+        double observed_ratio = cost_ratio * double(peak_measured_memory_usage) / double(peak_est_memory_usage);
+#ifdef debug_job_schedule
+        cerr << "schedule " << cost_model_name << " had peak estimated memory " << peak_est_memory_usage << " and peak measured memory " << peak_measured_memory_usage << ", giving cost ratio " << observed_ratio << endl;
+#endif
+        record_cost_ratio(cost_model_name, observed_ratio);
+    }
+}
+
+void JobSchedule::set_cost_cache(const string& filename) {
+    lock_guard<mutex> lock(cost_cache_mutex);
+    cost_cache_filename = filename;
+}
+
+/// Read the cost cache file as a map from cost model names to (ratio, number of observations)
+static map<string, pair<double, int64_t>> read_cost_cache(const string& filename) {
+    map<string, pair<double, int64_t>> cache;
+    ifstream in(filename);
+    string line;
+    while (getline(in, line)) {
+        stringstream strm(line);
+        string name;
+        double ratio;
+        int64_t count;
+        if (getline(strm, name, '\t') && (strm >> ratio >> count)) {
+            cache[name] = make_pair(ratio, count);
+        }
+    }
+    return cache;
+}
+
+double JobSchedule::cached_cost_ratio(const string& cost_model_name) {
+    lock_guard<mutex> lock(cost_cache_mutex);
+    if (cost_cache_filename.empty()) {
+        return 1.0;
+    }
+    auto cache = read_cost_cache(cost_cache_filename);
+    auto it = cache.find(cost_model_name);
+    if (it == cache.end()) {
+        return 1.0;
+    }
+    // don't let one bad measurement make the estimates absurd
+    return min(max(it->second.first, 0.1), 10.0);
 }
+
+void JobSchedule::record_cost_ratio(const string& cost_model_name, double ratio) {
+    lock_guard<mutex> lock(cost_cache_mutex);
+    if (cost_cache_filename.empty()) {
+        return;
+    }
+    auto cache = read_cost_cache(cost_cache_filename);
+    auto& entry = cache[cost_model_name];
+    if (entry.second == 0) {
+        entry.first = ratio;
+    }
+    else {
+        // weight the recent runs more heavily
+        entry.first = 0.5 * entry.first + 0.5 * ratio;
+    }
+    ++entry.second;
+    
+    // write to a temporary file and move it into place so that a crash can't corrupt the cache
+    string tmp_filename = cost_cache_filename + ".tmp";
+    {
+        ofstream out(tmp_filename);
+        if (!out) {
+            cerr << "warning:[JobSchedule] could not write job cost cache to " << tmp_filename << endl;
+            return;
+        }
+        for (const auto& record : cache) {
+            out << record.first << '\t' << record.second.first << '\t' << record.second.second << '\n';
+        }
+    }
+    if (rename(tmp_filename.c_str(), cost_cache_filename.c_str()) != 0) {
+        cerr << "warning:[JobSchedule] could not update job cost cache " << cost_cache_filename << endl;
+    }
 }
 
+}
@@ -10,6 +10,9 @@
 #include <queue>
 #include <cstdint>
 #include <list>
+#include <string>
+#include <mutex>
+#include <atomic>
 
 namespace vg {
 
@@ -27,18 +30,64 @@ public:
     // with the memory estimate being in bytes, and the time estimate in
     // arbitrary units
     // the job function should execute the i-th job when called
+    // if a cost model name is given, the memory estimates are scaled by the ratio
+    // of measured to estimated memory seen in earlier schedules with the same name
+    // (see set_cost_cache)
     JobSchedule(const vector<pair<int64_t, int64_t>>& job_requirements,
-                const function<void(int64_t)>& job_func);
+                const function<void(int64_t)>& job_func,
+                const string& cost_model_name = "");
+    // alternatively, the job function can also be given the memory budget (in bytes)
+    // and the number of threads that the schedule grants to the job, for jobs that
+    // parallelize internally
+    JobSchedule(const vector<pair<int64_t, int64_t>>& job_requirements,
+                const function<void(int64_t, int64_t, int)>& job_func,
+                const string& cost_model_name = "");
     ~JobSchedule() = default;
     
-    // execute the job schedule with a target maximum memory usage
-    void execute(int64_t target_memory_usage);
+    // execute the job schedule with a target maximum memory usage, using the
+    // given number of threads (or get_thread_count() if it is 0)
+    // new jobs are also held back while the measured memory usage of the
+    // process would exceed the target with them added
+    // the threads and the memory target are divided evenly between the jobs that
+    // can run at the same time, and OpenMP in each job is limited to its threads
+    // the measured memory usage is process-wide, so it includes other schedules
+    // that are executing at the same time, and the cost model is not updated
+    // from schedules that overlapped with others
+    void execute(int64_t target_memory_usage, int num_threads = 0);
+    
+    // choose the next job from a queue of (memory estimate, job index) in priority
+    // order, given the estimated and measured memory usage of the jobs that are
+    // already running, or return the end of the queue if none should be started yet
+    static list<pair<int64_t, int64_t>>::const_iterator next_job(const list<pair<int64_t, int64_t>>& queue,
+                                                                 int64_t est_memory_usage,
+                                                                 int64_t measured_memory_usage,
+                                                                 int64_t target_memory_usage);
+    
+    // set a file that stores the measured-to-estimated memory ratios of each cost
+    // model between runs (by default they are not stored)
+    static void set_cost_cache(const string& filename);
     
 private:
     
-    function<void(int64_t)> job_func;
+    // get the memory ratio for a cost model from the cache, or 1 if there is none
+    static double cached_cost_ratio(const string& cost_model_name);
+    
+    // add an observed memory ratio for a cost model to the cache
+    static void record_cost_ratio(const string& cost_model_name, double ratio);
+    
+    function<void(int64_t, int64_t, int)> job_func;
     list<pair<int64_t, int64_t>> queue;
     
+    string cost_model_name;
+    // the factor that the memory estimates were scaled by
+    double cost_ratio = 1.0;
+    
+    static string cost_cache_filename;
+    static mutex cost_cache_mutex;
+    
+    // the number of schedules executing right now, and the number that have ever started
+    static atomic<int64_t> num_executing;
+    static atomic<int64_t> num_started;
 };
 
 }
@@ -1,6 +1,7 @@
 #include "kmer.hpp"
 
 #include <atomic>
+#include <algorithm>
 
 //#define debug
 
@@ -269,6 +270,28 @@ gcsa::byte_type encode_chars(const vector<char>& chars, const gcsa::Alphabet& al
     return val;
 }
 
+size_t merge_duplicate_gcsa_kmers(vector<gcsa::KMer>& kmers) {
+    // group the kmers by their start position, which is how the threads emit them anyway
+    sort(kmers.begin(), kmers.end(), [](const gcsa::KMer& a, const gcsa::KMer& b) {
+        return (a.from < b.from || (a.from == b.from && (a.to < b.to ||
+                (a.to == b.to && gcsa::Key::label(a.key) < gcsa::Key::label(b.key)))));
+    });
+    size_t removed = 0;
+    for (size_t i = 1; i < kmers.size(); ++i) {
+        gcsa::KMer& prev = kmers[i - 1 - removed];
+        if (kmers[i].from == prev.from && kmers[i].to == prev.to
+            && gcsa::Key::label(kmers[i].key) == gcsa::Key::label(prev.key)) {
+            prev.key = gcsa::Key::merge(prev.key, kmers[i].key);
+            ++removed;
+        }
+        else if (removed) {
+            kmers[i - removed] = kmers[i];
+        }
+    }
+    kmers.resize(kmers.size() - removed);
+    return removed;
+}
+
 void write_gcsa_kmers(const HandleGraph& graph, int kmer_size, ostream& out, size_t& size_limit, id_t head_id, id_t tail_id) {
 
     // We need an alphabet to parse the internal string format
@@ -293,6 +316,9 @@ void write_gcsa_kmers(const HandleGraph& graph, int kmer_size, ostream& out, siz
     size_t total_bytes = 0;
     auto handle_kmers = [&](vector<gcsa::KMer>& kmers, bool more) {
         if (!more || kmers.size() > buffer_limit) {
+            // merge duplicates before we take the lock so that the threads do it in parallel
+            // and they never reach the disk
+            merge_duplicate_gcsa_kmers(kmers);
             size_t bytes_required = kmers.size() * sizeof(gcsa::KMer) + sizeof(gcsa::GraphFileHeader);
 #pragma omp critical
             {
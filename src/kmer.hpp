@@ -72,6 +72,11 @@ void kmer_to_gcsa_kmers(const kmer_t& kmer, const gcsa::Alphabet& alpha, const f
 /// Encode the chars into the gcsa2 byte
 gcsa::byte_type encode_chars(const vector<char>& chars, const gcsa::Alphabet& alpha);
 
+/// Sort a buffer of gcsa2 binary kmers and merge the ones that have the same label and
+/// the same start and end positions, combining their predecessor and successor sets.
+/// Returns the number of kmers that were removed.
+size_t merge_duplicate_gcsa_kmers(vector<gcsa::KMer>& kmers);
+
 /**
  * Write GCSA2 formatted binary KMers to the given ostream.
  * size_limit is the maximum size of the kmer file in bytes. When the function
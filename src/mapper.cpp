@@ -124,12 +124,13 @@ BaseMapper::find_mems_simple(string::const_iterator seq_begin,
     string::const_iterator curr_end = seq_end;
     string::const_iterator cursor = seq_end - 1;
     // start off looking at the last character in the query
-    gcsa::range_type range = accelerate_mem_query(seq_begin, cursor);
+    int64_t skip_limit = max_mem_length ? min<int64_t>(max_mem_length, gcsa->order()) : gcsa->order();
+    gcsa::range_type range = accelerate_mem_query(seq_begin, cursor, skip_limit);
     while (cursor >= seq_begin) {
         // hold onto our previous range
         auto last_range = range;
         // execute one step of LF mapping
-        range = gcsa->LF(range, gcsa->alpha.char2comp[*cursor]);
+        range = accelerated_LF(range, *cursor);
         if (gcsa::Range::empty(range)
             || (max_mem_length && curr_end - cursor > max_mem_length)
             || curr_end - cursor > gcsa->order()) {
@@ -415,7 +416,7 @@ vector<MaximalExactMatch> BaseMapper::find_fanout_mems(string::const_iterator se
             auto prev_range = range;
             
             // execute one step of LF mapping
-            range = gcsa->LF(range, gcsa->alpha.char2comp[ch]);
+            range = accelerated_LF(range, ch);
             
             if (gcsa::Range::empty(range) || match_end - cursor > gcsa->order() || ch == 'N') {
                 
@@ -964,7 +965,8 @@ vector<MaximalExactMatch> BaseMapper::find_mems_deep(string::const_iterator seq_
     // the end of the current MEM
     string::const_iterator curr_end = seq_end;
     // range of the current iteration
-    gcsa::range_type range = accelerate_mem_query(seq_begin, cursor);
+    int64_t skip_limit = max_mem_length ? min<int64_t>(max_mem_length, gcsa->order()) : gcsa->order();
+    gcsa::range_type range = accelerate_mem_query(seq_begin, cursor, skip_limit);
     
     // did we move the cursor or the end of the match last iteration?
     bool prev_iter_jumped_lcp = false;
@@ -1007,7 +1009,7 @@ vector<MaximalExactMatch> BaseMapper::find_mems_deep(string::const_iterator seq_
             
             curr_end = cursor;
             --cursor;
-            range = accelerate_mem_query(seq_begin, cursor);
+            range = accelerate_mem_query(seq_begin, cursor, skip_limit);
             
             prev_iter_jumped_lcp = false;
 
@@ -1021,7 +1023,7 @@ vector<MaximalExactMatch> BaseMapper::find_mems_deep(string::const_iterator seq_
         auto last_range = range;
         
         // execute one step of LF mapping
-        range = gcsa->LF(range, gcsa->alpha.char2comp[*cursor]);
+        range = accelerated_LF(range, *cursor);
         
         if (gcsa::Range::empty(range)
             || (max_mem_length && curr_end - cursor > max_mem_length)
@@ -1046,7 +1048,7 @@ vector<MaximalExactMatch> BaseMapper::find_mems_deep(string::const_iterator seq_
                 
                 curr_end = cursor;
                 --cursor;
-                range = accelerate_mem_query(seq_begin, cursor);
+                range = accelerate_mem_query(seq_begin, cursor, skip_limit);
                 
                 // don't reseed in empty MEMs
                 prev_iter_jumped_lcp = false;
@@ -1110,7 +1112,7 @@ vector<MaximalExactMatch> BaseMapper::find_mems_deep(string::const_iterator seq_
                         // short MEM if it was ended by a deletion)
                         curr_end = greedy_restart_assume_substitution ? cursor : cursor + 1;
                         cursor = curr_end - 1;
-                        range = accelerate_mem_query(seq_begin, cursor);
+                        range = accelerate_mem_query(seq_begin, cursor, skip_limit);
                         // we don't worry that we might still be jumping through prefixes
                         // of the current MEM because we've moved completely past it
                         prev_iter_jumped_lcp = false;
@@ -1374,7 +1376,7 @@ void BaseMapper::find_sub_mems(const vector<MaximalExactMatch>& mems,
         // hold onto our previous range
         gcsa::range_type last_range = range;
         // execute one step of LF mapping
-        range = gcsa->LF(range, gcsa->alpha.char2comp[*cursor]);
+        range = accelerated_LF(range, *cursor);
         
         if (gcsa->count(range) <= parent_count) {
             // there are no more hits outside of parent MEM hits, record the previous
@@ -1521,13 +1523,13 @@ void BaseMapper::find_sub_mems_fast(const vector<MaximalExactMatch>& mems,
         
         // set up LF searching
         string::const_iterator cursor = probe_string_end - 1;
-        gcsa::range_type range = accelerate_mem_query(probe_string_begin, cursor);
+        gcsa::range_type range = accelerate_mem_query(probe_string_begin, cursor, sub_mem_thinning_burn_in);
         
         // check if the probe substring is more frequent than the SMEM its contained in
         bool probe_string_more_frequent = true;
         while (cursor >= probe_string_begin) {
             
-            range = gcsa->LF(range, gcsa->alpha.char2comp[*cursor]);
+            range = accelerated_LF(range, *cursor);
             
             // do a count operation if we've reached the beginning of the probe string or at invervals of the thinning parameter
             // past the burn-in parameter
@@ -1558,7 +1560,7 @@ void BaseMapper::find_sub_mems_fast(const vector<MaximalExactMatch>& mems,
                 // extend match until beginning of SMEM or until the end of the independent hit
                 while (cursor >= leftmost_extension_bound) {
                     gcsa::range_type last_range = range;
-                    range = gcsa->LF(range, gcsa->alpha.char2comp[*cursor]);
+                    range = accelerated_LF(range, *cursor);
                     
                     if ((use_approx_sub_mem_count ? gcsa::Range::length(range) : gcsa->count(range)) <= parent_range_count) {
                         range = last_range;
@@ -1601,7 +1603,7 @@ void BaseMapper::find_sub_mems_fast(const vector<MaximalExactMatch>& mems,
                 
                 // set up LF searching
                 cursor = middle - 1;
-                range = accelerate_mem_query(probe_string_begin, cursor);
+                range = accelerate_mem_query(probe_string_begin, cursor, sub_mem_thinning_burn_in);
                 
                 size_t extension_mem_count = 0;
                 
@@ -1609,7 +1611,7 @@ void BaseMapper::find_sub_mems_fast(const vector<MaximalExactMatch>& mems,
                 bool contained_in_independent_match = true;
                 while (cursor >= probe_string_begin) {
                     
-                    range = gcsa->LF(range, gcsa->alpha.char2comp[*cursor]);
+                    range = accelerated_LF(range, *cursor);
                     
                     // do count operations on the final index and on intervals of the thinning parameter once we pass the
                     // burn in parameter
@@ -1661,11 +1663,11 @@ void BaseMapper::find_sub_mems_fast(const vector<MaximalExactMatch>& mems,
                 
                 // get the GCSA range of the current sub-MEM extended one base past the end of the current parent MEM
                 cursor = right_search_bound;
-                range = accelerate_mem_query(probe_string_begin, cursor);
+                range = accelerate_mem_query(probe_string_begin, cursor, sub_mem_thinning_burn_in);
                 size_t extended_count = numeric_limits<size_t>::max();
                 bool contained_in_independent_match = true;
                 while (cursor >= probe_string_begin) {
-                    range = gcsa->LF(range, gcsa->alpha.char2comp[*cursor]);
+                    range = accelerated_LF(range, *cursor);
                     int64_t relative_idx = right_search_bound - cursor + 1;
                     if (cursor == probe_string_begin ||
                         (relative_idx >= sub_mem_thinning_burn_in && (relative_idx - sub_mem_thinning_burn_in) % sub_mem_count_thinning == 0)) {
@@ -1767,6 +1769,14 @@ vector<MaximalExactMatch> BaseMapper::find_stripped_matches(string::const_iterat
                                                             string::const_iterator seq_end,
                                                             size_t strip_length, size_t max_match_length,
                                                             size_t target_count) {
+    return move(find_stripped_matches_batch({make_pair(seq_begin, seq_end)}, strip_length,
+                                            max_match_length, target_count).front());
+}
+
+vector<vector<MaximalExactMatch>>
+BaseMapper::find_stripped_matches_batch(const vector<pair<string::const_iterator, string::const_iterator>>& seqs,
+                                        size_t strip_length, size_t max_match_length,
+                                        size_t target_count) {
     if (!gcsa) {
         throw runtime_error("error:[vg::Mapper] a GCSA2 index is required to query matches");
     }
@@ -1778,76 +1788,135 @@ vector<MaximalExactMatch> BaseMapper::find_stripped_matches(string::const_iterat
     }
     
 #ifdef debug_strip_match
-    cerr << "starting stripped match algorithm" << endl;
+    cerr << "starting stripped match algorithm on " << seqs.size() << " sequences" << endl;
     cerr << "\tstrip length:" << strip_length << endl;
     cerr << "\tmax match length:" << max_match_length << endl;
     cerr << "\ttarget count:" << target_count << endl;
-    cerr << "\tsequence:" << string(seq_begin, seq_end) << endl;
-    
+    for (const auto& seq : seqs) {
+        cerr << "\tsequence:" << string(seq.first, seq.second) << endl;
+    }
 #endif
     
-    // init the return value
-    vector<MaximalExactMatch> matches;
+    // the backward search of one strip
+    struct StripSearch {
+        size_t seq_idx;
+        // the end of other strip match we will find
+        string::const_iterator strip_end;
+        // a pointer to the next char we will match to
+        string::const_iterator cursor;
+        // empty string starts matching entire index
+        // note: because the stopping conditions are different here we can't
+        // accelerate this MEM init query without changing results
+        gcsa::range_type range;
+        bool active;
+    };
     
-    if (seq_end != seq_begin) {
-        // we are not in the empty string
-        int64_t seq_len = seq_end - seq_begin;
-        int64_t num_strips = (seq_len - 1) / strip_length + 1;
-        for (int64_t strip_num = 0; strip_num < num_strips; ++strip_num) {
-            
-#ifdef debug_strip_match
-            cerr << "strip number " << strip_num << " of " << num_strips << endl;
-#endif
-            
-            // the end of other strip match we will find
-            auto strip_end = seq_end - strip_num * strip_length;
-            // empty string starts matching entire index
-            // note: because the stopping conditions are different here we can't
-            // accelerate this MEM init query without changing results
-            auto range = gcsa::range_type(0, gcsa->size() - 1);
-            // a pointer to the next char we will match to
-            auto cursor = strip_end - 1;
-            
-            while (cursor >= seq_begin &&
-                   (!max_match_length || strip_end - cursor <= max_match_length)) {
-                
-                if (*cursor == 'N') {
-                    // N matches are uninformative, so we don't want to match them
-                    break;
+    // set up the searches for every strip of every sequence
+    vector<StripSearch> searches;
+    vector<size_t> first_search(seqs.size() + 1, 0);
+    for (size_t i = 0; i < seqs.size(); ++i) {
+        first_search[i] = searches.size();
+        if (seqs[i].second != seqs[i].first) {
+            // we are not in the empty string
+            int64_t seq_len = seqs[i].second - seqs[i].first;
+            int64_t num_strips = (seq_len - 1) / strip_length + 1;
+            for (int64_t strip_num = 0; strip_num < num_strips; ++strip_num) {
+                auto strip_end = seqs[i].second - strip_num * strip_length;
+                searches.push_back(StripSearch{i, strip_end, strip_end - 1,
+                                               gcsa::range_type(0, gcsa->size() - 1), true});
+            }
+        }
+    }
+    first_search[seqs.size()] = searches.size();
+    
+    // advance all of the searches one character at a time
+    vector<size_t> active(searches.size());
+    for (size_t j = 0; j < searches.size(); ++j) {
+        active[j] = j;
+    }
+    while (!active.empty()) {
+        
+        if (accelerator) {
+            // get the next cache lookups started before we need them
+            for (size_t j : active) {
+                const auto& search = searches[j];
+                if (search.cursor >= seqs[search.seq_idx].first) {
+                    accelerator->prefetch_LF(search.range, gcsa->alpha.char2comp[*search.cursor]);
                 }
-                
+            }
+        }
+        
+        size_t num_active = 0;
+        for (size_t j : active) {
+            auto& search = searches[j];
+            if (!search.active) {
+                // a previous strip matched to the beginning of the sequence
+                continue;
+            }
+            
+            if (search.cursor < seqs[search.seq_idx].first
+                || (max_match_length && search.strip_end - search.cursor > max_match_length)
+                || *search.cursor == 'N') {
+                // N matches are uninformative, so we don't want to match them
+                search.active = false;
+            }
+            else {
                 // match one more char
-                auto next_range = gcsa->LF(range, gcsa->alpha.char2comp[*cursor]);
+                auto next_range = accelerated_LF(search.range, *search.cursor);
                 
 #ifdef debug_strip_match
-                cerr << "\tgot next range which is length " << gcsa::Range::length(next_range) << " and " << (gcsa::Range::empty(next_range) ? "" : "not ") << "empty" << endl;
+                cerr << "\tstrip " << j << " got next range which is length " << gcsa::Range::length(next_range) << " and " << (gcsa::Range::empty(next_range) ? "" : "not ") << "empty" << endl;
 #endif
                 
                 if (gcsa::Range::empty(next_range)) {
                     // we've gone too far, there are no more hits
-                    break;
+                    search.active = false;
                 }
-                
-                // the match was successful, advance to the range and move the cursor
-                range = next_range;
-                --cursor;
-                
-                if (target_count && gcsa::Range::length(next_range) <= target_count) {
-                    // the (approximate) count is below the specified limit, so
-                    // we've found reasonably unique sequence, stop looking for more
-                    break;
+                else {
+                    // the match was successful, advance to the range and move the cursor
+                    search.range = next_range;
+                    --search.cursor;
+                    
+                    if (target_count && gcsa::Range::length(next_range) <= target_count) {
+                        // the (approximate) count is below the specified limit, so
+                        // we've found reasonably unique sequence, stop looking for more
+                        search.active = false;
+                    }
                 }
             }
             
-            if (cursor + 1 == strip_end) {
+            if (search.active) {
+                active[num_active++] = j;
+            }
+            else if (search.cursor < seqs[search.seq_idx].first) {
+                // all of the later strips will be contained in this match, so we can stop
+                // searching them
+                for (size_t k = j + 1; k < first_search[search.seq_idx + 1]; ++k) {
+                    searches[k].active = false;
+                }
+            }
+        }
+        active.resize(num_active);
+    }
+    
+    vector<vector<MaximalExactMatch>> all_matches(seqs.size());
+    for (size_t i = 0; i < seqs.size(); ++i) {
+        
+        // init the return value
+        vector<MaximalExactMatch>& matches = all_matches[i];
+        
+        for (size_t j = first_search[i]; j < first_search[i + 1]; ++j) {
+            const auto& search = searches[j];
+            
+            if (search.cursor + 1 == search.strip_end) {
                 // edge case where one char mismatches the entire index, don't bother
                 // with this
                 continue;
             }
             
             if (!matches.empty()) {
-                if (matches.back().begin <= cursor + 1 &&
-                    matches.back().end >= strip_end) {
+                if (matches.back().begin <= search.cursor + 1 &&
+                    matches.back().end >= search.strip_end) {
                     // this match is entirely contained within the larger match
                     // of the previous strip, so it's not likely to give us any
                     // new information
@@ -1858,46 +1927,59 @@ vector<MaximalExactMatch> BaseMapper::find_stripped_matches(string::const_iterat
             }
             
 #ifdef debug_strip_match
-            cerr << "adding match of sequence " << string(cursor + 1, strip_end) << " and " << gcsa->count(range) << " hits" << endl;
+            cerr << "adding match of sequence " << string(search.cursor + 1, search.strip_end) << " and " << gcsa->count(search.range) << " hits" << endl;
 #endif
             
-            matches.emplace_back(cursor + 1, strip_end, range, gcsa->count(range));
+            matches.emplace_back(search.cursor + 1, search.strip_end, search.range, gcsa->count(search.range));
             matches.back().primary = true;
             
-            if (cursor < seq_begin) {
+            if (search.cursor < seqs[i].first) {
                 // all further hits will be contained in ones we've already seen
                 break;
             }
         }
-    }
-    
-    // matches are queried in reverse lexicographic order, flip them around
-    reverse(matches.begin(), matches.end());
-    
-    for (MaximalExactMatch& match : matches) {
-        // figure out how many occurrences there are
-        match.match_count = gcsa->count(match.range);
-        if (!hard_hit_max || match.match_count < hard_hit_max) {
-            // the total number of hits is low enough that we think it's at least
-            // potentially worth querying hits
-            if (hit_max) {
-                // we may want to subsample
-                gcsa->locate(match.range, hit_max, match.nodes);
-                
-            } else {
-                // we won't subsample down to a prespecified maximum
-                gcsa->locate(match.range, match.nodes);
+        
+        // matches are queried in reverse lexicographic order, flip them around
+        reverse(matches.begin(), matches.end());
+        
+        for (MaximalExactMatch& match : matches) {
+            // figure out how many occurrences there are
+            match.match_count = gcsa->count(match.range);
+            if (!hard_hit_max || match.match_count < hard_hit_max) {
+                // the total number of hits is low enough that we think it's at least
+                // potentially worth querying hits
+                if (hit_max) {
+                    // we may want to subsample
+                    gcsa->locate(match.range, hit_max, match.nodes);
+                    
+                } else {
+                    // we won't subsample down to a prespecified maximum
+                    gcsa->locate(match.range, match.nodes);
+                }
             }
+            match.queried_count = match.nodes.size();
         }
-        match.queried_count = match.nodes.size();
     }
     
-    
-    return matches;
+    return all_matches;
 }
 
 gcsa::range_type BaseMapper::accelerate_mem_query(string::const_iterator begin,
-                                                  string::const_iterator& cursor) const {
+                                                  string::const_iterator& cursor,
+                                                  int64_t skip_limit) const {
+    
+    if (accelerator
+        && accelerator->sparse_length() != 0
+        && accelerator->sparse_length() < skip_limit
+        && cursor - begin >= accelerator->sparse_length() - 1
+        && find(cursor - accelerator->sparse_length() + 1, cursor + 1, 'N') > cursor) {
+        // try to skip even further with the longer k-mers
+        auto range = accelerator->sparse_memoized_LF(cursor);
+        if (!gcsa::Range::empty(range)) {
+            cursor -= accelerator->sparse_length();
+            return range;
+        }
+    }
     
     if (!accelerator
         || cursor - begin < accelerator->length() - 1
@@ -235,6 +235,16 @@ public:
                           size_t max_match_length,
                           size_t target_count);
     
+    /// Find the stripped matches of several sequences at once. The backward searches of
+    /// all of the strips in all of the sequences are advanced in lockstep, so that their
+    /// LF queries are independent and can overlap in memory. Gives the same results as
+    /// calling find_stripped_matches on each sequence.
+    vector<vector<MaximalExactMatch>>
+    find_stripped_matches_batch(const vector<pair<string::const_iterator, string::const_iterator>>& seqs,
+                                size_t strip_length,
+                                size_t max_match_length,
+                                size_t target_count);
+    
     // finds MEMs where a pre-specified number of low-quality bases are
     // allowed to be any base. if the optional vector is provided, then it
     // will be filled to include all of the places that each returned MEM
@@ -337,8 +347,13 @@ public:
     
     /// If possible, use the MEMAcclerator to get the initial range for a MEM and update the cursor
     /// accordingly. If this is not possible, return the full GCSA2 range and leave the cursor unaltered.
+    /// The longer k-mers in the sparse table are only used if they are shorter than the skip limit.
     gcsa::range_type accelerate_mem_query(string::const_iterator begin,
-                                          string::const_iterator& cursor) const;
+                                          string::const_iterator& cursor,
+                                          int64_t skip_limit = numeric_limits<int64_t>::max()) const;
+    
+    /// One step of LF mapping, going through the MEMAccelerator's cache if we have one
+    inline gcsa::range_type accelerated_LF(const gcsa::range_type& range, char c) const;
     
     // Use the GCSA index to look up the sequence
     set<pos_t> sequence_positions(const string& seq);
@@ -373,6 +388,15 @@ public:
     double haplotype_consistency_exponent = 1;
 };
 
+inline gcsa::range_type BaseMapper::accelerated_LF(const gcsa::range_type& range, char c) const {
+    if (accelerator) {
+        return accelerator->cached_LF(range, gcsa->alpha.char2comp[c]);
+    }
+    else {
+        return gcsa->LF(range, gcsa->alpha.char2comp[c]);
+    }
+}
+
 /**
  * Keeps track of statistics about fragment length within the Mapper class.
  * Belongs to a single thread.
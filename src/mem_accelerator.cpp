@@ -7,10 +7,20 @@
 #include "mem_accelerator.hpp"
 #include <sdsl/util.hpp>
 #include <cmath>
+#include <algorithm>
+#include <omp.h>
+
+#include "hash_map.hpp"
 
 namespace vg {
 
-MEMAccelerator::MEMAccelerator(const gcsa::GCSA& gcsa_index, size_t k) : k(k)
+atomic<uint64_t> MEMAccelerator::next_cache_id(1);
+thread_local vector<MEMAccelerator::LFCacheEntry> MEMAccelerator::lf_cache;
+thread_local uint64_t MEMAccelerator::lf_cache_owner = 0;
+
+MEMAccelerator::MEMAccelerator(const gcsa::GCSA& gcsa_index, size_t k,
+                               size_t sparse_k, size_t max_sparse_kmers)
+    : gcsa_index(&gcsa_index), k(k), cache_id(next_cache_id++)
 {
     // compute the minimum width required to express the integers.
     range_table.width(max<uint8_t>(sdsl::bits::length(gcsa_index.size()), 1));
@@ -59,6 +69,88 @@ MEMAccelerator::MEMAccelerator(const gcsa::GCSA& gcsa_index, size_t k) : k(k)
             stack.emplace_back(0, enc, range);
         }
     }
+    
+    if (sparse_k > k && max_sparse_kmers != 0) {
+        init_sparse_table(sparse_k, max_sparse_kmers);
+    }
+}
+
+void MEMAccelerator::init_sparse_table(size_t sparse_k, size_t max_sparse_kmers) {
+    
+    // we need to encode the k-mer in a 64-bit integer, and we can't trust
+    // matches that are longer than the order of the index
+    sparse_k = min<size_t>(sparse_k, min<size_t>(32, gcsa_index->order()));
+    if (sparse_k <= k) {
+        return;
+    }
+    
+    // the non-empty k-mers in the dense table are the first level
+    vector<pair<uint64_t, gcsa::range_type>> level;
+    for (uint64_t enc = 0, n = range_table.size() / 2; enc < n; ++enc) {
+        gcsa::range_type range(range_table[2 * enc], range_table[2 * enc + 1]);
+        if (!gcsa::Range::empty(range)) {
+            level.emplace_back(enc, range);
+        }
+    }
+    
+    // the probability that a k-mer from a random position in the index is in the
+    // table is proportional to its range length, so if we can't fit all of the k-mers
+    // we keep the ones with the longest ranges
+    auto keep_most_frequent = [&](vector<pair<uint64_t, gcsa::range_type>>& kmers) {
+        if (kmers.size() > max_sparse_kmers) {
+            nth_element(kmers.begin(), kmers.begin() + max_sparse_kmers, kmers.end(),
+                        [](const pair<uint64_t, gcsa::range_type>& a, const pair<uint64_t, gcsa::range_type>& b) {
+                return gcsa::Range::length(a.second) > gcsa::Range::length(b.second);
+            });
+            kmers.resize(max_sparse_kmers);
+        }
+    };
+    keep_most_frequent(level);
+    
+    const char alphabet[5] = "ACGT";
+    for (size_t length = k; length < sparse_k; ++length) {
+        // extend every k-mer on the left by each character
+        vector<vector<pair<uint64_t, gcsa::range_type>>> thread_next_level(omp_get_max_threads());
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (size_t i = 0; i < level.size(); ++i) {
+            auto& next_level = thread_next_level[omp_get_thread_num()];
+            for (uint64_t next = 0; next < 4; ++next) {
+                auto range = gcsa_index->LF(level[i].second, gcsa_index->alpha.char2comp[alphabet[next]]);
+                if (!gcsa::Range::empty(range)) {
+                    next_level.emplace_back((next << (2 * length)) | level[i].first, range);
+                }
+            }
+        }
+        level.clear();
+        for (auto& next_level : thread_next_level) {
+            level.insert(level.end(), next_level.begin(), next_level.end());
+            next_level.clear();
+            next_level.shrink_to_fit();
+        }
+        keep_most_frequent(level);
+    }
+    
+    if (level.empty()) {
+        return;
+    }
+    
+    vector<uint64_t> keys;
+    keys.reserve(level.size());
+    for (const auto& kmer : level) {
+        keys.push_back(kmer.first);
+    }
+    sparse_hash = unique_ptr<kmer_hash_t>(new kmer_hash_t(keys.size(), keys, omp_get_max_threads(), 2.0, false, false));
+    
+    sparse_kmers.resize(level.size());
+    sparse_range_table.width(max<uint8_t>(sdsl::bits::length(gcsa_index->size()), 1));
+    sparse_range_table.resize(2 * level.size());
+    for (const auto& kmer : level) {
+        uint64_t idx = sparse_hash->lookup(kmer.first);
+        sparse_kmers[idx] = kmer.first;
+        sparse_range_table[2 * idx] = kmer.second.first;
+        sparse_range_table[2 * idx + 1] = kmer.second.second;
+    }
+    this->sparse_k = sparse_k;
 }
 
 gcsa::range_type MEMAccelerator::memoized_LF(string::const_iterator last) const {
@@ -70,4 +162,63 @@ gcsa::range_type MEMAccelerator::memoized_LF(string::const_iterator last) const
     return gcsa::range_type(range_table[enc << 1], range_table[(enc << 1) | 1]);
 }
 
+gcsa::range_type MEMAccelerator::sparse_memoized_LF(string::const_iterator last) const {
+    if (!sparse_hash) {
+        return gcsa::range_type(1, 0);
+    }
+    uint64_t enc = 0;
+    for (size_t i = 0; i < sparse_k; ++i) {
+        enc |= (uint64_t(encode(*last)) << (i << 1));
+        --last;
+    }
+    uint64_t idx = sparse_hash->lookup(enc);
+    if (idx >= sparse_kmers.size() || sparse_kmers[idx] != enc) {
+        // the hash maps absent k-mers to arbitrary values
+        return gcsa::range_type(1, 0);
+    }
+    return gcsa::range_type(sparse_range_table[idx << 1], sparse_range_table[(idx << 1) | 1]);
+}
+
+inline size_t MEMAccelerator::lf_cache_set(const gcsa::range_type& range, gcsa::comp_type comp) const {
+    size_t hsh = hash<size_t>()(range.first);
+    hash_combine(hsh, range.second);
+    hash_combine(hsh, comp);
+    return 2 * (hsh & (LF_CACHE_SETS - 1));
+}
+
+gcsa::range_type MEMAccelerator::cached_LF(const gcsa::range_type& range, gcsa::comp_type comp) const {
+    if (gcsa::Range::empty(range)) {
+        return gcsa_index->LF(range, comp);
+    }
+    if (lf_cache_owner != cache_id) {
+        // this thread was last used with another accelerator (or never)
+        lf_cache.assign(2 * LF_CACHE_SETS, LFCacheEntry());
+        lf_cache_owner = cache_id;
+    }
+    
+    LFCacheEntry* set = &lf_cache[lf_cache_set(range, comp)];
+    
+    // the sets are kept in most-recently-used order
+    if (set[0].query == range && set[0].comp == comp) {
+        return set[0].result;
+    }
+    if (set[1].query == range && set[1].comp == comp) {
+        swap(set[0], set[1]);
+        return set[0].result;
+    }
+    
+    // evict the least recently used entry
+    set[1] = set[0];
+    set[0].query = range;
+    set[0].comp = comp;
+    set[0].result = gcsa_index->LF(range, comp);
+    return set[0].result;
+}
+
+void MEMAccelerator::prefetch_LF(const gcsa::range_type& range, gcsa::comp_type comp) const {
+    if (lf_cache_owner == cache_id) {
+        __builtin_prefetch(&lf_cache[lf_cache_set(range, comp)]);
+    }
+}
+
 }
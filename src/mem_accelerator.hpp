@@ -9,8 +9,12 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
 #include <gcsa/gcsa.h>
 #include <sdsl/int_vector.hpp>
+#include <BooPHF.h>
 
 namespace vg {
 
@@ -18,17 +22,29 @@ using namespace std;
 
 /*
  * An auxilliary index that accelerates the initial steps of
- * MEM-finding in
+ * MEM-finding in a GCSA2 index. It has two levels: a dense table
+ * of the ranges of all k-mers, and a sparse table of the ranges of
+ * the most frequent longer k-mers that occur in the index. It also
+ * keeps a small per-thread cache of recent LF queries.
  */
 class MEMAccelerator {
 public:
     
     MEMAccelerator() = default;
-    MEMAccelerator(const gcsa::GCSA& gcsa_index, size_t k);
+    // memoize all k-mers, and up to max_sparse_kmers of the sparse_k-mers
+    // (only if sparse_k > k). the sparse table is built one base at a time from
+    // the dense one, which takes up to 4 * max_sparse_kmers LF queries for each
+    // of the sparse_k - k levels
+    MEMAccelerator(const gcsa::GCSA& gcsa_index, size_t k,
+                   size_t sparse_k = 0, size_t max_sparse_kmers = 0);
     
     // return the length of k-mers that are memoized
     inline int64_t length() const;
     
+    // return the length of the k-mers in the sparse table, or 0 if there
+    // is no sparse table
+    inline int64_t sparse_length() const;
+    
     // look up the GCSA range that corresponds to a k-length
     // string ending at the indicated position. client code
     // is responsible for ensuring that the string being
@@ -36,21 +52,77 @@ public:
     // characters
     gcsa::range_type memoized_LF(string::const_iterator last) const;
     
+    // look up the GCSA range of a sparse_length() string ending at the
+    // indicated position. returns an empty range if the k-mer isn't in
+    // the sparse table, which does not mean it isn't in the index. the
+    // same requirements apply as for memoized_LF
+    gcsa::range_type sparse_memoized_LF(string::const_iterator last) const;
+    
+    // returns the same result as gcsa_index.LF(range, comp), but checks
+    // a small cache of recent queries in this thread first
+    gcsa::range_type cached_LF(const gcsa::range_type& range, gcsa::comp_type comp) const;
+    
+    // start loading the part of this thread's LF cache that a cached_LF query
+    // would use, so that it's ready by the time we make the query
+    void prefetch_LF(const gcsa::range_type& range, gcsa::comp_type comp) const;
+    
 private:
     
     inline int64_t encode(char c) const;
     
+    // the index of the first entry in the LF cache set for a query
+    size_t lf_cache_set(const gcsa::range_type& range, gcsa::comp_type comp) const;
+    
+    // add the sparse table on top of the dense one
+    void init_sparse_table(size_t sparse_k, size_t max_sparse_kmers);
+    
+    typedef boomphf::mphf<uint64_t, boomphf::SingleHashFunctor<uint64_t>> kmer_hash_t;
+    
+    // an entry in the LF cache
+    struct LFCacheEntry {
+        gcsa::range_type query = gcsa::range_type(1, 0);
+        gcsa::comp_type comp = 0;
+        gcsa::range_type result;
+    };
+    
+    // the number of 2-way sets in the LF cache
+    static const size_t LF_CACHE_SETS = 1 << 16;
+    
+    // the index we're accelerating
+    const gcsa::GCSA* gcsa_index = nullptr;
+    
     // the size k-mer we'll index
     const int64_t k = 1;
     // the actual table
     sdsl::int_vector<> range_table;
     
+    // the size of the k-mers in the sparse table
+    int64_t sparse_k = 0;
+    // minimal perfect hash of the k-mers in the sparse table
+    unique_ptr<kmer_hash_t> sparse_hash;
+    // the k-mers in the sparse table, in hash order, to detect absent k-mers
+    vector<uint64_t> sparse_kmers;
+    // their ranges, interleaved like in range_table
+    sdsl::int_vector<> sparse_range_table;
+    
+    // identifies this accelerator to the LF cache
+    uint64_t cache_id = 0;
+    static atomic<uint64_t> next_cache_id;
+    
+    // the per-thread LF cache, which gets cleared whenever a thread starts
+    // using a different accelerator
+    thread_local static vector<LFCacheEntry> lf_cache;
+    thread_local static uint64_t lf_cache_owner;
 };
 
 inline int64_t MEMAccelerator::length() const {
     return k;
 }
 
+inline int64_t MEMAccelerator::sparse_length() const {
+    return sparse_k;
+}
+
 inline int64_t MEMAccelerator::encode(char c) const {
     switch (c) {
         case 'A':
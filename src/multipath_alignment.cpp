@@ -525,6 +525,50 @@ namespace vg {
         multipath_aln.clear_start();
     }
     
+    void SubpathDAG::build(const multipath_alignment_t& multipath_aln) {
+        
+        size_t n = multipath_aln.subpath_size();
+        score.resize(n);
+        length.resize(n);
+        pred_begin.assign(n + 1, 0);
+        
+        // count the in-degrees
+        for (size_t i = 0; i < n; ++i) {
+            const subpath_t& subpath = multipath_aln.subpath(i);
+            score[i] = subpath.score();
+            length[i] = path_to_length(subpath.path());
+            for (auto next : subpath.next()) {
+                ++pred_begin[next + 1];
+            }
+            for (const auto& connection : subpath.connection()) {
+                ++pred_begin[connection.next() + 1];
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            pred_begin[i + 1] += pred_begin[i];
+        }
+        
+        // fill in the predecessors, which come out in ascending order of predecessor index
+        pred.resize(pred_begin[n]);
+        vector<size_t>& fill = fill_scratch;
+        fill.assign(pred_begin.begin(), pred_begin.end() - 1);
+        for (size_t i = 0; i < n; ++i) {
+            const subpath_t& subpath = multipath_aln.subpath(i);
+            for (auto next : subpath.next()) {
+                pred[fill[next]++] = make_pair(int64_t(i), int32_t(0));
+            }
+            for (const auto& connection : subpath.connection()) {
+                pred[fill[connection.next()]++] = make_pair(int64_t(i), connection.score());
+            }
+        }
+    }
+    
+    SubpathDAG& SubpathDAG::workspace(const multipath_alignment_t& multipath_aln) {
+        static thread_local SubpathDAG dag;
+        dag.build(multipath_aln);
+        return dag;
+    }
+    
     /// We define this struct for holding the dynamic programming problem for a
     /// multipath alignment, which we use for finding the optimal alignment,
     /// scoring the optimal alignment, and enumerating the top alignments.
@@ -572,6 +616,7 @@ namespace vg {
     /// the traceback should be global (a source to a sink in the multipath DAG)
     /// or local (starting and ending at any subpath)
     tuple<MultipathProblem, int64_t, int32_t> run_multipath_dp(const multipath_alignment_t& multipath_aln,
+                                                               const SubpathDAG& dag,
                                                                bool subpath_global = false,
                                                                bool forward = true) {
         
@@ -587,37 +632,38 @@ namespace vg {
         // thing, but the iteration schemes are just different enough to be pretty annoying
         
         if (forward) {
+            // pull the DP through the predecessors of each subpath, which are listed in the
+            // same order that pushing forward from each predecessor would visit them in
+            int32_t* prefix_score = problem.prefix_score.data();
+            int64_t* prev_subpath = problem.prev_subpath.data();
+            int64_t* prefix_length = problem.prefix_length.data();
+            const int32_t* score = dag.score.data();
+            const int64_t* length = dag.length.data();
             for (size_t i = 0; i < multipath_aln.subpath_size(); ++i) {
-                const subpath_t& subpath = multipath_aln.subpath(i);
-                int32_t extended_score = problem.prefix_score[i] + subpath.score();
-                // carry DP forward
-                if (subpath.next_size() != 0 || subpath.connection_size() != 0) {
-                    int64_t thru_length = path_to_length(subpath.path()) + problem.prefix_length[i];
-                    for (size_t j = 0; j < subpath.next_size(); ++j) {
-                        int64_t next = subpath.next(j);
-                        problem.prefix_length[next] = thru_length;
-                        
-                        // can we improve prefix score on following subpath through this one?
-                        if (extended_score >= problem.prefix_score[next]) {
-                            problem.prev_subpath[next] = i;
-                            problem.prefix_score[next] = extended_score;
-                        }
-                    }
-                    // repeat DP across scored connections
-                    for (size_t j = 0; j < subpath.connection_size(); ++j) {
-                        const connection_t& connection = subpath.connection(j);
-                        
-                        problem.prefix_length[connection.next()] = thru_length;
-                        if (extended_score + connection.score() >= problem.prefix_score[connection.next()]) {
-                            problem.prev_subpath[connection.next()] = i;
-                            problem.prefix_score[connection.next()] = extended_score + connection.score();
+                auto preds = dag.predecessors(i);
+                if (!preds.empty()) {
+                    int32_t best_score = prefix_score[i];
+                    int64_t best_prev = prev_subpath[i];
+                    for (const auto& prev : preds) {
+                        // can we improve prefix score on this subpath through the predecessor?
+                        int32_t score_thru = prefix_score[prev.first] + score[prev.first] + prev.second;
+                        if (score_thru >= best_score) {
+                            best_score = score_thru;
+                            best_prev = prev.first;
                         }
                     }
+                    prefix_score[i] = best_score;
+                    prev_subpath[i] = best_prev;
+                    // the read length comes through the final predecessor
+                    int64_t last = (preds.end() - 1)->first;
+                    prefix_length[i] = prefix_length[last] + length[last];
                 }
+                
+                int32_t extended_score = prefix_score[i] + score[i];
                 // check if an alignment is allowed to end here according to global/local rules and
                 // if so whether it's optimal
-                if (extended_score >= opt_score && (!subpath_global || (subpath.next_size() == 0 &&
-                                                                        subpath.connection_size() == 0))) {
+                if (extended_score >= opt_score && (!subpath_global || (multipath_aln.subpath(i).next_size() == 0 &&
+                                                                        multipath_aln.subpath(i).connection_size() == 0))) {
                     // We have a better optimal subpath
                     opt_score = extended_score;
                     opt_subpath = i;
@@ -649,8 +695,8 @@ namespace vg {
                     }
                 }
                 // add score and length of this subpath
-                problem.prefix_length[i] += path_to_length(subpath.path());
-                problem.prefix_score[i] += subpath.score();
+                problem.prefix_length[i] += dag.length[i];
+                problem.prefix_score[i] += dag.score[i];
                 
                 if (problem.prefix_score[i] >= opt_score && (!subpath_global || is_start[i])) {
                     // We have a better optimal subpath
@@ -665,6 +711,13 @@ namespace vg {
     
     }
     
+    /// Same as the previous function, but builds the subpath DAG in this thread's workspace.
+    tuple<MultipathProblem, int64_t, int32_t> run_multipath_dp(const multipath_alignment_t& multipath_aln,
+                                                               bool subpath_global = false,
+                                                               bool forward = true) {
+        return run_multipath_dp(multipath_aln, SubpathDAG::workspace(multipath_aln), subpath_global, forward);
+    }
+    
     /// We define this helper to turn tracebacks through a DP problem into
     /// Paths that we can put in an Alignment. We use iterators to the start
     /// and past-the-end of the traceback (in some kind of list of int64_t
@@ -874,8 +927,9 @@ namespace vg {
         
         // do forward-backward dynamic programming so that we can efficiently
         // compute maximum score over each subpath and edge
-        auto fwd_dp = run_multipath_dp(multipath_aln, true, true);
-        auto bwd_dp = run_multipath_dp(multipath_aln, true, false);
+        const SubpathDAG& dag = SubpathDAG::workspace(multipath_aln);
+        auto fwd_dp = run_multipath_dp(multipath_aln, dag, true, true);
+        auto bwd_dp = run_multipath_dp(multipath_aln, dag, true, false);
         
         auto& fwd_scores = get<0>(fwd_dp).prefix_score;
         auto& bwd_scores = get<0>(bwd_dp).prefix_score;
@@ -963,7 +1017,8 @@ namespace vg {
         vector<Alignment> to_return;
         
         // Fill out the dynamic programming problem
-        auto dp_result = run_multipath_dp(multipath_aln);
+        const SubpathDAG& dag = SubpathDAG::workspace(multipath_aln);
+        auto dp_result = run_multipath_dp(multipath_aln, dag);
         // Get the filled DP problem
         MultipathProblem& problem = get<0>(dp_result);
         // And the optimal final subpath
@@ -1003,9 +1058,8 @@ namespace vg {
             }
         };
         
-        // Also, subpaths only keep track of their nexts, so we need to invert
-        // that so we can get all valid prev subpaths.
-        vector<vector<pair<int64_t, int32_t>>> prev_subpaths(multipath_aln.subpath_size());
+        // Subpaths only keep track of their nexts, but the DAG has them inverted
+        // so we can get all valid prev subpaths.
 
         // We want to be able to start the traceback only from places where we
         // won't get shorter versions of same- or higher-scoring alignments.
@@ -1030,9 +1084,6 @@ namespace vg {
             for (auto& next_subpath : multipath_aln.subpath(i).next()) {
                 // For each next subpath it lists
                 
-                // Register this subpath as a predecessor of the next
-                prev_subpaths[next_subpath].emplace_back(i, 0);
-                
                 if (multipath_aln.subpath(next_subpath).score() >= 0) {
                     // This successor has a nonnegative score, so taking it
                     // after us would generate a longer, same- or
@@ -1044,9 +1095,6 @@ namespace vg {
             
             for (const auto& connection : multipath_aln.subpath(i).connection()) {
                 
-                // register the connection
-                prev_subpaths[connection.next()].emplace_back(i, connection.score());
-                
                 if (multipath_aln.subpath(connection.next()).score() + connection.score() >= 0) {
                     // Taking the connection would lead to a longer or better alignment
                     valid_traceback_start = false;
@@ -1130,7 +1178,7 @@ namespace vg {
                 // To compute the additional score difference, we need to know what our optimal prefix score was.
                 auto& best_prefix_score = problem.prefix_score[here];
                 
-                for (auto& prev : prev_subpaths[here]) {
+                for (auto& prev : dag.predecessors(here)) {
                     // For each, compute the score of the optimal alignment ending at that predecessor
                     auto prev_opt_score = problem.prefix_score[prev.first] + multipath_aln.subpath(prev.first).score() + prev.second;
                     
@@ -1180,7 +1228,8 @@ namespace vg {
         vector<Alignment> to_return;
         
         // Fill out the dynamic programming problem
-        auto dp_result = run_multipath_dp(multipath_aln);
+        const SubpathDAG& dag = SubpathDAG::workspace(multipath_aln);
+        auto dp_result = run_multipath_dp(multipath_aln, dag);
         // Get the filled DP problem
         MultipathProblem& problem = get<0>(dp_result);
         // And the optimal final subpath
@@ -1194,9 +1243,8 @@ namespace vg {
         // Have a queue just for end positions
         MinMaxHeap<pair<int32_t, step_list_t>> end_queue;
         
-        // Also, subpaths only keep track of their nexts, so we need to invert
-        // that so we can get all valid prev subpaths.
-        vector<vector<pair<int64_t, int32_t>>> prev_subpaths(multipath_aln.subpath_size());
+        // Subpaths only keep track of their nexts, but the DAG has them inverted
+        // so we can get all valid prev subpaths.
         
         for (int64_t i = 0; i < multipath_aln.subpath_size(); i++) {
             // For each subpath
@@ -1207,9 +1255,6 @@ namespace vg {
             for (auto& next_subpath : multipath_aln.subpath(i).next()) {
                 // For each next subpath it lists
                 
-                // Register this subpath as a predecessor of the next
-                prev_subpaths[next_subpath].emplace_back(i, 0);
-                
                 if (multipath_aln.subpath(next_subpath).score() >= 0) {
                     // This successor has a nonnegative score, so taking it
                     // after us would generate a longer, same- or
@@ -1221,9 +1266,6 @@ namespace vg {
             
             for (const auto& connection : multipath_aln.subpath(i).connection()) {
                 
-                // register the connection
-                prev_subpaths[connection.next()].emplace_back(i, connection.score());
-                
                 if (multipath_aln.subpath(connection.next()).score() + connection.score() >= 0) {
                     // Taking the connection would lead to a longer or better alignment
                     valid_traceback_start = false;
@@ -1369,7 +1411,7 @@ namespace vg {
                     // To compute the additional score difference, we need to know what our optimal prefix score was.
                     auto& best_prefix_score = problem.prefix_score[here];
                     
-                    for (auto& prev : prev_subpaths[here]) {
+                    for (auto& prev : dag.predecessors(here)) {
                         // For each candidate previous subpath
                         
                         if (subpath_is_used[prev.first]) {
@@ -1440,7 +1482,8 @@ namespace vg {
         
         // Fill out the dynamic programming problem
         // TODO: are we duplicating work if we also get the top alignment?
-        auto dp_result = run_multipath_dp(multipath_aln);
+        const SubpathDAG& dag = SubpathDAG::workspace(multipath_aln);
+        auto dp_result = run_multipath_dp(multipath_aln, dag);
         // Get the filled DP problem
         MultipathProblem& problem = get<0>(dp_result);
         // And the optimal final subpath
@@ -1729,12 +1772,9 @@ namespace vg {
             }
         };
         
-        // Also, subpaths only keep track of their nexts, so we need to invert
-        // that so we can get all valid prev subpaths.
+        // Subpaths only keep track of their nexts, but the DAG has them inverted
+        // so we can get all valid prev subpaths.
         // TODO: This code is also duplicated
-        vector<vector<pair<int64_t, int32_t>>> prev_subpaths;
-        
-        prev_subpaths.resize(multipath_aln.subpath_size());
         for (int64_t i = 0; i < multipath_aln.subpath_size(); i++) {
             // For each subpath
             
@@ -1744,9 +1784,6 @@ namespace vg {
             for (auto& next_subpath : multipath_aln.subpath(i).next()) {
                 // For each next subpath it lists
                 
-                // Register this subpath as a predecessor of the next
-                prev_subpaths[next_subpath].emplace_back(i, 0);
-                
                 if (multipath_aln.subpath(next_subpath).score() >= 0) {
                     // This successor has a nonnegative score, so taking it
                     // after us would generate a longer, same- or
@@ -1758,9 +1795,6 @@ namespace vg {
             
             for (const auto& connection : multipath_aln.subpath(i).connection()) {
                 
-                // register the connection
-                prev_subpaths[connection.next()].emplace_back(i, connection.score());
-                
                 if (multipath_aln.subpath(connection.next()).score() + connection.score() >= 0) {
                     // Taking the connection would lead to a longer or better alignment
                     valid_traceback_start = false;
@@ -1835,7 +1869,7 @@ namespace vg {
                 // To compute the additional score difference, we need to know what our optimal prefix score was.
                 auto& best_prefix_score = problem.prefix_score[here];
                 
-                for (auto& prev : prev_subpaths[here]) {
+                for (auto& prev : dag.predecessors(here)) {
                     // For each possible previous location
                     
                     // Compute the score of the optimal alignment ending at that predecessor
@@ -2203,6 +2237,7 @@ namespace vg {
         proto_multipath_aln_out.clear_subpath();
         proto_multipath_aln_out.clear_start();
         transfer_read_metadata(multipath_aln, proto_multipath_aln_out);
+        proto_multipath_aln_out.mutable_subpath()->Reserve(multipath_aln.subpath_size());
         for (const auto& subpath : multipath_aln.subpath()) {
             auto subpath_copy = proto_multipath_aln_out.add_subpath();
             subpath_copy->set_score(subpath.score());
@@ -2230,7 +2265,8 @@ namespace vg {
         multipath_aln_out.clear_subpath();
         multipath_aln_out.clear_start();
         transfer_read_metadata(proto_multipath_aln, multipath_aln_out);
-        for (auto subpath : proto_multipath_aln.subpath()) {
+        multipath_aln_out.mutable_subpath()->reserve(proto_multipath_aln.subpath_size());
+        for (const auto& subpath : proto_multipath_aln.subpath()) {
             auto subpath_copy = multipath_aln_out.add_subpath();
             subpath_copy->set_score(subpath.score());
             for (auto next : subpath.next()) {
@@ -2242,9 +2278,7 @@ namespace vg {
                 connection_copy->set_score(connection.score());
             }
             if (subpath.has_path()) {
-                auto path = subpath.path();
-                auto path_copy = subpath_copy->mutable_path();
-                from_proto_path(path, *path_copy);
+                from_proto_path(subpath.path(), *subpath_copy->mutable_path());
             }
         }
         
@@ -136,6 +136,47 @@ namespace vg {
         map<string, pair<anno_type_t, void*>> _annotation;
     };
 
+    /// A flattened, read-only view of the subpath DAG in a multipath alignment,
+    /// with predecessors in compressed sparse row layout and the per-subpath
+    /// quantities that the DP needs pulled out of the nested paths. The
+    /// buffers are kept between uses so that tracebacks on many alignments
+    /// don't allocate each time.
+    struct SubpathDAG {
+        // the score of each subpath
+        vector<int32_t> score;
+        // the read length of each subpath
+        vector<int64_t> length;
+        // the predecessors of subpath i are in the range [pred_begin[i], pred_begin[i + 1])
+        // of pred, as pairs of (predecessor index, connection score or 0 for an edge), in
+        // the order in which the predecessors list them
+        vector<size_t> pred_begin;
+        vector<pair<int64_t, int32_t>> pred;
+        
+        /// A range over the predecessors of one subpath
+        struct PredecessorRange {
+            const pair<int64_t, int32_t>* from;
+            const pair<int64_t, int32_t>* to;
+            const pair<int64_t, int32_t>* begin() const { return from; }
+            const pair<int64_t, int32_t>* end() const { return to; }
+            bool empty() const { return from == to; }
+        };
+        
+        /// Fill in the DAG for a multipath alignment, replacing the current contents
+        void build(const multipath_alignment_t& multipath_aln);
+        
+        /// Get the predecessors of a subpath
+        inline PredecessorRange predecessors(size_t i) const {
+            return PredecessorRange{pred.data() + pred_begin[i], pred.data() + pred_begin[i + 1]};
+        }
+        
+        /// Get the DAG workspace for this thread, rebuilt for the given multipath alignment.
+        /// It remains valid until the next call on the same thread.
+        static SubpathDAG& workspace(const multipath_alignment_t& multipath_aln);
+        
+    private:
+        vector<size_t> fill_scratch;
+    };
+
     string debug_string(const connection_t& connection);
     string debug_string(const subpath_t& subpath);
     string debug_string(const multipath_alignment_t& multipath_aln);
@@ -5250,20 +5250,13 @@ void MultipathAlignmentGraph::align(const Alignment& alignment, const HandleGrap
         cerr << "doing DP between MEMs" << endl;
 #endif
         
-        // perform alignment in the intervening sections
-        for (int64_t j = 0; j < path_nodes.size(); j++) {
-#ifdef debug_multipath_alignment
-            cerr << "checking for intervening alignments from match node " << j << " with path " << debug_string(path_nodes.at(j).path) << " and sequence ";
-            for (auto iter = path_nodes.at(j).begin; iter != path_nodes.at(j).end; iter++) {
-                cerr << *iter;
-            }
-            cerr << endl;
-#endif
-            
-            PathNode& src_path_node = path_nodes.at(j);
-            subpath_t* src_subpath = multipath_aln_out.mutable_subpath(j);
+        // collect all of the alignment problems in the intervening sections so that we can solve them
+        // as a batch, which lets identical problems (common in tandem repeats) share one DP
+        vector<GapAlignmentProblem> gap_problems;
+        for (size_t j = 0; j < path_nodes.size(); j++) {
             
-            const path_t& path = src_subpath->path();
+            const PathNode& src_path_node = path_nodes.at(j);
+            const path_t& path = multipath_aln_out.subpath(j).path();
             const path_mapping_t& final_mapping = path.mapping(path.mapping_size() - 1);
             const position_t& final_mapping_position = final_mapping.position();
             // make a pos_t that points to the final base in the match
@@ -5274,133 +5267,91 @@ void MultipathAlignmentGraph::align(const Alignment& alignment, const HandleGrap
             // the longest gap that could be detected at this position in the read
             size_t src_max_gap = aligner->longest_detectable_gap(alignment, src_path_node.end);
             
-            // This holds edges that we remove, because we couldn't actually get an alignment across them with a positive score.
-            unordered_set<pair<size_t, size_t>> edges_for_removal;
-            
             for (const pair<size_t, size_t>& edge : src_path_node.edges) {
-                PathNode& dest_path_node = path_nodes.at(edge.first);
-                pos_t dest_pos = make_pos_t(multipath_aln_out.subpath(edge.first).path().mapping(0).position());
+                const PathNode& dest_path_node = path_nodes.at(edge.first);
                 
-#ifdef debug_multipath_alignment
-                cerr << "forming intervening alignment for edge to node " << edge.first << endl;
-#endif
+                gap_problems.emplace_back();
+                auto& problem = gap_problems.back();
+                problem.from = j;
+                problem.to = edge.first;
+                problem.src_pos = src_pos;
+                problem.dest_pos = make_pos_t(multipath_aln_out.subpath(edge.first).path().mapping(0).position());
+                problem.begin = src_path_node.end;
+                problem.end = dest_path_node.begin;
                 
                 size_t intervening_length = dest_path_node.begin - src_path_node.end;
-
+                
                 // if negative score is allowed set maximum distance to the length between path nodes
-                // otherwise set it to the maximum gap length possible while retaining a positive score 
-                size_t max_dist = allow_negative_scores ?
+                // otherwise set it to the maximum gap length possible while retaining a positive score
+                problem.max_dist = allow_negative_scores ?
                     edge.second :
                     intervening_length + min(min(src_max_gap, aligner->longest_detectable_gap(alignment, dest_path_node.begin)), max_gap);
                 
 #ifdef debug_multipath_alignment
-                cerr << "read dist: " << intervening_length << ", graph dist " << edge.second << " source max gap: " << src_max_gap << ", dest max gap " << aligner->longest_detectable_gap(alignment, dest_path_node.begin) << ", max allowed gap " << max_gap << endl;
+                cerr << "gap problem from " << j << " to " << edge.first << ": read dist " << intervening_length << ", graph dist " << edge.second << ", max dist " << problem.max_dist << endl;
 #endif
+            }
+        }
+        
+#ifdef debug_multipath_alignment
+        cerr << "doing DP for " << gap_problems.size() << " gaps between MEMs" << endl;
+#endif
+        
+        // do all of the DP at once
+        vector<size_t> solution_idx;
+        auto gap_solutions = align_gap_problems(alignment, align_graph, aligner, gap_problems, max_alt_alns,
+                                                dynamic_alt_alns, band_padding_function, align_in_reverse,
+                                                solution_idx);
+        
+        // count how many times each solution will be used, so that we can move out of it on the last use
+        vector<size_t> uses_remaining(gap_solutions.size(), 0);
+        for (size_t idx : solution_idx) {
+            ++uses_remaining[idx];
+        }
+        
+        // convert the solutions into subpaths, in the same order that the edges occur
+        for (size_t i = 0, j = 0; j < path_nodes.size(); j++) {
+            
+            PathNode& src_path_node = path_nodes.at(j);
+            
+            // This holds edges that we remove, because we couldn't actually get an alignment across them with a positive score.
+            unordered_set<pair<size_t, size_t>> edges_for_removal;
+            
+            for (const pair<size_t, size_t>& edge : src_path_node.edges) {
                 
-                // extract the graph between the matches
-                bdsg::HashGraph connecting_graph;
-                auto connect_trans = algorithms::extract_connecting_graph(&align_graph,      // DAG with split strands
-                                                                          &connecting_graph, // graph to extract into
-                                                                          max_dist,          // longest distance necessary
-                                                                          src_pos,           // end of earlier match
-                                                                          dest_pos,          // beginning of later match
-                                                                          false);            // do not enforce max distance strictly
-                                
-                if (connecting_graph.get_node_count() == 0) {
+                const GapAlignmentProblem& problem = gap_problems[i];
+                auto& solution = gap_solutions[solution_idx[i]];
+                bool last_use = (--uses_remaining[solution_idx[i]] == 0);
+                ++i;
+                
+                if (!solution.connectable) {
                     // the MEMs weren't connectable with a positive score after all, mark the edge for removal
 #ifdef debug_multipath_alignment
                     cerr << "Remove edge " << j << " -> " << edge.first << " because we got no nodes in the connecting graph "
-                        << src_pos << " to " << dest_pos << endl;
+                        << problem.src_pos << " to " << problem.dest_pos << endl;
 #endif
                     edges_for_removal.insert(edge);
                     continue;
                 }
                 
-                size_t num_alt_alns = dynamic_alt_alns ? min(max_alt_alns, handlealgs::count_walks(&connecting_graph)) :
-                                                         max_alt_alns;
-                
-                
-                // transfer the substring between the matches to a new alignment
-                Alignment intervening_sequence;
-                intervening_sequence.set_sequence(alignment.sequence().substr(src_path_node.end - alignment.sequence().begin(),
-                                                                              dest_path_node.begin - src_path_node.end));
-                if (!alignment.quality().empty()) {
-                    intervening_sequence.set_quality(alignment.quality().substr(src_path_node.end - alignment.sequence().begin(),
-                                                                                dest_path_node.begin - src_path_node.end));
-                }
-                
-                // if we're doing dynamic alt alignments, possibly expand the number of tracebacks until we get an
-                // alignment to every path or hit the hard max
-                vector<pair<path_t, int32_t>> deduplicated;
-                if (num_alt_alns > 0) {
-                    
-                    size_t num_alns_iter = num_alt_alns;
-                    while (deduplicated.size() < num_alt_alns) {
-                        
-                        intervening_sequence.clear_path();
-                        
-#ifdef debug_multipath_alignment
-                        cerr << "making " << num_alns_iter << " alignments of sequence " << intervening_sequence.sequence() << " to connecting graph" << endl;
-                        connecting_graph.for_each_handle([&](const handle_t& handle) {
-                            cerr << connecting_graph.get_id(handle) << " " << connecting_graph.get_sequence(handle) << endl;
-                            connecting_graph.follow_edges(handle, true, [&](const handle_t& prev) {
-                                cerr << "\t" << connecting_graph.get_id(prev) << " <-" << endl;
-                            });
-                            connecting_graph.follow_edges(handle, false, [&](const handle_t& next) {
-                                cerr << "\t-> " << connecting_graph.get_id(next) << endl;
-                            });
-                        });
-#endif
-                        
-                        // possibly the reverse the sequence
-                        HandleGraph* aln_connecting_graph = &connecting_graph;
-                        ReverseGraph reverse_graph(&connecting_graph, false);
-                        if (align_in_reverse) {
-                            reverse_alignment(intervening_sequence);
-                            aln_connecting_graph = &reverse_graph;
-                        }
-                        vector<Alignment> alt_alignments;
-                        aligner->align_global_banded_multi(intervening_sequence, alt_alignments, *aln_connecting_graph, num_alns_iter,
-                                                           band_padding_function(intervening_sequence, connecting_graph), true);
-                        if (align_in_reverse) {
-                            for (auto& aln : alt_alignments) {
-                                reverse_alignment(aln);
-                            }
-                        }
-                        
-                        // remove alignments with the same path
-                        deduplicated = convert_and_deduplicate(alt_alignments, false, false);
-                        
-                        if (num_alns_iter >= max_alt_alns || !dynamic_alt_alns) {
-                            // we don't want to try again even if we didn't find every path yet
-                            break;
-                        }
-                        else {
-                            // if we didn't find every path, we'll try again with this many tracebacks
-                            num_alns_iter = min(max_alt_alns, num_alns_iter * 2);
-                        }
-                    }
-                }
-                
                 bool added_direct_connection = false;
-                for (auto& connecting_alignment : deduplicated) {
+                for (auto& connecting_alignment : solution.alignments) {
 #ifdef debug_multipath_alignment
                     cerr << "translating connecting alignment: " << debug_string(connecting_alignment.first) << ", score " << connecting_alignment.second << endl;
 #endif
                     
-                    auto& aligned_path = connecting_alignment.first;
-                    const auto& first_mapping = aligned_path.mapping(0);
-                    const auto& last_mapping = aligned_path.mapping(aligned_path.mapping_size() - 1);
+                    const auto& first_mapping = connecting_alignment.first.mapping(0);
+                    const auto& last_mapping = connecting_alignment.first.mapping(connecting_alignment.first.mapping_size() - 1);
                     
                     bool add_first_mapping = mapping_from_length(first_mapping) != 0 || mapping_to_length(first_mapping) != 0;
                     bool add_last_mapping = mapping_from_length(last_mapping) != 0 || mapping_to_length(last_mapping) != 0;
                     
-                    if (!(add_first_mapping || add_last_mapping) && aligned_path.mapping_size() <= 2) {
+                    if (!(add_first_mapping || add_last_mapping) && connecting_alignment.first.mapping_size() <= 2) {
                         if (!added_direct_connection) {
                             // edge case where there is a simple split but other non-simple edges intersect the target
                             // at the same place (so it passes the previous deduplicating filter)
                             // it actually doesn't need an alignment, just a connecting edge
-                            src_subpath->add_next(edge.first);
+                            multipath_aln_out.mutable_subpath(j)->add_next(edge.first);
                             added_direct_connection = true;
                         }
                         continue;
@@ -5410,29 +5361,34 @@ void MultipathAlignmentGraph::align(const Alignment& alignment, const HandleGrap
                     subpath_t* connecting_subpath = multipath_aln_out.add_subpath();
                     connecting_subpath->set_score(connecting_alignment.second);
                     
-                    // get a pointer to the subpath again in case the vector reallocated
-                    src_subpath = multipath_aln_out.mutable_subpath(j);
+                    // other edges may still need this solution if it was shared, so we can only
+                    // steal the path on its final use
+                    path_t* aligned_path = connecting_subpath->mutable_path();
+                    if (last_use) {
+                        *aligned_path = move(connecting_alignment.first);
+                    }
+                    else {
+                        *aligned_path = connecting_alignment.first;
+                    }
                     
                     // get rid of the ends if they are empty
                     if (!add_last_mapping) {
-                        aligned_path.mutable_mapping()->pop_back();
+                        aligned_path->mutable_mapping()->pop_back();
                     }
-                    if (!add_first_mapping && !aligned_path.mapping().empty()) {
-                        aligned_path.mutable_mapping()->erase(aligned_path.mutable_mapping()->begin());
+                    if (!add_first_mapping && !aligned_path->mapping().empty()) {
+                        aligned_path->mutable_mapping()->erase(aligned_path->mutable_mapping()->begin());
                     }
                     
-                    *connecting_subpath->mutable_path() = move(aligned_path);
-                    
                     // add the appropriate connections
-                    src_subpath->add_next(multipath_aln_out.subpath_size() - 1);
+                    multipath_aln_out.mutable_subpath(j)->add_next(multipath_aln_out.subpath_size() - 1);
                     connecting_subpath->add_next(edge.first);
                     
                     // translate the path into the space of the main graph unless the path is null
-                    if (connecting_subpath->path().mapping_size() != 0) {
-                        translate_node_ids(*connecting_subpath->mutable_path(), connect_trans);
-                        path_mapping_t* first_subpath_mapping = connecting_subpath->mutable_path()->mutable_mapping(0);
-                        if (first_subpath_mapping->position().node_id() == final_mapping.position().node_id()) {
-                            first_subpath_mapping->mutable_position()->set_offset(offset(src_pos));
+                    if (aligned_path->mapping_size() != 0) {
+                        translate_node_ids(*aligned_path, solution.connect_trans);
+                        path_mapping_t* first_subpath_mapping = aligned_path->mutable_mapping(0);
+                        if (first_subpath_mapping->position().node_id() == id(problem.src_pos)) {
+                            first_subpath_mapping->mutable_position()->set_offset(offset(problem.src_pos));
                         }
                     }
                     
@@ -5612,6 +5568,120 @@ void MultipathAlignmentGraph::align(const Alignment& alignment, const HandleGrap
         }
     }
 
+    vector<MultipathAlignmentGraph::GapAlignmentSolution>
+    MultipathAlignmentGraph::align_gap_problems(const Alignment& alignment, const HandleGraph& align_graph,
+                                                const GSSWAligner* aligner, const vector<GapAlignmentProblem>& problems,
+                                                size_t max_alt_alns, bool dynamic_alt_alns,
+                                                const function<size_t(const Alignment&,const HandleGraph&)>& band_padding_function,
+                                                bool align_in_reverse, vector<size_t>& solution_idx_out) const {
+        
+        vector<GapAlignmentSolution> solutions;
+        solution_idx_out.clear();
+        solution_idx_out.reserve(problems.size());
+        
+        // the DP result is fully determined by the graph positions, the extraction distance, and the
+        // read sequence/quality in between, so problems that agree on all of these can share a solution
+        // even if they come from different parts of the read
+        map<tuple<pos_t, pos_t, size_t, string, string>, size_t> solution_memo;
+        
+        // these get reused across every problem in the batch rather than reallocated
+        Alignment intervening_sequence;
+        vector<Alignment> alt_alignments;
+        
+        for (const GapAlignmentProblem& problem : problems) {
+            
+            size_t seq_begin = problem.begin - alignment.sequence().begin();
+            size_t seq_len = problem.end - problem.begin;
+            
+            tuple<pos_t, pos_t, size_t, string, string> key(problem.src_pos, problem.dest_pos, problem.max_dist,
+                                                            alignment.sequence().substr(seq_begin, seq_len),
+                                                            alignment.quality().empty() ? string() :
+                                                            alignment.quality().substr(seq_begin, seq_len));
+            
+            auto memo_iter = solution_memo.find(key);
+            if (memo_iter != solution_memo.end()) {
+#ifdef debug_multipath_alignment
+                cerr << "gap problem from " << problem.from << " to " << problem.to << " shares solution " << memo_iter->second << endl;
+#endif
+                solution_idx_out.push_back(memo_iter->second);
+                continue;
+            }
+            
+            solution_idx_out.push_back(solutions.size());
+            solutions.emplace_back();
+            GapAlignmentSolution& solution = solutions.back();
+            
+            // extract the graph between the matches
+            bdsg::HashGraph connecting_graph;
+            solution.connect_trans = algorithms::extract_connecting_graph(&align_graph,      // DAG with split strands
+                                                                          &connecting_graph, // graph to extract into
+                                                                          problem.max_dist,  // longest distance necessary
+                                                                          problem.src_pos,   // end of earlier match
+                                                                          problem.dest_pos,  // beginning of later match
+                                                                          false);            // do not enforce max distance strictly
+            
+            solution.connectable = (connecting_graph.get_node_count() != 0);
+            if (solution.connectable) {
+                
+                size_t num_alt_alns = dynamic_alt_alns ? min(max_alt_alns, handlealgs::count_walks(&connecting_graph)) :
+                                                         max_alt_alns;
+                
+                // transfer the substring between the matches to the alignment
+                intervening_sequence.set_sequence(get<3>(key));
+                intervening_sequence.set_quality(get<4>(key));
+                
+                // if we're doing dynamic alt alignments, possibly expand the number of tracebacks until we get an
+                // alignment to every path or hit the hard max
+                size_t num_alns_iter = num_alt_alns;
+                while (solution.alignments.size() < num_alt_alns) {
+                    
+                    intervening_sequence.clear_path();
+                    alt_alignments.clear();
+                    
+                    // possibly the reverse the sequence
+                    HandleGraph* aln_connecting_graph = &connecting_graph;
+                    ReverseGraph reverse_graph(&connecting_graph, false);
+                    if (align_in_reverse) {
+                        reverse_alignment(intervening_sequence);
+                        aln_connecting_graph = &reverse_graph;
+                    }
+                    aligner->align_global_banded_multi(intervening_sequence, alt_alignments, *aln_connecting_graph, num_alns_iter,
+                                                       band_padding_function(intervening_sequence, connecting_graph), true);
+                    if (align_in_reverse) {
+                        // flip the sequence back to forward so that a retry doesn't align it in the wrong orientation
+                        reverse_alignment(intervening_sequence);
+                        for (auto& aln : alt_alignments) {
+                            reverse_alignment(aln);
+                        }
+                    }
+                    
+                    // remove alignments with the same path (starting from empty paths, since the
+                    // conversion appends and a previous round may have left some behind)
+                    solution.alignments.clear();
+                    solution.alignments.resize(alt_alignments.size());
+                    for (size_t k = 0; k < alt_alignments.size(); ++k) {
+                        solution.alignments[k].second = alt_alignments[k].score();
+                        from_proto_path(alt_alignments[k].path(), solution.alignments[k].first);
+                    }
+                    deduplicate_alt_alns(solution.alignments, false, false);
+                    
+                    if (num_alns_iter >= max_alt_alns || !dynamic_alt_alns) {
+                        // we don't want to try again even if we didn't find every path yet
+                        break;
+                    }
+                    else {
+                        // if we didn't find every path, we'll try again with this many tracebacks
+                        num_alns_iter = min(max_alt_alns, num_alns_iter * 2);
+                    }
+                }
+            }
+            
+            solution_memo[move(key)] = solution_idx_out.back();
+        }
+        
+        return solutions;
+    }
+    
     void MultipathAlignmentGraph::add_decomposed_tail_alignments(const Alignment& alignment, const HandleGraph& align_graph,
                                                                  multipath_alignment_t& multipath_aln_out,
                                                                  unordered_set<size_t>& prohibited_merges,
@@ -322,6 +322,42 @@ namespace vg {
                     size_t max_alt_alns, bool dynamic_alt_alns, size_t max_gap, double pessimistic_tail_gap_multiplier,
                     size_t min_paths, size_t max_tail_length, unordered_set<size_t>* sources = nullptr);
         
+        /// An alignment problem in the read interval between two anchoring paths
+        struct GapAlignmentProblem {
+            /// Path node index of the earlier anchor
+            size_t from;
+            /// Path node index of the later anchor
+            size_t to;
+            /// Position just past the end of the earlier anchor
+            pos_t src_pos;
+            /// Position at the start of the later anchor
+            pos_t dest_pos;
+            /// Maximum distance to search for connecting paths
+            size_t max_dist;
+            /// Read interval between the anchors
+            string::const_iterator begin;
+            string::const_iterator end;
+        };
+        
+        /// The alignments that connect across a GapAlignmentProblem
+        struct GapAlignmentSolution {
+            /// False if there was no connecting graph
+            bool connectable = false;
+            /// Deduplicated alignments in the space of the connecting graph
+            vector<pair<path_t, int32_t>> alignments;
+            /// Translation from the connecting graph back to the align graph
+            unordered_map<id_t, id_t> connect_trans;
+        };
+        
+        /// Solve a batch of GapAlignmentProblems. Problems that are identical in graph position,
+        /// extraction distance, and read sequence share a single solution. Fills the solution
+        /// index vector with the index of the solution for each problem.
+        vector<GapAlignmentSolution> align_gap_problems(const Alignment& alignment, const HandleGraph& align_graph,
+                                                        const GSSWAligner* aligner, const vector<GapAlignmentProblem>& problems,
+                                                        size_t max_alt_alns, bool dynamic_alt_alns,
+                                                        const function<size_t(const Alignment&,const HandleGraph&)>& band_padding_function,
+                                                        bool align_in_reverse, vector<size_t>& solution_idx_out) const;
+        
         /// Removes alignments that follow the same path through the graph, retaining only the
         /// highest scoring ones. If deduplicating leftward, then also removes paths that take a
         /// longer path for no greater score in the leftward direction. Vice versa for rightward.
@@ -38,6 +38,7 @@
 #include "reverse_graph.hpp"
 #include "split_strand_graph.hpp"
 #include "dagified_graph.hpp"
+#include "subgraph_overlay.hpp"
 
 #include "algorithms/count_covered.hpp"
 #include "algorithms/extract_containing_graph.hpp"
@@ -46,6 +47,7 @@
 #include "algorithms/ref_path_distance.hpp"
 #include "algorithms/component.hpp"
 #include "algorithms/pad_band.hpp"
+#include "algorithms/graph_edit_distance.hpp"
 
 namespace vg {
     
@@ -374,6 +376,25 @@ namespace vg {
         }
     }
 
+    void MultipathMapper::find_mems(const Alignment& alignment1, const Alignment& alignment2,
+                                    vector<MaximalExactMatch>& mems1_out, vector<MaximalExactMatch>& mems2_out,
+                                    vector<deque<pair<string::const_iterator, char>>>* mem_fanout_breaks1,
+                                    vector<deque<pair<string::const_iterator, char>>>* mem_fanout_breaks2) {
+        if (use_stripped_match_alg && !use_fanout_match_alg) {
+            // the strips of both reads are independent searches
+            auto pair_mems = find_stripped_matches_batch({make_pair(alignment1.sequence().begin(), alignment1.sequence().end()),
+                                                          make_pair(alignment2.sequence().begin(), alignment2.sequence().end())},
+                                                         stripped_match_alg_strip_length, stripped_match_alg_max_length,
+                                                         stripped_match_alg_target_count);
+            mems1_out = move(pair_mems[0]);
+            mems2_out = move(pair_mems[1]);
+        }
+        else {
+            mems1_out = find_mems(alignment1, mem_fanout_breaks1);
+            mems2_out = find_mems(alignment2, mem_fanout_breaks2);
+        }
+    }
+
     vector<pair<pair<size_t, size_t>, int64_t>> MultipathMapper::get_cluster_pairs(const Alignment& alignment1,
                                                                                    const Alignment& alignment2,
                                                                                    vector<clustergraph_t>& cluster_graphs1,
@@ -479,7 +500,7 @@ namespace vg {
             double multiplicity = cluster_multiplicity(get<1>(cluster_graph));
             size_t cluster_size = get<1>(cluster_graph).first.size();
             multipath_alns_out.emplace_back();
-            multipath_align(alignment, cluster_graph, multipath_alns_out.back(), fanouts);
+            prefiltered_multipath_align(alignment, cluster_graph, multipath_alns_out.back(), fanouts);
             multiplicities_out.emplace_back(multiplicity);
             num_mappings++;
         }
@@ -536,6 +557,27 @@ namespace vg {
 #endif
         sort_and_compute_mapping_quality(multipath_alns_out, cluster_idxs, &multiplicities_out);
         
+        // the placeholders for prefiltered clusters have done their part in the mapping quality, but
+        // they aren't alignments to report
+        size_t num_kept = 0;
+        for (size_t i = 0; i < multipath_alns_out.size(); ++i) {
+            if (prefilter_score_bound(multipath_alns_out[i]) < 0) {
+                if (num_kept != i) {
+                    multipath_alns_out[num_kept] = move(multipath_alns_out[i]);
+                    multiplicities_out[num_kept] = multiplicities_out[i];
+                    if (cluster_idxs) {
+                        (*cluster_idxs)[num_kept] = (*cluster_idxs)[i];
+                    }
+                }
+                ++num_kept;
+            }
+        }
+        multipath_alns_out.resize(num_kept);
+        multiplicities_out.resize(num_kept);
+        if (cluster_idxs) {
+            cluster_idxs->resize(num_kept);
+        }
+        
         if (!multipath_alns_out.empty() && likely_mismapping(multipath_alns_out.front())) {
             multipath_alns_out.front().set_mapping_quality(0);
         }
@@ -660,18 +702,8 @@ namespace vg {
         return !is_ambiguous;
     }
     
-    bool MultipathMapper::attempt_rescue(const multipath_alignment_t& multipath_aln, const Alignment& other_aln,
-                                         bool rescue_forward, multipath_alignment_t& rescue_multipath_aln) {
-        
-#ifdef debug_multipath_mapper
-        cerr << "attemping pair rescue in " << (rescue_forward ? "forward" : "backward") << " direction from " << debug_string(multipath_aln) << endl;
-#endif
-        bool succeeded = do_rescue_alignment(multipath_aln, other_aln, rescue_forward, rescue_multipath_aln,
-                                             fragment_length_distr.mean(), rescue_graph_std_devs);
-        
-        if (!succeeded) {
-            return false;
-        }
+    bool MultipathMapper::validate_rescue(const multipath_alignment_t& multipath_aln, const Alignment& other_aln,
+                                          multipath_alignment_t& rescue_multipath_aln) {
         
         auto aligner = get_aligner(!multipath_aln.quality().empty() && !other_aln.quality().empty());
         vector<double> score(1, optimal_alignment_score(rescue_multipath_aln));
@@ -702,13 +734,103 @@ namespace vg {
         
         return true;
     }
+    
+    void MultipathMapper::attempt_rescues(const vector<tuple<const multipath_alignment_t*, const Alignment*, bool>>& rescue_attempts,
+                                          vector<multipath_alignment_t>& rescue_multipath_alns_out,
+                                          vector<bool>& rescued_out) {
+        
+        rescue_multipath_alns_out.clear();
+        rescue_multipath_alns_out.resize(rescue_attempts.size());
+        rescued_out.clear();
+        rescued_out.resize(rescue_attempts.size(), false);
+        
+        // attempts that would align the same read to the same window share one rescue alignment
+        vector<size_t> unique_attempts;
+        vector<size_t> attempt_to_unique(rescue_attempts.size());
+        {
+            unordered_map<pair<string, const Alignment*>, size_t> window_to_unique;
+            for (size_t i = 0; i < rescue_attempts.size(); ++i) {
+                const auto& attempt = rescue_attempts[i];
+                auto key = make_pair(rescue_window_key(*get<0>(attempt), get<2>(attempt)), get<1>(attempt));
+                auto iter = window_to_unique.find(key);
+                if (iter == window_to_unique.end()) {
+                    iter = window_to_unique.emplace(key, unique_attempts.size()).first;
+                    unique_attempts.push_back(i);
+                }
+                attempt_to_unique[i] = iter->second;
+            }
+        }
+        
+#ifdef debug_multipath_mapper
+        cerr << "performing " << unique_attempts.size() << " unique rescue alignments for " << rescue_attempts.size() << " rescue attempts" << endl;
+#endif
+        
+        vector<multipath_alignment_t> unique_rescue_alns(unique_attempts.size());
+        vector<bool> unique_succeeded(unique_attempts.size(), false);
+        double rescue_mean_length = fragment_length_distr.mean();
+        for (size_t i = 0; i < unique_attempts.size(); ++i) {
+            const auto& attempt = rescue_attempts[unique_attempts[i]];
+            unique_succeeded[i] = do_rescue_alignment(*get<0>(attempt), *get<1>(attempt), get<2>(attempt),
+                                                      unique_rescue_alns[i], rescue_mean_length, rescue_graph_std_devs);
+        }
+        
+        // the mapping quality of a rescue depends on its anchor, so validate each attempt separately
+        for (size_t i = 0; i < rescue_attempts.size(); ++i) {
+            size_t j = attempt_to_unique[i];
+            if (!unique_succeeded[j]) {
+                continue;
+            }
+            if (unique_attempts[j] == i) {
+                rescue_multipath_alns_out[i] = unique_rescue_alns[j];
+            }
+            else {
+                rescue_multipath_alns_out[i] = rescue_multipath_alns_out[unique_attempts[j]];
+            }
+            const auto& attempt = rescue_attempts[i];
+            rescued_out[i] = validate_rescue(*get<0>(attempt), *get<1>(attempt), rescue_multipath_alns_out[i]);
+        }
+    }
+    
+    string MultipathMapper::rescue_window_key(const multipath_alignment_t& multipath_aln, bool rescue_forward) const {
+        Alignment opt_anchoring_aln;
+        optimal_alignment(multipath_aln, opt_anchoring_aln);
+        
+        string key(1, rescue_forward ? '+' : '-');
+        if (opt_anchoring_aln.path().mapping_size() == 0) {
+            return key;
+        }
+        if (get_rescue_graph_from_paths || !distance_index) {
+            // the window only depends on the position we jump from
+            pos_t pos_from = rescue_forward ? initial_position(opt_anchoring_aln.path()) : final_position(opt_anchoring_aln.path());
+            key += to_string(id(pos_from)) + (is_rev(pos_from) ? "-" : "+") + to_string(offset(pos_from));
+        }
+        else {
+            // the window depends on the whole anchoring path
+            key += opt_anchoring_aln.path().SerializeAsString();
+        }
+        return key;
+    }
 
     bool MultipathMapper::do_rescue_alignment(const multipath_alignment_t& multipath_aln, const Alignment& other_aln,
                                               bool rescue_forward, multipath_alignment_t& rescue_multipath_aln,
                                               double rescue_mean_length, double num_std_devs) const {
-        bdsg::HashGraph rescue_graph;
-        extract_rescue_graph(multipath_aln, other_aln, rescue_forward, &rescue_graph,
-                             rescue_mean_length, rescue_graph_std_devs);
+        if (get_rescue_graph_from_paths || !distance_index) {
+            bdsg::HashGraph rescue_graph;
+            extract_rescue_graph(multipath_aln, other_aln, rescue_forward, &rescue_graph,
+                                 rescue_mean_length, rescue_graph_std_devs);
+            return align_to_rescue_graph(rescue_graph, multipath_aln, other_aln, rescue_multipath_aln);
+        }
+        else {
+            // we can view the rescue window directly in the graph instead of copying it out
+            unordered_set<id_t> rescue_nodes;
+            extract_rescue_nodes(multipath_aln, other_aln, rescue_forward, rescue_nodes, rescue_mean_length);
+            SubgraphOverlay rescue_graph(xindex, &rescue_nodes);
+            return align_to_rescue_graph(rescue_graph, multipath_aln, other_aln, rescue_multipath_aln);
+        }
+    }
+    
+    bool MultipathMapper::align_to_rescue_graph(const HandleGraph& rescue_graph, const multipath_alignment_t& multipath_aln,
+                                                const Alignment& other_aln, multipath_alignment_t& rescue_multipath_aln) const {
         
         if (rescue_graph.get_node_count() == 0) {
             return false;
@@ -798,104 +920,56 @@ namespace vg {
         if (opt_anchoring_aln.path().mapping_size() == 0) {
             return;
         }
-                
-        if (get_rescue_graph_from_paths || !distance_index) {
-            // we're either not using the distance index or we don't have one
-            pos_t pos_from = rescue_forward ? initial_position(opt_anchoring_aln.path()) : final_position(opt_anchoring_aln.path());
-            int64_t jump_dist = rescue_forward ? rescue_mean_length : -rescue_mean_length;
-            
-            // get the seed position(s) for the rescue by jumping along paths
-            vector<pos_t> jump_positions = algorithms::jump_along_closest_path(xindex, pos_from, jump_dist, 250);
-            
+        
+        pos_t pos_from = rescue_forward ? initial_position(opt_anchoring_aln.path()) : final_position(opt_anchoring_aln.path());
+        int64_t jump_dist = rescue_forward ? rescue_mean_length : -rescue_mean_length;
+        
+        // get the seed position(s) for the rescue by jumping along paths
+        vector<pos_t> jump_positions = algorithms::jump_along_closest_path(xindex, pos_from, jump_dist, 250);
+        
 #ifdef debug_multipath_mapper
-            cerr << "found jump positions:" << endl;
-            for (pos_t& pos : jump_positions) {
-                cerr << "\t" << pos << endl;
-            }
+        cerr << "found jump positions:" << endl;
+        for (pos_t& pos : jump_positions) {
+            cerr << "\t" << pos << endl;
+        }
 #endif
-            if (jump_positions.empty()) {
-                return;
-            }
-            
-            size_t search_dist_bwd, search_dist_fwd;
-            if (rescue_forward) {
-                search_dist_bwd = size_t(round(num_std_devs * fragment_length_distr.std_dev())) + other_aln.sequence().size();
-                search_dist_fwd = num_std_devs * fragment_length_distr.std_dev();
-            }
-            else {
-                search_dist_bwd = num_std_devs * fragment_length_distr.std_dev();
-                search_dist_fwd = size_t(round(num_std_devs * fragment_length_distr.std_dev())) + other_aln.sequence().size();
-            }
-            
-            vector<size_t> backward_dist(jump_positions.size(), search_dist_bwd);
-            vector<size_t> forward_dist(jump_positions.size(), search_dist_fwd);
-            algorithms::extract_containing_graph(xindex, rescue_graph, jump_positions, backward_dist, forward_dist,
-                                                 num_alt_alns > 1 ? reversing_walk_length : 0);
-            
+        if (jump_positions.empty()) {
+            return;
+        }
+        
+        size_t search_dist_bwd, search_dist_fwd;
+        if (rescue_forward) {
+            search_dist_bwd = size_t(round(num_std_devs * fragment_length_distr.std_dev())) + other_aln.sequence().size();
+            search_dist_fwd = num_std_devs * fragment_length_distr.std_dev();
         }
         else {
-            // we have a distance index and we want to use it
-            
-            // get the set of nodes that we want to extrat
-            unordered_set<id_t> subgraph_nodes_to_add;
-            int64_t min_distance = max(0.0, rescue_mean_length - other_aln.sequence().size()
-                                       - rescue_graph_std_devs * fragment_length_distr.std_dev());
-            int64_t max_distance = rescue_mean_length + rescue_graph_std_devs * fragment_length_distr.std_dev();
-            subgraph_in_distance_range(*distance_index, opt_anchoring_aln.path(), xindex, min_distance, max_distance,
-                                              subgraph_nodes_to_add, rescue_forward);
-            
-            // this algorithm is better matched to the GBWTGraph, we need to extract the subgraph manually now.
-            // we'll use an algorithm that tries to follow edges to find nodes. this way we minimize calls to XG's
-            // get_handle, and we have to follow all edges anyway to add them
-            
-            while (!subgraph_nodes_to_add.empty()) {
-                // there's at least one node that we haven't added yet
-                
-                // initialize a search out from an arbitrary unadded node
-                id_t node_id = *subgraph_nodes_to_add.begin();
-                subgraph_nodes_to_add.erase(node_id);
-                handle_t start_handle = xindex->get_handle(node_id);
-                rescue_graph->create_handle(xindex->get_sequence(start_handle),
-                                            xindex->get_id(start_handle));
-                vector<handle_t> stack(1, start_handle);
-                while (!stack.empty()) {
-                    handle_t super_handle = stack.back();
-                    stack.pop_back();
-                    for (bool go_left : {true, false}) {
-                        xindex->follow_edges(super_handle, go_left, [&](const handle_t& neighbor) {
-                            
-                            if (subgraph_nodes_to_add.count(xindex->get_id(neighbor))) {
-                                // we've found a new node that we haven't added yet, add it to the graph
-                                // and the queue, and erase from the nodes left to add
-                                subgraph_nodes_to_add.erase(xindex->get_id(neighbor));
-                                rescue_graph->create_handle(xindex->get_sequence(xindex->forward(neighbor)),
-                                                            xindex->get_id(neighbor));
-                                stack.push_back(neighbor);
-                            }
-                            
-                            if (rescue_graph->has_node(xindex->get_id(neighbor))) {
-                                // we always know that the handle we're coming from is in the subgraph, it
-                                // seems that this neighbor is as well, so add the edge
-                                
-                                handle_t sub_handle = rescue_graph->get_handle(xindex->get_id(super_handle),
-                                                                               xindex->get_is_reverse(super_handle));
-                                handle_t sub_neighbor = rescue_graph->get_handle(xindex->get_id(neighbor),
-                                                                                 xindex->get_is_reverse(neighbor));
-                                
-                                // edges automatically deduplicate, so don't worry about checking whether
-                                // it exists
-                                if (go_left) {
-                                    rescue_graph->create_edge(sub_neighbor, sub_handle);
-                                }
-                                else {
-                                    rescue_graph->create_edge(sub_handle, sub_neighbor);
-                                }
-                            }
-                        });
-                    }
-                }
-            }
+            search_dist_bwd = num_std_devs * fragment_length_distr.std_dev();
+            search_dist_fwd = size_t(round(num_std_devs * fragment_length_distr.std_dev())) + other_aln.sequence().size();
         }
+        
+        vector<size_t> backward_dist(jump_positions.size(), search_dist_bwd);
+        vector<size_t> forward_dist(jump_positions.size(), search_dist_fwd);
+        algorithms::extract_containing_graph(xindex, rescue_graph, jump_positions, backward_dist, forward_dist,
+                                             num_alt_alns > 1 ? reversing_walk_length : 0);
+    }
+    
+    void MultipathMapper::extract_rescue_nodes(const multipath_alignment_t& multipath_aln, const Alignment& other_aln,
+                                               bool rescue_forward, unordered_set<id_t>& rescue_nodes,
+                                               double rescue_mean_length) const {
+        
+        Alignment opt_anchoring_aln;
+        optimal_alignment(multipath_aln, opt_anchoring_aln);
+        
+        if (opt_anchoring_aln.path().mapping_size() == 0) {
+            return;
+        }
+        
+        // get the set of nodes within the fragment length window
+        int64_t min_distance = max(0.0, rescue_mean_length - other_aln.sequence().size()
+                                   - rescue_graph_std_devs * fragment_length_distr.std_dev());
+        int64_t max_distance = rescue_mean_length + rescue_graph_std_devs * fragment_length_distr.std_dev();
+        subgraph_in_distance_range(*distance_index, opt_anchoring_aln.path(), xindex, min_distance, max_distance,
+                                   rescue_nodes, rescue_forward);
     }
 
     void MultipathMapper::set_alignment_scores(const int8_t* score_matrix, int8_t gap_open, int8_t gap_extend,
@@ -924,6 +998,119 @@ namespace vg {
         }
     }
 
+    bool MultipathMapper::cluster_cannot_align(const Alignment& alignment, const clustergraph_t& cluster_graph,
+                                               int32_t* score_bound_out) const {
+        if (!use_edit_distance_prefilter || suppress_mismapping_detection) {
+            return false;
+        }
+        
+        const string& sequence = alignment.sequence();
+        const string& quality = alignment.quality();
+        size_t read_length = sequence.size();
+        if (read_length == 0) {
+            return false;
+        }
+        bool qual_adj = adjust_alignments_for_base_quality && !quality.empty();
+        const GSSWAligner* aligner = get_aligner(qual_adj);
+        
+        // the score of a perfect match, and the least score that each read base can lose relative to it by
+        // being part of an edit (a mismatch, an insertion or a soft-clip), using the base's quality-adjusted
+        // scores if we have them. a deletion uses no read base, but costs at least a gap extension.
+        int64_t perfect_score = (aligner->score_full_length_bonus(true, alignment)
+                                 + aligner->score_full_length_bonus(false, alignment));
+        vector<int32_t> edit_costs(read_length);
+        for (size_t i = 0; i < read_length; ++i) {
+            const int8_t* score_matrix = qual_adj ? aligner->score_matrix + 25 * quality[i] : aligner->score_matrix;
+            const int8_t* row = score_matrix + 5 * aligner->nt_table[sequence[i]];
+            int32_t match = row[aligner->nt_table[sequence[i]]];
+            int32_t max_mismatch = numeric_limits<int32_t>::min();
+            for (size_t j = 0; j < 5; ++j) {
+                if (j != aligner->nt_table[sequence[i]]) {
+                    max_mismatch = max<int32_t>(max_mismatch, row[j]);
+                }
+            }
+            perfect_score += match;
+            edit_costs[i] = max<int32_t>(0, min<int32_t>(min<int32_t>(match - max_mismatch, match), aligner->gap_extension));
+        }
+        
+        // the n-th edit costs at least the n-th cheapest of these, so the best score with an edit
+        // distance of d is at most the perfect score minus the d cheapest costs
+        sort(edit_costs.begin(), edit_costs.end());
+        vector<int64_t> score_bounds(read_length + 1, perfect_score);
+        for (size_t i = 0; i < read_length; ++i) {
+            score_bounds[i + 1] = score_bounds[i] - edit_costs[i];
+        }
+        
+        // find the largest edit distance that could still yield a score that passes the mismapping test
+        // (the p-value only grows as the score shrinks, so we can binary search)
+        int64_t lo = -1, hi = read_length;
+        while (hi - lo > 1) {
+            int64_t mid = (lo + hi) / 2;
+            if (random_match_p_value(score_bounds[mid], read_length) > max_mapping_p_value) {
+                hi = mid;
+            }
+            else {
+                lo = mid;
+            }
+        }
+        if (lo < 0) {
+            // even a perfect match would be called a mismapping
+            return false;
+        }
+        if (lo >= (int64_t) read_length - 1) {
+            // no edit distance could rule this cluster out
+            return false;
+        }
+        
+        // the cluster graph is bidirected, so search both strands
+        StrandSplitGraph split_graph(get<0>(cluster_graph).get());
+        size_t edit_distance = algorithms::dag_edit_distance(split_graph, sequence, lo);
+        
+#ifdef debug_multipath_mapper
+        cerr << "edit distance lower bound of read to cluster graph is " << edit_distance << " with a limit of " << lo << " for a passing alignment" << endl;
+#endif
+        
+        if (edit_distance > (size_t) lo) {
+            num_prefiltered_clusters.fetch_add(1, memory_order_relaxed);
+            if (score_bound_out) {
+                *score_bound_out = max<int64_t>(score_bounds[min(edit_distance, read_length)], 0);
+            }
+            return true;
+        }
+        return false;
+    }
+    
+    bool MultipathMapper::prefiltered_multipath_align(const Alignment& alignment,
+                                                      clustergraph_t& cluster_graph,
+                                                      multipath_alignment_t& multipath_aln_out,
+                                                      const match_fanouts_t* fanouts) const {
+        int32_t score_bound = 0;
+        if (cluster_cannot_align(alignment, cluster_graph, &score_bound)) {
+            // leave an unaligned placeholder so that the alignments stay in cluster order, and remember
+            // how well it could have scored so that it still counts against the mapping quality
+            transfer_read_metadata(alignment, multipath_aln_out);
+            multipath_aln_out.set_annotation("prefilter_score_bound", (double) score_bound);
+            return false;
+        }
+        multipath_align(alignment, cluster_graph, multipath_aln_out, fanouts);
+        return true;
+    }
+    
+    int32_t MultipathMapper::prefilter_score_bound(const multipath_alignment_t& multipath_aln) const {
+        if (multipath_aln.subpath_size() != 0) {
+            return -1;
+        }
+        auto annotation = multipath_aln.get_annotation("prefilter_score_bound");
+        if (annotation.first != multipath_alignment_t::Double) {
+            return -1;
+        }
+        return *((const double*) annotation.second);
+    }
+    
+    size_t MultipathMapper::get_num_prefiltered_clusters() const {
+        return num_prefiltered_clusters.load();
+    }
+
     bool MultipathMapper::likely_misrescue(const multipath_alignment_t& multipath_aln) {
         auto p_val = random_match_p_value(pseudo_length(multipath_aln), multipath_aln.sequence().size());
         
@@ -942,7 +1129,7 @@ namespace vg {
     // make the memo live in this .o file
     thread_local unordered_map<pair<int64_t, size_t>, double> MultipathMapper::p_value_memo;
     
-    double MultipathMapper::random_match_p_value(int64_t match_length, size_t read_length) {
+    double MultipathMapper::random_match_p_value(int64_t match_length, size_t read_length) const {
         // memoized to avoid transcendental functions (at least in cases where read lengths don't vary too much)
         auto iter = p_value_memo.find(make_pair(match_length, read_length));
         if (iter != p_value_memo.end()) {
@@ -1374,19 +1561,29 @@ namespace vg {
         vector<multipath_alignment_t> rescue_multipath_alns_1(num_to_rescue_2), rescue_multipath_alns_2(num_to_rescue_1);
         unordered_set<size_t> rescued_from_1, rescued_from_2;
         
+        vector<tuple<const multipath_alignment_t*, const Alignment*, bool>> rescue_attempts;
+        rescue_attempts.reserve(num_to_rescue_1 + num_to_rescue_2);
+        for (size_t i = 0; i < num_to_rescue_1; i++) {
+            rescue_attempts.emplace_back(&multipath_alns_1[i], &alignment2, true);
+        }
+        for (size_t i = 0; i < num_to_rescue_2; i++) {
+            rescue_attempts.emplace_back(&multipath_alns_2[i], &alignment1, false);
+        }
+        
+        vector<multipath_alignment_t> rescued_alns;
+        vector<bool> rescued;
+        attempt_rescues(rescue_attempts, rescued_alns, rescued);
+        
         for (size_t i = 0; i < num_to_rescue_1; i++) {
-            multipath_alignment_t rescue_multipath_aln;
-            if (attempt_rescue(multipath_alns_1[i], alignment2, true, rescue_multipath_aln)) {
+            if (rescued[i]) {
                 rescued_from_1.insert(i);
-                rescue_multipath_alns_2[i] = move(rescue_multipath_aln);
+                rescue_multipath_alns_2[i] = move(rescued_alns[i]);
             }
         }
-        
         for (size_t i = 0; i < num_to_rescue_2; i++) {
-            multipath_alignment_t rescue_multipath_aln;
-            if (attempt_rescue(multipath_alns_2[i], alignment1, false, rescue_multipath_aln)) {
+            if (rescued[num_to_rescue_1 + i]) {
                 rescued_from_2.insert(i);
-                rescue_multipath_alns_1[i] = move(rescue_multipath_aln);
+                rescue_multipath_alns_1[i] = move(rescued_alns[num_to_rescue_1 + i]);
             }
         }
         
@@ -1659,6 +1856,9 @@ namespace vg {
             
             size_t num_rescuable = 0;
             size_t num_rescues = 0;
+            // the alignments we will rescue from and the clusters they came from
+            vector<size_t> anchor_clusters;
+            vector<multipath_alignment_t> anchor_alns;
             for (size_t i = 0; i < cluster_graphs.size(); ++i) {
                 if (paired_clusters.count(i)) {
                     // we already have a consistent pair from this cluster
@@ -1689,6 +1889,12 @@ namespace vg {
                     continue;
                 }
                 
+                if (cluster_cannot_align(anchor_aln, cluster_graphs[i])) {
+                    // the anchor can't get an alignment good enough to rescue from here, so don't
+                    // spend a rescue attempt on it
+                    continue;
+                }
+                
                 ++num_rescues;
                 
                 // TODO: repetitive with align_to_cluster_graphs
@@ -1713,45 +1919,61 @@ namespace vg {
                     sort_and_compute_mapping_quality(cluster_multipath_alns);
                 }
                 
-                // rescue from the alignment
-                multipath_alignment_t rescue_multipath_aln;
                 if (!likely_mismapping(cluster_multipath_alns.front())) {
-                    bool rescued = attempt_rescue(cluster_multipath_alns.front(), rescue_aln, anchor_is_read_1, rescue_multipath_aln);
+                    // we'll rescue from this alignment
+                    anchor_clusters.push_back(i);
+                    anchor_alns.emplace_back(move(cluster_multipath_alns.front()));
+                }
 #ifdef debug_multipath_mapper
-                    cerr << "rescued alignment is " << debug_string(rescue_multipath_aln) << endl;
+                else {
+                    cerr << "alignment we're rescuing from is likely a mismapping" << endl;
+                }
 #endif
-                    if (rescued) {
+            }
+            
+            // do all of the rescues from this read end as one batch
+            vector<tuple<const multipath_alignment_t*, const Alignment*, bool>> rescue_attempts;
+            rescue_attempts.reserve(anchor_alns.size());
+            for (const multipath_alignment_t& anchor_mp_aln : anchor_alns) {
+                rescue_attempts.emplace_back(&anchor_mp_aln, &rescue_aln, anchor_is_read_1);
+            }
+            vector<multipath_alignment_t> rescued_alns;
+            vector<bool> rescued;
+            attempt_rescues(rescue_attempts, rescued_alns, rescued);
+            
+            for (size_t j = 0; j < anchor_alns.size(); ++j) {
+                size_t i = anchor_clusters[j];
+                multipath_alignment_t& anchor_mp_aln = anchor_alns[j];
+                multipath_alignment_t& rescue_multipath_aln = rescued_alns[j];
 #ifdef debug_multipath_mapper
-                        cerr << "rescue succeeded, adding to rescue pair vector" << endl;
+                cerr << "rescued alignment is " << debug_string(rescue_multipath_aln) << endl;
 #endif
-                        if (anchor_is_read_1) {
-                            int64_t dist = distance_between(cluster_multipath_alns.front(), rescue_multipath_aln, true);
-                            if (dist >= 0 && dist != numeric_limits<int64_t>::max()) {
-                                simplify_complicated_multipath_alignment(cluster_multipath_alns.front());
-                                rescued_secondaries.emplace_back(move(cluster_multipath_alns.front()), move(rescue_multipath_aln));
-                                rescued_distances.emplace_back(make_pair(i, RESCUED), dist);
-                                
-                            }
-                        }
-                        else {
-                            int64_t dist = distance_between(rescue_multipath_aln, cluster_multipath_alns.front(), true);
-                            if (dist >= 0 && dist != numeric_limits<int64_t>::max()) {
-                                simplify_complicated_multipath_alignment(cluster_multipath_alns.front());
-                                rescued_secondaries.emplace_back(move(rescue_multipath_aln), move(cluster_multipath_alns.front()));
-                                rescued_distances.emplace_back(make_pair(RESCUED, i), dist);
-                                
-                            }
+                if (rescued[j]) {
+#ifdef debug_multipath_mapper
+                    cerr << "rescue succeeded, adding to rescue pair vector" << endl;
+#endif
+                    if (anchor_is_read_1) {
+                        int64_t dist = distance_between(anchor_mp_aln, rescue_multipath_aln, true);
+                        if (dist >= 0 && dist != numeric_limits<int64_t>::max()) {
+                            simplify_complicated_multipath_alignment(anchor_mp_aln);
+                            rescued_secondaries.emplace_back(move(anchor_mp_aln), move(rescue_multipath_aln));
+                            rescued_distances.emplace_back(make_pair(i, RESCUED), dist);
+                            
                         }
                     }
-#ifdef debug_multipath_mapper
                     else {
-                        cerr << "rescue failed" << endl;
+                        int64_t dist = distance_between(rescue_multipath_aln, anchor_mp_aln, true);
+                        if (dist >= 0 && dist != numeric_limits<int64_t>::max()) {
+                            simplify_complicated_multipath_alignment(anchor_mp_aln);
+                            rescued_secondaries.emplace_back(move(rescue_multipath_aln), move(anchor_mp_aln));
+                            rescued_distances.emplace_back(make_pair(RESCUED, i), dist);
+                            
+                        }
                     }
-#endif
                 }
 #ifdef debug_multipath_mapper
                 else {
-                    cerr << "alignment we're rescuing from is likely a mismapping" << endl;
+                    cerr << "rescue failed" << endl;
                 }
 #endif
             }
@@ -1894,8 +2116,8 @@ namespace vg {
         
         // the fragment length distribution has been estimated, so we can do full-fledged paired mode
         vector<deque<pair<string::const_iterator, char>>> mem_fanouts1, mem_fanouts2;
-        auto mems1 = find_mems(alignment1, &mem_fanouts1);
-        auto mems2 = find_mems(alignment2, &mem_fanouts2);
+        vector<MaximalExactMatch> mems1, mems2;
+        find_mems(alignment1, alignment2, mems1, mems2, &mem_fanouts1, &mem_fanouts2);
         unique_ptr<match_fanouts_t> fanouts1(mem_fanouts1.empty() ? nullptr
                                              : new match_fanouts_t(record_fanouts(mems1, mem_fanouts1)));
         unique_ptr<match_fanouts_t> fanouts2(mem_fanouts2.empty() ? nullptr
@@ -3024,7 +3246,7 @@ namespace vg {
             
             auto& banked_candidate = unaligned_candidate_bank[candidate_id];
             
-            multipath_align(alignment, cluster_graph, banked_candidate.first, mem_fanouts);
+            prefiltered_multipath_align(alignment, cluster_graph, banked_candidate.first, mem_fanouts);
             topologically_order_subpaths(banked_candidate.first);
             
             banked_candidate.second = cluster_multiplicity(get<1>(cluster_graph));
@@ -5309,9 +5531,9 @@ namespace vg {
                 cerr << "performing alignment of read 1 to subgraph" << endl;
 #endif
                 
-                multipath_align(alignment1, cluster_graphs1[cluster_pair.first.first],
-                                multipath_aln_pairs_out.back().first,
-                                fanouts1);
+                prefiltered_multipath_align(alignment1, cluster_graphs1[cluster_pair.first.first],
+                                            multipath_aln_pairs_out.back().first,
+                                            fanouts1);
                 
                 // keep track of the fact that we have completed this multipath alignment
                 previous_multipath_alns_1[cluster_pair.first.first] = i;
@@ -5334,8 +5556,8 @@ namespace vg {
                 cerr << "performing alignment of read 2 to subgraph" << endl;
 #endif
                 
-                multipath_align(alignment2, cluster_graphs2[cluster_pair.first.second],
-                                multipath_aln_pairs_out.back().second, fanouts2);
+                prefiltered_multipath_align(alignment2, cluster_graphs2[cluster_pair.first.second],
+                                            multipath_aln_pairs_out.back().second, fanouts2);
                 
                 // keep track of the fact that we have completed this multipath alignment
                 previous_multipath_alns_2[cluster_pair.first.second] = i;
@@ -5438,6 +5660,24 @@ namespace vg {
         sort_and_compute_mapping_quality(multipath_aln_pairs_out, cluster_pairs,
                                          &duplicate_pairs_out, &pair_multiplicities);
         
+        // the pairs with a placeholder for a prefiltered cluster have done their part in the mapping
+        // quality, but they aren't alignments to report
+        size_t num_kept = 0;
+        for (size_t i = 0; i < multipath_aln_pairs_out.size(); ++i) {
+            if (prefilter_score_bound(multipath_aln_pairs_out[i].first) < 0
+                && prefilter_score_bound(multipath_aln_pairs_out[i].second) < 0) {
+                if (num_kept != i) {
+                    multipath_aln_pairs_out[num_kept] = move(multipath_aln_pairs_out[i]);
+                    cluster_pairs[num_kept] = cluster_pairs[i];
+                    pair_multiplicities[num_kept] = pair_multiplicities[i];
+                }
+                ++num_kept;
+            }
+        }
+        multipath_aln_pairs_out.resize(num_kept);
+        cluster_pairs.resize(num_kept);
+        pair_multiplicities.resize(num_kept);
+        
 #ifdef debug_validate_multipath_alignments
         for (pair<multipath_alignment_t, multipath_alignment_t>& multipath_aln_pair : multipath_aln_pairs_out) {
 #ifdef debug_multipath_mapper
@@ -6444,6 +6684,18 @@ namespace vg {
             // is turned on and it succeeded for the others.
             bool query_population = include_population_component && all_multipaths_pop_consistent;
             
+            int32_t score_bound = prefilter_score_bound(multipath_alns[i]);
+            if (score_bound >= 0) {
+                // a placeholder for a cluster that the prefilter ruled out, which counts with the best score
+                // it could have had (a population adjustment could only lower it)
+                scores[i] = score_bound;
+                if (include_population_component) {
+                    pop_adjusted_scores[i] = score_bound;
+                    min_adjustment = min(min_adjustment, 0.0);
+                }
+                continue;
+            }
+            
             /// Get all the linearizations we are going to work with, possibly with duplicates.
             /// The first alignment will be optimal.
             vector<Alignment> alignments;
@@ -6714,6 +6966,16 @@ namespace vg {
                 aln_score_2 = optimal_alignment_score(multipath_aln_pair.second);
             }
             
+            // placeholders for clusters that the prefilter ruled out count with the best score they could have had
+            int32_t score_bounds[2] = {prefilter_score_bound(multipath_aln_pair.first),
+                                       prefilter_score_bound(multipath_aln_pair.second)};
+            if (score_bounds[0] >= 0) {
+                aln_score_1 = score_bounds[0];
+            }
+            if (score_bounds[1] >= 0) {
+                aln_score_2 = score_bounds[1];
+            }
+            
             
             // We used to fail an assert if either list of optimal alignments
             // was empty, but now we handle it as if that side is an unmapped
@@ -6816,6 +7078,14 @@ namespace vg {
                     }
                 }
                 
+                for (int end : {0, 1}) {
+                    if (score_bounds[end] >= 0) {
+                        // a population adjustment could only lower the placeholder's bound
+                        best_total_score[end] = score_bounds[end];
+                        have_best_linearization[end] = true;
+                    }
+                }
+                
                 if ((!alignments[0].empty() && !have_best_linearization[0]) ||
                     (!alignments[1].empty() && !have_best_linearization[1])) {
                     // If we couldn't find a linearization for each mapped end that we could score, bail on pop scoring.
@@ -8,6 +8,7 @@
 #define multipath_mapper_hpp
 
 #include <algorithm>
+#include <atomic>
 #include <vg/vg.pb.h>
 #include <structures/union_find.hpp>
 #include <gbwt/gbwt.h>
@@ -90,6 +91,9 @@ namespace vg {
         /// What should the prior odds against a spliced alignment be?
         void set_log_odds_against_splice(double log_odds);
         
+        /// How many cluster graphs have been skipped by the edit distance prefilter so far
+        size_t get_num_prefiltered_clusters() const;
+        
         /// Use a non-default intron length distribution
         void set_intron_length_distribution(const vector<double>& intron_mixture_weights,
                                             const vector<pair<double, double>>& intron_component_params);
@@ -188,6 +192,8 @@ namespace vg {
         size_t fragment_length_warning_factor = 0;
         size_t max_alignment_gap = 5000;
         bool suppress_mismapping_detection = false;
+        // skip alignment to clusters whose bit-parallel edit distance rules out a non-mismapped alignment
+        bool use_edit_distance_prefilter = true;
         bool do_spliced_alignment = false;
         int64_t max_softclip_overlap = 8;
         int64_t max_splice_overhang = 3;
@@ -243,9 +249,19 @@ namespace vg {
         /// distribution and attempts to align the other paired read to it. If rescuing forward, assumes the
         /// provided multipath_alignment_t is the first read and vice versa if rescuing backward. Rescue constructs
         /// a conventional local alignment with gssw and converts the Alignment to a multipath_alignment_t. The
-        /// multipath_alignment_t will be stored in the object passed by reference as an argument.
-        bool attempt_rescue(const multipath_alignment_t& multipath_aln, const Alignment& other_aln,
-                            bool rescue_forward, multipath_alignment_t& rescue_multipath_aln);
+        /// multipath_alignment_t will be stored in the output vector. Rescues are given in a batch as
+        /// (anchor, read to rescue, rescue forward), and attempts that would align the same read in the same
+        /// window share a single alignment. Outputs are in the same order as the attempts.
+        void attempt_rescues(const vector<tuple<const multipath_alignment_t*, const Alignment*, bool>>& rescue_attempts,
+                             vector<multipath_alignment_t>& rescue_multipath_alns_out,
+                             vector<bool>& rescued_out);
+        
+        /// Assign a mapping quality to a rescued alignment and check whether it is confident enough to keep
+        bool validate_rescue(const multipath_alignment_t& multipath_aln, const Alignment& other_aln,
+                             multipath_alignment_t& rescue_multipath_aln);
+        
+        /// A key that is shared by all anchors that would produce the same rescue window
+        string rescue_window_key(const multipath_alignment_t& multipath_aln, bool rescue_forward) const;
         
         /// Make an alignment to a rescue graph and translate it back to the original node space
         /// Returns false if the alignment fails, but does not check statistical significance
@@ -253,11 +269,20 @@ namespace vg {
                                  bool rescue_forward, multipath_alignment_t& rescue_multipath_aln,
                                  double rescue_mean_length, double num_std_devs) const;
         
-        /// Use the algorithm implied by the mapper settings to extract a subgraph to perform a rescue alignment against
+        /// Align the other read to an extracted rescue graph, as in do_rescue_alignment
+        bool align_to_rescue_graph(const HandleGraph& rescue_graph, const multipath_alignment_t& multipath_aln,
+                                   const Alignment& other_aln, multipath_alignment_t& rescue_multipath_aln) const;
+        
+        /// Extract a subgraph to perform a rescue alignment against by jumping along paths
         void extract_rescue_graph(const multipath_alignment_t& multipath_aln, const Alignment& other_aln,
                                   bool rescue_forward, MutableHandleGraph* rescue_graph,
                                   double rescue_mean_length, double num_std_devs) const;
         
+        /// Identify the nodes to perform a rescue alignment against using the distance index
+        void extract_rescue_nodes(const multipath_alignment_t& multipath_aln, const Alignment& other_aln,
+                                  bool rescue_forward, unordered_set<id_t>& rescue_nodes,
+                                  double rescue_mean_length) const;
+        
         /// After clustering MEMs, extracting graphs, and assigning hits to cluster graphs, perform
         /// multipath alignment.
         /// Produces topologically sorted multipath_alignment_ts.
@@ -605,6 +630,23 @@ namespace vg {
         /// Would an alignment this good be expected against a graph this big by chance alone
         bool likely_mismapping(const multipath_alignment_t& multipath_aln);
         
+        /// Would any alignment to this cluster graph be called a likely mismapping, according to a
+        /// score upper bound derived from the read's minimum edit distance to the graph. If so and
+        /// score_bound_out is given, it is set to the bound.
+        bool cluster_cannot_align(const Alignment& alignment, const clustergraph_t& cluster_graph,
+                                  int32_t* score_bound_out = nullptr) const;
+        
+        /// Make a multipath alignment to the cluster graph as in multipath_align, unless the edit distance
+        /// prefilter rules the cluster out, in which case leave an unaligned placeholder with the read's metadata.
+        /// Returns false if the cluster was ruled out.
+        bool prefiltered_multipath_align(const Alignment& alignment,
+                                         clustergraph_t& cluster_graph,
+                                         multipath_alignment_t& multipath_aln_out,
+                                         const match_fanouts_t* fanouts) const;
+        
+        /// The score bound of a placeholder left by prefiltered_multipath_align, or -1 if this isn't one
+        int32_t prefilter_score_bound(const multipath_alignment_t& multipath_aln) const;
+        
         /// Would an alignment this good be expected against a graph this big by chance alone
         bool likely_misrescue(const multipath_alignment_t& multipath_aln);
         
@@ -612,7 +654,7 @@ namespace vg {
         int64_t pseudo_length(const multipath_alignment_t& multipath_aln) const;
         
         /// The approximate p-value for a match length of the given size against the current graph
-        double random_match_p_value(int64_t match_length, size_t read_length);
+        double random_match_p_value(int64_t match_length, size_t read_length) const;
         
         /// Reorganizes the fan-out breaks into the format that MultipathAlignmentGraph wants it in
         match_fanouts_t record_fanouts(const vector<MaximalExactMatch>& mems,
@@ -655,6 +697,13 @@ namespace vg {
         vector<MaximalExactMatch> find_mems(const Alignment& alignment,
                                             vector<deque<pair<string::const_iterator, char>>>* mem_fanout_breaks = nullptr);
         
+        /// Return exact matches for both reads of a pair, which lets their searches be
+        /// interleaved if we're using the stripped algorithm
+        void find_mems(const Alignment& alignment1, const Alignment& alignment2,
+                       vector<MaximalExactMatch>& mems1_out, vector<MaximalExactMatch>& mems2_out,
+                       vector<deque<pair<string::const_iterator, char>>>* mem_fanout_breaks1 = nullptr,
+                       vector<deque<pair<string::const_iterator, char>>>* mem_fanout_breaks2 = nullptr);
+        
         string read_1_adapter = "";
         string read_2_adapter = "";
         vector<size_t> read_1_adapter_lps;
@@ -686,6 +735,9 @@ namespace vg {
         static thread_local unordered_map<double, vector<int64_t>> pessimistic_gap_memo;
         static const size_t gap_memo_max_size;
         
+        // the number of cluster graphs skipped by the edit distance prefilter, across all threads
+        mutable atomic<size_t> num_prefiltered_clusters{0};
+        
 #ifdef mpmap_instrument_mem_statistics
     public:
         ofstream _mem_stats;
@@ -1,4 +1,8 @@
 #include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vg/io/protobuf_iterator.hpp>
 #include "packer.hpp"
 #include "statistics.hpp"
@@ -11,6 +15,8 @@ namespace vg {
 
 const int Packer::maximum_quality = 60;
 const int Packer::lru_cache_size = 4096;
+const uint64_t Packer::mappable_magic = 0x4b4341504d475600; // "\0VGMPACK"
+const uint64_t Packer::mappable_version = 1;
 
 size_t Packer::estimate_data_width(size_t expected_coverage) {
     return std::ceil(std::log2(2 * expected_coverage));
@@ -30,8 +36,8 @@ size_t Packer::estimate_bin_count(size_t num_threads) {
 
 Packer::Packer(const HandleGraph* graph) : graph(graph), data_width(8), cov_bin_size(0), edge_cov_bin_size(0), num_bases_dynamic(0), base_locks(nullptr), num_edges_dynamic(0), edge_locks(nullptr), node_quality_locks(nullptr), tmpfstream_locks(nullptr) { }
 
-Packer::Packer(const HandleGraph* graph, bool record_bases, bool record_edges, bool record_edits, bool record_qualities, size_t bin_size, size_t coverage_bins, size_t data_width) :
-    graph(graph), data_width(data_width), bin_size(bin_size), record_bases(record_bases), record_edges(record_edges), record_edits(record_edits), record_qualities(record_qualities) {
+Packer::Packer(const HandleGraph* graph, bool record_bases, bool record_edges, bool record_edits, bool record_qualities, size_t bin_size, size_t coverage_bins, size_t data_width, bool atomic_counters) :
+    graph(graph), data_width(data_width), atomic_counters(atomic_counters), bin_size(bin_size), record_bases(record_bases), record_edges(record_edges), record_edits(record_edits), record_qualities(record_qualities) {
     // get the size of the base coverage counter
     num_bases_dynamic = 0;
     if (record_bases) {
@@ -86,6 +92,13 @@ Packer::Packer(const HandleGraph* graph, bool record_bases, bool record_edges, b
     edge_locks = new std::mutex[edge_coverage_dynamic.size()];
     node_quality_locks = new std::mutex[node_quality_dynamic.size()];
     tmpfstream_locks = nullptr;
+
+    if (atomic_counters) {
+        // the bins above are still used for merging, but they are never allocated
+        coverage_atomic = vector<std::atomic<uint32_t>>(num_bases_dynamic);
+        edge_coverage_atomic = vector<std::atomic<uint32_t>>(num_edges_dynamic);
+        node_quality_atomic = vector<std::atomic<uint64_t>>(num_nodes_dynamic);
+    }
     
     // count the bins if binning
     if (bin_size) {
@@ -128,6 +141,10 @@ void Packer::clear() {
     node_quality_locks = nullptr;
     delete [] tmpfstream_locks;
     tmpfstream_locks = nullptr;
+    unmap();
+    vector<std::atomic<uint32_t>>().swap(coverage_atomic);
+    vector<std::atomic<uint32_t>>().swap(edge_coverage_atomic);
+    vector<std::atomic<uint64_t>>().swap(node_quality_atomic);
     close_edit_tmpfiles();
     remove_edit_tmpfiles();
     for (auto& lru_cache : quality_cache) {
@@ -141,6 +158,10 @@ Packer::~Packer() {
 }
 
 void Packer::load_from_file(const string& file_name) {
+    if (is_mappable_file(file_name)) {
+        map_from_file(file_name);
+        return;
+    }
     ifstream in(file_name);
     if (!in) {
         stringstream ss;
@@ -150,9 +171,98 @@ void Packer::load_from_file(const string& file_name) {
     load(in);
 }
 
-void Packer::save_to_file(const string& file_name) {
+void Packer::save_to_file(const string& file_name, bool mappable) {
     ofstream out(file_name);
-    serialize(out);
+    if (mappable) {
+        serialize_mappable(out);
+    } else {
+        serialize(out);
+    }
+}
+
+bool Packer::is_mappable_file(const string& file_name) {
+    ifstream in(file_name, std::ios_base::binary);
+    uint64_t magic = 0;
+    in.read((char*)&magic, sizeof(magic));
+    return in && magic == mappable_magic;
+}
+
+void Packer::map_from_file(const string& file_name) {
+    auto fail = [&](const string& problem) {
+        stringstream ss;
+        ss << "Error [Packer]: " << problem << " in pack file: \"" << file_name << "\"" << endl;
+        throw runtime_error(ss.str());
+    };
+    unmap();
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        fail("unable to open");
+    }
+    struct stat file_stats;
+    if (fstat(fd, &file_stats) != 0) {
+        close(fd);
+        fail("unable to stat");
+    }
+    mapped_length = file_stats.st_size;
+    mapped_data = mmap(nullptr, mapped_length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped_data == MAP_FAILED) {
+        mapped_data = nullptr;
+        fail("unable to map");
+    }
+    // we look up coverage by snarl, so readahead would only pull in pages we don't need
+    madvise(mapped_data, mapped_length, MADV_RANDOM);
+    is_mapped = true;
+
+    // everything in the header is a 64-bit word, so the vectors are aligned
+    const uint64_t* words = (const uint64_t*)mapped_data;
+    size_t num_words = mapped_length / sizeof(uint64_t);
+    size_t cursor = 0;
+    auto next_word = [&]() {
+        if (cursor >= num_words) {
+            fail("truncated header");
+        }
+        return words[cursor++];
+    };
+    next_word(); // magic
+    if (next_word() > mappable_version) {
+        fail("unsupported format version");
+    }
+    bin_size = next_word();
+    n_bins = next_word();
+    for (MappedIntVector* mapped : {&coverage_mapped, &edge_coverage_mapped, &node_quality_mapped}) {
+        mapped->length = next_word();
+        mapped->width = next_word();
+        size_t vector_words = (mapped->length * mapped->width + 63) / 64;
+        if (cursor + vector_words > num_words) {
+            fail("truncated coverage vector");
+        }
+        mapped->data = words + cursor;
+        cursor += vector_words;
+    }
+
+    // the edits are only needed for some uses and can't be used in place, so load them normally
+    edit_csas.resize(n_bins);
+    if (n_bins > 0) {
+        ifstream in(file_name, std::ios_base::binary);
+        in.seekg(cursor * sizeof(uint64_t));
+        for (size_t i = 0; i < n_bins; ++i) {
+            edit_csas[i].load(in);
+        }
+    }
+    is_compacted = true;
+}
+
+void Packer::unmap(void) {
+    if (mapped_data != nullptr) {
+        munmap(mapped_data, mapped_length);
+        mapped_data = nullptr;
+        mapped_length = 0;
+    }
+    coverage_mapped = MappedIntVector();
+    edge_coverage_mapped = MappedIntVector();
+    node_quality_mapped = MappedIntVector();
+    is_mapped = false;
 }
 
 void Packer::load(istream& in) {
@@ -178,8 +288,7 @@ void Packer::merge_from_files(const vector<string>& file_names) {
     bool first = true;
     for (auto& file_name : file_names) {
         Packer c;
-        ifstream f(file_name);
-        c.load(f);
+        c.load_from_file(file_name);
         // take bin size and counts from the first, assume they are all the same
         if (first) {
             bin_size = c.get_bin_size();
@@ -297,10 +406,61 @@ void Packer::collect_coverage(const vector<Packer*>& packers) {
     }
 }
 
+size_t Packer::serialize_mappable(std::ostream& out) {
+    make_compact();
+    size_t written = 0;
+    auto write_word = [&](uint64_t word) {
+        out.write((const char*)&word, sizeof(word));
+        written += sizeof(word);
+    };
+    write_word(mappable_magic);
+    write_word(mappable_version);
+    write_word(bin_size);
+    write_word(edit_csas.size());
+    auto write_vector = [&](size_t length, const function<size_t(size_t)>& get) {
+        int_vector<> iv(length);
+        for (size_t i = 0; i < length; ++i) {
+            iv[i] = get(i);
+        }
+        util::bit_compress(iv);
+        write_word(iv.size());
+        write_word(iv.width());
+        size_t vector_words = (iv.size() * iv.width() + 63) / 64;
+        out.write((const char*)iv.data(), vector_words * sizeof(uint64_t));
+        written += vector_words * sizeof(uint64_t);
+    };
+    write_vector(coverage_size(), [&](size_t i) { return coverage_at_position(i); });
+    write_vector(edge_vector_size(), [&](size_t i) { return edge_coverage(i); });
+    write_vector(node_quality_vector_size(), [&](size_t i) { return average_node_quality(i); });
+    for (auto& edit_csa : edit_csas) {
+        written += edit_csa.serialize(out);
+    }
+    return written;
+}
+
 size_t Packer::serialize(std::ostream& out,
                           sdsl::structure_tree_node* s,
                           std::string name) {
     make_compact();
+    if (is_mapped) {
+        // we have been using a mapped file, so build the compressed vectors from it
+        int_vector<> coverage_iv(coverage_size());
+        for (size_t i = 0; i < coverage_iv.size(); ++i) {
+            coverage_iv[i] = coverage_at_position(i);
+        }
+        int_vector<> edge_coverage_iv(edge_vector_size());
+        for (size_t i = 0; i < edge_coverage_iv.size(); ++i) {
+            edge_coverage_iv[i] = edge_coverage(i);
+        }
+        int_vector<> node_quality_iv(node_quality_vector_size());
+        for (size_t i = 0; i < node_quality_iv.size(); ++i) {
+            node_quality_iv[i] = average_node_quality(i);
+        }
+        util::assign(coverage_civ, coverage_iv);
+        util::assign(edge_coverage_civ, edge_coverage_iv);
+        util::assign(node_quality_civ, node_quality_iv);
+        unmap();
+    }
     sdsl::structure_tree_node* child = sdsl::structure_tree::add_child(s, name, sdsl::util::class_name(*this));
     size_t written = 0;
     written += sdsl::write_member(bin_size, out, child, "bin_size_" + name);
@@ -401,6 +561,10 @@ void Packer::make_compact(void) {
     // construct the record marker bitvector
     remove_edit_tmpfiles();
     is_compacted = true;
+    // the dense counters are no longer needed
+    vector<std::atomic<uint32_t>>().swap(coverage_atomic);
+    vector<std::atomic<uint32_t>>().swap(edge_coverage_atomic);
+    vector<std::atomic<uint64_t>>().swap(node_quality_atomic);
 }
 
 void Packer::make_dynamic(void) {
@@ -649,7 +813,10 @@ string Packer::unescape_delim(const string& s, char d) const {
 }
 
 size_t Packer::coverage_size(void) const {
-    if (is_compacted){
+    if (is_mapped) {
+        return coverage_mapped.size();
+    }
+    else if (is_compacted){
         return coverage_civ.size();
     }
     else{
@@ -658,7 +825,10 @@ size_t Packer::coverage_size(void) const {
 }
 
 size_t Packer::edge_vector_size(void) const{
-    if (is_compacted){
+    if (is_mapped) {
+        return edge_coverage_mapped.size();
+    }
+    else if (is_compacted){
         return edge_coverage_civ.size();
     }
     else{
@@ -667,7 +837,9 @@ size_t Packer::edge_vector_size(void) const{
 }
 
 size_t Packer::node_quality_vector_size(void) const {
-    if (is_compacted) {
+    if (is_mapped) {
+        return node_quality_mapped.size();
+    } else if (is_compacted) {
         return node_quality_civ.size();
     } else {
         return num_nodes_dynamic;
@@ -739,6 +911,10 @@ void Packer::init_node_quality_bin(size_t i) {
 }
 
 void Packer::increment_coverage(size_t i) {
+    if (atomic_counters) {
+        coverage_atomic[i].fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
     pair<size_t, size_t> bin_offset = coverage_bin_offset(i);
     std::lock_guard<std::mutex> guard(base_locks[bin_offset.first]);
     init_coverage_bin(bin_offset.first);
@@ -746,7 +922,9 @@ void Packer::increment_coverage(size_t i) {
 }
 
 void Packer::increment_coverage(size_t i, size_t v) {
-    if (v > 0) {
+    if (v > 0 && atomic_counters) {
+        coverage_atomic[i].fetch_add(v, std::memory_order_relaxed);
+    } else if (v > 0) {
         pair<size_t, size_t> bin_offset = coverage_bin_offset(i);
         std::lock_guard<std::mutex> guard(base_locks[bin_offset.first]);
         init_coverage_bin(bin_offset.first);
@@ -755,6 +933,10 @@ void Packer::increment_coverage(size_t i, size_t v) {
 }
 
 void Packer::increment_edge_coverage(size_t i) {
+    if (atomic_counters) {
+        edge_coverage_atomic[i].fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
     pair<size_t, size_t> bin_offset = edge_coverage_bin_offset(i);
     std::lock_guard<std::mutex> guard(edge_locks[bin_offset.first]);
     init_edge_coverage_bin(bin_offset.first);
@@ -765,7 +947,9 @@ void Packer::increment_edge_coverage(size_t i) {
 }
 
 void Packer::increment_edge_coverage(size_t i, size_t v) {
-    if (v > 0) {
+    if (v > 0 && atomic_counters) {
+        edge_coverage_atomic[i].fetch_add(v, std::memory_order_relaxed);
+    } else if (v > 0) {
         pair<size_t, size_t> bin_offset = edge_coverage_bin_offset(i);
         std::lock_guard<std::mutex> guard(edge_locks[bin_offset.first]);
         init_edge_coverage_bin(bin_offset.first);
@@ -777,7 +961,9 @@ void Packer::increment_edge_coverage(size_t i, size_t v) {
 }
 
 void Packer::increment_node_quality(size_t i, size_t v) {
-    if (v > 0) {
+    if (v > 0 && atomic_counters) {
+        node_quality_atomic[i].fetch_add(v, std::memory_order_relaxed);
+    } else if (v > 0) {
         pair<size_t, size_t> bin_offset = node_quality_bin_offset(i);
         std::lock_guard<std::mutex> guard(node_quality_locks[bin_offset.first]);
         init_node_quality_bin(bin_offset.first);
@@ -790,8 +976,14 @@ void Packer::increment_node_quality(size_t i, size_t v) {
 
 bool Packer::has_qualities() const {
     if (is_compacted) {
-        for (size_t i = 0; i < node_quality_civ.size(); ++i) {
-            if (node_quality_civ[i] > 0) {
+        for (size_t i = 0; i < node_quality_vector_size(); ++i) {
+            if (average_node_quality(i) > 0) {
+                return true;
+            }
+        }
+    } else if (atomic_counters) {
+        for (size_t i = 0; i < node_quality_atomic.size(); ++i) {
+            if (node_quality_atomic[i].load(std::memory_order_relaxed) > 0) {
                 return true;
             }
         }
@@ -810,8 +1002,12 @@ bool Packer::has_qualities() const {
 }
 
 size_t Packer::coverage_at_position(size_t i) const {
-    if (is_compacted) {
+    if (is_mapped) {
+        return coverage_mapped[i];
+    } else if (is_compacted) {
         return coverage_civ[i];
+    } else if (atomic_counters) {
+        return coverage_atomic[i].load(std::memory_order_relaxed);
     } else {
         pair<size_t, size_t> bin_offset = coverage_bin_offset(i);
         if (coverage_dynamic[bin_offset.first] == nullptr) {
@@ -823,9 +1019,15 @@ size_t Packer::coverage_at_position(size_t i) const {
 }
 
 size_t Packer::edge_coverage(size_t i) const {
-    if (is_compacted){
+    if (is_mapped) {
+        return edge_coverage_mapped[i];
+    }
+    else if (is_compacted){
         return edge_coverage_civ[i];
     }
+    else if (atomic_counters) {
+        return edge_coverage_atomic[i].load(std::memory_order_relaxed);
+    }
     else{
         pair<size_t, size_t> bin_offset = edge_coverage_bin_offset(i);
         if (edge_coverage_dynamic[bin_offset.first] == nullptr) {
@@ -855,6 +1057,8 @@ size_t Packer::total_node_quality(size_t i) const {
             coverage += coverage_at_position(base + i);
         }
         return avg_qual * coverage;
+    } else if (atomic_counters) {
+        return node_quality_atomic[i].load(std::memory_order_relaxed);
     } else {
         pair<size_t, size_t> bin_offset = node_quality_bin_offset(i);
         if (node_quality_dynamic[bin_offset.first] == nullptr) {
@@ -866,7 +1070,9 @@ size_t Packer::total_node_quality(size_t i) const {
 }
 
 size_t Packer::average_node_quality(size_t i) const {
-    if (is_compacted) {
+    if (is_mapped) {
+        return node_quality_mapped[i];
+    } else if (is_compacted) {
         return node_quality_civ[i];
     } else {
         Position pos;
@@ -945,7 +1151,7 @@ nid_t Packer::index_to_node(size_t i) const {
 
 ostream& Packer::as_table(ostream& out, bool show_edits, vector<vg::id_t> node_ids) {
 #ifdef debug
-    cerr << "Packer table of " << coverage_civ.size() << " rows:" << endl;
+    cerr << "Packer table of " << coverage_size() << " rows:" << endl;
 #endif
 
     out << "seq.pos" << "\t"
@@ -955,13 +1161,13 @@ ostream& Packer::as_table(ostream& out, bool show_edits, vector<vg::id_t> node_i
     if (show_edits) out << "\t" << "edits";
     out << endl;
     // write the coverage as a vector
-    for (size_t i = 0; i < coverage_civ.size(); ++i) {
+    for (size_t i = 0; i < coverage_size(); ++i) {
         nid_t node_id = dynamic_cast<const VectorizableHandleGraph*>(graph)->node_at_vector_offset(i+1);
         if (!node_ids.empty() && find(node_ids.begin(), node_ids.end(), node_id) == node_ids.end()) {
             continue;
         }
         size_t offset = i - dynamic_cast<const VectorizableHandleGraph*>(graph)->node_vector_offset(node_id);
-        out << i << "\t" << node_id << "\t" << offset << "\t" << coverage_civ[i];
+        out << i << "\t" << node_id << "\t" << offset << "\t" << coverage_at_position(i);
         if (show_edits) {
             out << "\t" << count(edit_csas[bin_for_position(i)], pos_key(i));
             for (auto& edit : edits_at_position(i)) out << " " << pb2json(edit);
@@ -973,7 +1179,7 @@ ostream& Packer::as_table(ostream& out, bool show_edits, vector<vg::id_t> node_i
 
 ostream& Packer::as_edge_table(ostream& out, vector<vg::id_t> node_ids) {
 #ifdef debug
-    cerr << "Packer edge table of " << edge_coverage_civ.size() << " rows:" << endl;
+    cerr << "Packer edge table of " << edge_vector_size() << " rows:" << endl;
 #endif
 
     out << "from.id" << "\t"
@@ -1020,7 +1226,7 @@ ostream& Packer::as_edge_table(ostream& out, vector<vg::id_t> node_ids) {
                 << edge.from_start() << "\t"
                 << edge.to() << "\t"
                 << edge.to_end() << "\t"
-                << edge_coverage_civ[edge_index(edge)]
+                << edge_coverage(edge_index(edge))
                 << endl;
             
             // Look at the enxt edge
@@ -1031,25 +1237,29 @@ ostream& Packer::as_edge_table(ostream& out, vector<vg::id_t> node_ids) {
     
 ostream& Packer::as_quality_table(ostream& out, vector<vg::id_t> node_ids) {
 #ifdef debug
-    cerr << "Packer quality table of " << node_quality_civ.size() << " rows:" << endl;
+    cerr << "Packer quality table of " << node_quality_vector_size() << " rows:" << endl;
 #endif
 
     out << "node.rank" << "\t"
         << "node.id" << "\t"
         << "avg-mapq";
     out << endl;
-    for (size_t i = 1; i < node_quality_civ.size(); ++i) {
+    for (size_t i = 1; i < node_quality_vector_size(); ++i) {
         nid_t node_id = index_to_node(i);
         if (!node_ids.empty() && find(node_ids.begin(), node_ids.end(), node_id) == node_ids.end()) {
             continue;
         }
-        out << i << "\t" << node_id << "\t" << node_quality_civ[i] << endl;
+        out << i << "\t" << node_id << "\t" << average_node_quality(i) << endl;
     }
     return out;
 }
 
 ostream& Packer::show_structure(ostream& out) {
-    out << coverage_civ << endl; // graph coverage (compacted coverage_dynamic)
+    // graph coverage, through the accessor so that mapped packs show too
+    for (size_t i = 0; i < coverage_size(); ++i) {
+        out << (i > 0 ? " " : "") << coverage_at_position(i);
+    }
+    out << endl;
     for (auto& edit_csa : edit_csas) {
         out << edit_csa << endl;
     }
@@ -6,6 +6,7 @@
 #include <chrono>
 #include <ctime>
 #include <mutex>
+#include <atomic>
 #include "omp.h"
 #include "lru_cache.h"
 #include "alignment.hpp"
@@ -22,6 +23,21 @@ namespace vg {
 
 using namespace sdsl;
 
+/// A read-only view of a bit-packed integer vector in memory owned by someone
+/// else, such as a memory-mapped file
+struct MappedIntVector {
+    const uint64_t* data = nullptr;
+    size_t length = 0;
+    uint8_t width = 0;
+    
+    size_t size() const {
+        return length;
+    }
+    size_t operator[](size_t i) const {
+        return width == 0 ? 0 : sdsl::bits::read_int(data + ((i * width) >> 6), (i * width) & 0x3F, width);
+    }
+};
+
 /// Packer collects coverage of a GAM using compressed indexes
 /// Any combination of these 3 types of information can be stored
 /// - base coverage : number of reads aligning to a given base (offset in node) in the graph
@@ -49,8 +65,10 @@ public:
     /// coverage_bins : Use this many coverage objects.  Using one / thread allows faster merge
     /// coverage_locks : Number of mutexes to use for each of node and edge coverage.
     /// data_width : Number of bits per entry in the dynamic coverage vector.  Higher values get stored in a map
+    /// atomic_counters : Count into dense atomic counters instead of locked, binned counter arrays.
+    ///                   Uses 4 bytes per base and edge regardless of data_width, but never blocks
     Packer(const HandleGraph* graph, bool record_bases, bool record_edges, bool record_edits, bool record_qualities,
-           size_t bin_size = 0, size_t coverage_bins = 1, size_t data_width = 8);
+           size_t bin_size = 0, size_t coverage_bins = 1, size_t data_width = 8, bool atomic_counters = false);
     ~Packer();
     void clear();
 
@@ -63,9 +81,15 @@ public:
 
     void merge_from_files(const vector<string>& file_names);
     void merge_from_dynamic(vector<Packer*>& packers);
+    /// Load a pack file, memory-mapping it if it is in the mappable format
     void load_from_file(const string& file_name);
-    void save_to_file(const string& file_name);
+    /// Save to a pack file. The mappable format can be used without
+    /// deserializing the coverage, but it is larger since it isn't compressed
+    void save_to_file(const string& file_name, bool mappable = false);
     void load(istream& in);
+    /// Write the mappable format, with bit-packed coverage vectors at 8-byte
+    /// aligned offsets followed by the edit CSAs
+    size_t serialize_mappable(std::ostream& out);
     size_t serialize(std::ostream& out,
                      sdsl::structure_tree_node* s = NULL,
                      std::string name = "");
@@ -132,6 +156,13 @@ private:
     void remove_edit_tmpfiles(void);
     bool is_compacted = false;
     
+    /// Check the header of a pack file for the mappable format
+    static bool is_mappable_file(const string& file_name);
+    /// Map a pack file in the mappable format
+    void map_from_file(const string& file_name);
+    /// Unmap the file if we have one
+    void unmap(void);
+    
     // base graph
     const HandleGraph* graph;
 
@@ -164,6 +195,12 @@ private:
     size_t num_nodes_dynamic;
     // one mutex per element of node_quality_dynamic
     std::mutex* node_quality_locks;
+
+    // lock-free alternative to the above, used instead of them when atomic_counters is set
+    bool atomic_counters = false;
+    vector<std::atomic<uint32_t>> coverage_atomic;
+    vector<std::atomic<uint32_t>> edge_coverage_atomic;
+    vector<std::atomic<uint64_t>> node_quality_atomic;
     
     vector<string> edit_tmpfile_names;
     vector<ofstream*> tmpfstreams;
@@ -177,6 +214,13 @@ private:
     dac_vector<> coverage_civ; // graph coverage (compacted coverage_dynamic)
     vlc_vector<> edge_coverage_civ; // edge coverage (compacted edge_coverage_dynamic)
     vlc_vector<> node_quality_civ; // averge mapq for each node rank (compacted node_quality_dynamic)
+    // compact coverage used straight from a memory-mapped file, instead of the above
+    bool is_mapped = false;
+    void* mapped_data = nullptr;
+    size_t mapped_length = 0;
+    MappedIntVector coverage_mapped;
+    MappedIntVector edge_coverage_mapped;
+    MappedIntVector node_quality_mapped;
     // edits
     vector<csa_sada<enc_vector<>, 32, 32, sa_order_sa_sampling<>, isa_sampling<>, succinct_byte_alphabet<> > > edit_csas;
     // make separators that are somewhat unusual, as we escape these
@@ -202,6 +246,9 @@ private:
     // Avoid recomputing qualities in above (one per thread)
     mutable vector<LRUCache<pair<int, int>, int>*> quality_cache;
     static const int maximum_quality;
+    // identifies the mappable format, which the old format can't start with in practice
+    static const uint64_t mappable_magic;
+    static const uint64_t mappable_version;
     static const int lru_cache_size;
     
 };
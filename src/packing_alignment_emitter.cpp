@@ -0,0 +1,57 @@
+/**
+ * \file packing_alignment_emitter.cpp
+ * Implementation for PackingAlignmentEmitter
+ */
+
+
+#include "packing_alignment_emitter.hpp"
+
+namespace vg {
+
+using namespace std;
+
+PackingAlignmentEmitter::PackingAlignmentEmitter(Packer* packer, unique_ptr<AlignmentEmitter>&& backing,
+    int min_mapq, int min_baseq, int trim_ends) :
+    packer(packer), backing(std::move(backing)), min_mapq(min_mapq), min_baseq(min_baseq), trim_ends(trim_ends) {
+    // Nothing to do!
+}
+
+void PackingAlignmentEmitter::pack_alignments(const vector<Alignment>& alns) const {
+    for (auto& aln : alns) {
+        packer->add(aln, min_mapq, min_baseq, trim_ends);
+    }
+}
+
+void PackingAlignmentEmitter::emit_singles(vector<Alignment>&& aln_batch) {
+    pack_alignments(aln_batch);
+    // Forward it along
+    backing->emit_singles(std::move(aln_batch));
+}
+
+void PackingAlignmentEmitter::emit_mapped_singles(vector<vector<Alignment>>&& alns_batch) {
+    for (auto& mappings : alns_batch) {
+        pack_alignments(mappings);
+    }
+    // Forward it along
+    backing->emit_mapped_singles(std::move(alns_batch));
+}
+
+void PackingAlignmentEmitter::emit_pairs(vector<Alignment>&& aln1_batch, vector<Alignment>&& aln2_batch, vector<int64_t>&& tlen_limit_batch) {
+    pack_alignments(aln1_batch);
+    pack_alignments(aln2_batch);
+    // Forward it along
+    backing->emit_pairs(std::move(aln1_batch), std::move(aln2_batch), std::move(tlen_limit_batch));
+}
+
+void PackingAlignmentEmitter::emit_mapped_pairs(vector<vector<Alignment>>&& alns1_batch, vector<vector<Alignment>>&& alns2_batch, vector<int64_t>&& tlen_limit_batch) {
+    for (auto& mappings : alns1_batch) {
+        pack_alignments(mappings);
+    }
+    for (auto& mappings : alns2_batch) {
+        pack_alignments(mappings);
+    }
+    // Forward it along
+    backing->emit_mapped_pairs(std::move(alns1_batch), std::move(alns2_batch), std::move(tlen_limit_batch));
+}
+
+}
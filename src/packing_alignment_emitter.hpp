@@ -0,0 +1,66 @@
+#ifndef VG_PACKING_ALIGNMENT_EMITTER_HPP_INCLUDED
+#define VG_PACKING_ALIGNMENT_EMITTER_HPP_INCLUDED
+
+/** \file
+ *
+ * Holds a wrapper AlignmentEmitter that records coverage in a Packer.
+ */
+
+
+#include "vg/io/alignment_emitter.hpp"
+#include "packer.hpp"
+
+#include <vector>
+
+namespace vg {
+
+using namespace std;
+
+/**
+ * An AlignmentEmitter implementation that adds every alignment to a Packer
+ * before emitting it via a backing AlignmentEmitter, which it owns. This
+ * gives the same coverage as running vg pack over the emitted alignments,
+ * without writing and reading them back. The Packer is not owned and must
+ * be safe to add to from multiple threads.
+ */
+class PackingAlignmentEmitter : public vg::io::AlignmentEmitter {
+public:
+    
+    /**
+     * Make an alignment emitter that adds alignments to the given Packer
+     * and emits them to the given backing AlignmentEmitter.
+     * Takes ownership of the AlignmentEmitter.
+     */
+    PackingAlignmentEmitter(Packer* packer, unique_ptr<AlignmentEmitter>&& backing,
+                            int min_mapq = 0, int min_baseq = 0, int trim_ends = 0);
+   
+    /// Emit a batch of Alignments
+    virtual void emit_singles(vector<Alignment>&& aln_batch);
+    /// Emit batch of Alignments with secondaries. All secondaries must have is_secondary set already.
+    virtual void emit_mapped_singles(vector<vector<Alignment>>&& alns_batch);
+    /// Emit a batch of pairs of Alignments.
+    virtual void emit_pairs(vector<Alignment>&& aln1_batch, vector<Alignment>&& aln2_batch,
+        vector<int64_t>&& tlen_limit_batch);
+    /// Emit the mappings of a batch of pairs of Alignments.
+    virtual void emit_mapped_pairs(vector<vector<Alignment>>&& alns1_batch,
+        vector<vector<Alignment>>&& alns2_batch, vector<int64_t>&& tlen_limit_batch);
+    
+protected:
+    /// Packer to record the coverage in
+    Packer* packer;
+
+    /// AlignmentEmitter to emit to once done
+    unique_ptr<AlignmentEmitter> backing;
+
+    /// Filters passed along to Packer::add()
+    int min_mapq;
+    int min_baseq;
+    int trim_ends;
+    
+    /// Add the alignments to the packer.
+    void pack_alignments(const vector<Alignment>& alns) const;
+};
+
+}
+
+#endif
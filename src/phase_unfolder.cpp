@@ -1,10 +1,13 @@
 #include "phase_unfolder.hpp"
 #include "progress_bar.hpp"
+#include "job_schedule.hpp"
 #include "algorithms/disjoint_components.hpp"
 
 #include <cassert>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 
 namespace vg {
@@ -14,22 +17,136 @@ PhaseUnfolder::PhaseUnfolder(const PathHandleGraph& path_graph, const gbwt::GBWT
     assert(this->mapping.begin() > this->path_graph.max_node_id());
 }
 
-void PhaseUnfolder::unfold(MutableHandleGraph& graph, bool show_progress) {
-    
-    std::list<bdsg::HashGraph> components = this->complement_components(graph, show_progress);
-    
-    size_t haplotype_paths = 0;
-    bdsg::HashGraph unfolded;
-    for (MutableHandleGraph& component : components) {
-        haplotype_paths += this->unfold_component(component, graph, unfolded);
+void PhaseUnfolder::unfold(MutableHandleGraph& graph, bool show_progress, int64_t target_memory_usage) {
+    UnfoldedComponent unfolded = this->unfold_components(graph, show_progress, target_memory_usage);
+    this->merge_components(unfolded, graph, show_progress);
+}
+
+/// Initial guess for the memory used to unfold a component, in bytes per node
+/// and edge of the component. The unfolded component is a HashGraph, which
+/// takes on the order of 100 bytes per node or edge, and every node can be
+/// duplicated once for each distinct haplotype prefix and suffix through it,
+/// which come to several copies in a typical pruned region. The prefix and
+/// suffix tries are of similar size. The "unfold" cost model replaces this
+/// with the ratio measured in earlier runs, so only the order of magnitude
+/// matters.
+static const int64_t UNFOLD_BYTES_PER_ELEMENT = 1024;
+
+PhaseUnfolder::UnfoldedComponent PhaseUnfolder::unfold_components(const MutableHandleGraph& graph, bool show_progress,
+                                                                  int64_t target_memory_usage, int num_threads) const {
+
+    std::list<bdsg::HashGraph> complement = this->complement_components(graph, show_progress);
+    std::vector<bdsg::HashGraph*> components;
+    components.reserve(complement.size());
+    for (bdsg::HashGraph& component : complement) {
+        components.push_back(&component);
+    }
+
+    // Finished components wait here only until the ones before them are done.
+    UnfoldedComponent result;
+    std::vector<std::unique_ptr<UnfoldedComponent>> finished(components.size());
+    size_t next_to_append = 0;
+    std::mutex append_mutex;
+    auto unfold_job = [&](int64_t i) {
+        // Each component gets its own unfolder, so that the per-component state and
+        // the temporary identifiers are private to the job.
+        std::unique_ptr<UnfoldedComponent> unfolded(new UnfoldedComponent());
+        PhaseUnfolder worker(this->path_graph, this->gbwt_index, TEMPORARY_NODE);
+        unfolded->haplotype_paths = worker.unfold_component(*components[i], graph, unfolded->unfolded);
+        for (gcsa::size_type duplicate = worker.mapping.begin(); duplicate < worker.mapping.end(); duplicate++) {
+            unfolded->duplicates_of.push_back(worker.mapping(duplicate));
+        }
+        unfolded->components = 1;
+        // We don't need the component anymore.
+        components[i]->clear();
+
+        std::lock_guard<std::mutex> lock(append_mutex);
+        finished[i] = std::move(unfolded);
+        while (next_to_append < finished.size() && finished[next_to_append]) {
+            append_components(*finished[next_to_append], result);
+            finished[next_to_append].reset();
+            ++next_to_append;
+        }
+    };
+
+    // The tries grow with the number of haplotypes through the component, which
+    // we can't see in advance, so the estimate is scaled by the observed ratio.
+    std::vector<std::pair<int64_t, int64_t>> job_requirements;
+    job_requirements.reserve(components.size());
+    for (bdsg::HashGraph* component : components) {
+        int64_t component_size = component->get_node_count() + component->get_edge_count();
+        job_requirements.emplace_back(component_size, UNFOLD_BYTES_PER_ELEMENT * component_size);
     }
+    JobSchedule schedule(job_requirements, unfold_job, "unfold");
+    schedule.execute(target_memory_usage, num_threads);
+    assert(next_to_append == components.size());
+
+    return result;
+}
+
+void PhaseUnfolder::append_components(const UnfoldedComponent& from, UnfoldedComponent& to) {
+    vg::id_t offset = to.duplicates_of.size();
+    auto appended_handle = [&](const handle_t& handle) {
+        vg::id_t id = from.unfolded.get_id(handle);
+        if (id >= TEMPORARY_NODE) {
+            id += offset;
+        }
+        if (!to.unfolded.has_node(id)) {
+            to.unfolded.create_handle(from.unfolded.get_sequence(from.unfolded.forward(handle)), id);
+        }
+        return to.unfolded.get_handle(id, from.unfolded.get_is_reverse(handle));
+    };
+    from.unfolded.for_each_handle([&](const handle_t& handle) {
+        appended_handle(handle);
+    });
+    from.unfolded.for_each_edge([&](const edge_t& edge) {
+        edge_t candidate(appended_handle(edge.first), appended_handle(edge.second));
+        if (!to.unfolded.has_edge(candidate)) {
+            to.unfolded.create_edge(candidate);
+        }
+    });
+    to.duplicates_of.insert(to.duplicates_of.end(), from.duplicates_of.begin(), from.duplicates_of.end());
+    to.haplotype_paths += from.haplotype_paths;
+    to.components += from.components;
+}
+
+void PhaseUnfolder::merge_components(UnfoldedComponent& unfolded, MutableHandleGraph& graph, bool show_progress) {
+
+    // Assign the final identifiers in the order the serial unfolding would have.
+    std::vector<vg::id_t> final_ids;
+    final_ids.reserve(unfolded.duplicates_of.size());
+    for (vg::id_t original : unfolded.duplicates_of) {
+        final_ids.push_back(this->mapping.insert(original));
+    }
+    bdsg::HashGraph merged;
+    auto final_handle = [&](const handle_t& handle) {
+        vg::id_t id = unfolded.unfolded.get_id(handle);
+        if (id >= TEMPORARY_NODE) {
+            id = final_ids[id - TEMPORARY_NODE];
+        }
+        if (!merged.has_node(id)) {
+            merged.create_handle(unfolded.unfolded.get_sequence(unfolded.unfolded.forward(handle)), id);
+        }
+        return merged.get_handle(id, unfolded.unfolded.get_is_reverse(handle));
+    };
+    unfolded.unfolded.for_each_handle([&](const handle_t& handle) {
+        final_handle(handle);
+    });
+    unfolded.unfolded.for_each_edge([&](const edge_t& edge) {
+        edge_t candidate(final_handle(edge.first), final_handle(edge.second));
+        if (!merged.has_edge(candidate)) {
+            merged.create_edge(candidate);
+        }
+    });
+    size_t haplotype_paths = unfolded.haplotype_paths;
+    unfolded = UnfoldedComponent();
     if (show_progress) {
         std::cerr << "Unfolded graph: "
-                  << unfolded.get_node_count() << " nodes, " << unfolded.get_edge_count() << " edges on "
+                  << merged.get_node_count() << " nodes, " << merged.get_edge_count() << " edges on "
                   << haplotype_paths << " paths" << std::endl;
     }
     
-    handlealgs::extend(&unfolded, &graph);
+    handlealgs::extend(&merged, &graph);
 }
 
 void PhaseUnfolder::restore_paths(MutableHandleGraph& graph, bool show_progress) const {
@@ -283,7 +400,7 @@ vg::id_t PhaseUnfolder::get_mapping(vg::id_t node) const {
     return this->mapping(node);
 }
 
-std::list<bdsg::HashGraph> PhaseUnfolder::complement_components(MutableHandleGraph& graph, bool show_progress) {
+std::list<bdsg::HashGraph> PhaseUnfolder::complement_components(const MutableHandleGraph& graph, bool show_progress) const {
     
     bdsg::HashGraph complement;
 
@@ -376,7 +493,7 @@ std::list<bdsg::HashGraph> PhaseUnfolder::complement_components(MutableHandleGra
     return components;
 }
 
-size_t PhaseUnfolder::unfold_component(MutableHandleGraph& component, MutableHandleGraph& graph, MutableHandleGraph& unfolded) {
+size_t PhaseUnfolder::unfold_component(MutableHandleGraph& component, const MutableHandleGraph& graph, MutableHandleGraph& unfolded) {
     // Find the border nodes shared between the component and the graph.
     component.for_each_handle([&](const handle_t& handle) {
         vg::id_t id = component.get_id(handle);
@@ -12,6 +12,7 @@
 #include "gbwt_helper.hpp"
 
 #include <algorithm>
+#include <limits>
 #include <list>
 #include <stack>
 #include <utility>
@@ -57,7 +58,46 @@ public:
      *
      * - Extend the input graph with the unfolded components.
      */
-    void unfold(MutableHandleGraph& graph, bool show_progress = false);
+    void unfold(MutableHandleGraph& graph, bool show_progress = false,
+                int64_t target_memory_usage = std::numeric_limits<int64_t>::max());
+
+    /**
+     * Unfolded components that have not been given node identifiers yet.
+     * Duplicated nodes have temporary identifiers starting from
+     * TEMPORARY_NODE, and duplicates_of lists their original identifiers in
+     * the order they were created.
+     */
+    struct UnfoldedComponent {
+        bdsg::HashGraph unfolded;
+        std::vector<vg::id_t> duplicates_of;
+        size_t haplotype_paths = 0;
+        size_t components = 0;
+    };
+
+    /// The first temporary identifier for the duplicated nodes in an UnfoldedComponent.
+    const static vg::id_t TEMPORARY_NODE = vg::id_t(1) << 60;
+
+    /**
+     * The first half of unfold(): unfold the components of the complement
+     * graph independently and in parallel. This does not use the node
+     * mapping, so it can be done before read_mapping(). Tries to keep the
+     * memory used by the components in progress under the target. Uses the
+     * given number of threads, or get_thread_count() if it is 0.
+     *
+     * Each component is appended to the result as soon as it and all the
+     * components before it have been unfolded, so the result is the same
+     * regardless of the order the jobs finish in.
+     */
+    UnfoldedComponent unfold_components(const MutableHandleGraph& graph, bool show_progress = false,
+                                        int64_t target_memory_usage = std::numeric_limits<int64_t>::max(),
+                                        int num_threads = 0) const;
+
+    /**
+     * The second half of unfold(): give the duplicated nodes their final
+     * identifiers in the node mapping, in the order they were created, and
+     * extend the graph with them. The unfolded components are consumed.
+     */
+    void merge_components(UnfoldedComponent& unfolded, MutableHandleGraph& graph, bool show_progress = false);
 
     /**
      * Restore the edges on XG paths. This is effectively the same as
@@ -106,14 +146,20 @@ private:
      * GBWT index but not in the input graph. Split the complement into
      * disjoint components and return the components.
      */
-    std::list<bdsg::HashGraph> complement_components(MutableHandleGraph& graph, bool show_progress);
+    std::list<bdsg::HashGraph> complement_components(const MutableHandleGraph& graph, bool show_progress) const;
 
     /**
      * Generate all border-to-border paths in the component supported by the
      * indexes. Unfold the paths by duplicating the inner nodes so that the
      * paths become disjoint, except for their shared prefixes/suffixes.
      */
-    size_t unfold_component(MutableHandleGraph& component, MutableHandleGraph& graph, MutableHandleGraph& unfolded);
+    size_t unfold_component(MutableHandleGraph& component, const MutableHandleGraph& graph, MutableHandleGraph& unfolded);
+
+    /**
+     * Append the unfolded components in 'from' to 'to', renumbering the
+     * temporary identifiers in 'from' to follow the ones already in 'to'.
+     */
+    static void append_components(const UnfoldedComponent& from, UnfoldedComponent& to);
 
     /**
      * Generate all paths supported by the XG index passing through the given
@@ -601,9 +601,12 @@ pair<vector<int>, unique_ptr<SnarlCaller::CallInfo>> PoissonSupportSnarlCaller::
     double second_best_genotype_likelihood = -numeric_limits<double>::max();
     double total_likelihood = 0;
     vector<int> best_genotype;
-    for (const auto& candidate : candidates) {
-        double gl = genotype_likelihood(candidate, traversals, top_traversals, traversal_sizes, traversal_mapqs,
-                                        ref_trav_idx, exp_depth, depth_err, max_trav_size, ref_trav_size);
+    vector<vector<int>> candidate_list(candidates.begin(), candidates.end());
+    vector<double> candidate_likelihoods = genotype_likelihoods(candidate_list, traversals, top_traversals, traversal_sizes, traversal_mapqs,
+                                                                ref_trav_idx, exp_depth, depth_err, max_trav_size, ref_trav_size);
+    for (size_t i = 0; i < candidate_list.size(); ++i) {
+        const vector<int>& candidate = candidate_list[i];
+        double gl = candidate_likelihoods[i];
         if (gl > best_genotype_likelihood) {
             second_best_genotype_likelihood = best_genotype_likelihood;
             best_genotype_likelihood = gl;
@@ -649,123 +652,157 @@ double PoissonSupportSnarlCaller::genotype_likelihood(const vector<int>& genotyp
                                                       int ref_trav_idx, double exp_depth, double depth_err,
                                                       int max_trav_size,
                                                       int ref_trav_size) {
-    
-    assert(genotype.size() == 1 || genotype.size() == 2);
+    return genotype_likelihoods({genotype}, traversals, trav_subset, traversal_sizes, traversal_mapqs,
+                                ref_trav_idx, exp_depth, depth_err, max_trav_size, ref_trav_size).front();
+}
 
-    // get the genotype support
-    vector<Support> genotype_supports = support_finder.get_traversal_genotype_support(traversals, genotype, trav_subset, ref_trav_idx,
-                                                                                      &max_trav_size);
+vector<double> PoissonSupportSnarlCaller::genotype_likelihoods(const vector<vector<int>>& genotypes,
+                                                               const vector<SnarlTraversal>& traversals,
+                                                               const set<int>& trav_subset,
+                                                               const vector<int>& traversal_sizes,
+                                                               const vector<double>& traversal_mapqs,
+                                                               int ref_trav_idx, double exp_depth, double depth_err,
+                                                               int max_trav_size,
+                                                               int ref_trav_size) {
 
-    // get the total support over the site
-    Support total_site_support = std::accumulate(genotype_supports.begin(), genotype_supports.end(), Support());
+    // the error rate toggles on the size of the largest traversal (see below)
+    size_t threshold = support_finder.get_average_traversal_support_switch_threshold();
 
-    // get the length-normalized mapq for the alleles
-    double total_genotype_mapq = 0;
-    size_t total_genotype_length = 0;
-    if (use_mapq) {
-        for (int i = 0; i < genotype.size(); ++i) {
-            total_genotype_mapq += traversal_mapqs[genotype[i]] * traversal_sizes[genotype[i]];
-            total_genotype_length += traversal_sizes[genotype[i]];
+    // the expected supports only take a few different values over the batch (without mapqs, they
+    // depend only on the error rate and ploidy) so we remember their logs
+    vector<pair<double, real_t>> log_lambdas;
+    auto get_log_lambda = [&](double lambda) {
+        for (const pair<double, real_t>& log_lambda : log_lambdas) {
+            if (log_lambda.first == lambda) {
+                return log_lambda.second;
+            }
         }
-    }
+        real_t log_lambda = log((real_t)lambda);
+        log_lambdas.push_back(make_pair(lambda, log_lambda));
+        return log_lambda;
+    };
+
+    vector<double> likelihoods;
+    likelihoods.reserve(genotypes.size());
+    for (const vector<int>& genotype : genotypes) {
+
+        assert(genotype.size() == 1 || genotype.size() == 2);
+        bool homozygous = genotype.size() == 1 || genotype[0] == genotype[1];
+        auto in_genotype = [&](int i) {
+            return i == genotype[0] || (genotype.size() == 2 && i == genotype[1]);
+        };
+
+        // the support finder can update this with the genotype's traversals
+        int genotype_max_trav_size = max_trav_size;
     
-    // get the total support of traversals *not* in the genotype
-    Support total_other_support;
-    // also get length-normalized mapq
-    double total_other_mapq = 0;
-    size_t total_other_length = 0;
-    set<int> genotype_set(genotype.begin(), genotype.end());
-    for (int i = 0; i < traversals.size(); ++i) {
-        if (!genotype_set.count(i)) {
-            total_other_support += genotype_supports[i];
-            if (use_mapq) {
-                total_other_mapq += traversal_mapqs[i] * traversal_sizes[i];
-                total_other_length += traversal_sizes[i];
+        // get the genotype support
+        vector<Support> genotype_supports = support_finder.get_traversal_genotype_support(traversals, genotype, trav_subset, ref_trav_idx,
+                                                                                          &genotype_max_trav_size);
+
+        // get the length-normalized mapq for the alleles
+        double total_genotype_mapq = 0;
+        size_t total_genotype_length = 0;
+        if (use_mapq) {
+            for (int i = 0; i < genotype.size(); ++i) {
+                total_genotype_mapq += traversal_mapqs[genotype[i]] * traversal_sizes[genotype[i]];
+                total_genotype_length += traversal_sizes[genotype[i]];
             }
         }
-    }
- 
-    // split the homozygous support into two
-    // from now on we'll treat it like two separate observations, each with half coverage
-    vector<Support> fixed_genotype_supports = genotype_supports;
-    if (std::equal(genotype.begin() + 1, genotype.end(), genotype.begin())) {
-        for (int i = 0; i < genotype_supports.size(); ++i) {
-            fixed_genotype_supports[i] = genotype_supports[i] / (double)genotype.size();
+    
+        // get the total support of traversals *not* in the genotype
+        Support total_other_support;
+        // also get length-normalized mapq
+        double total_other_mapq = 0;
+        size_t total_other_length = 0;
+        for (int i = 0; i < traversals.size(); ++i) {
+            if (!in_genotype(i)) {
+                total_other_support += genotype_supports[i];
+                if (use_mapq) {
+                    total_other_mapq += traversal_mapqs[i] * traversal_sizes[i];
+                    total_other_length += traversal_sizes[i];
+                }
+            }
         }
-    }
     
-    // how many reads would we expect to not map to our genotype due to error
-    // Note: The bin size is set quite a bit smaller than originally intended as it seems to
-    // help nearly nevery benchmark.  But the small bin sizes means that depth_err, the
-    // error from the binned coverage, is way too high and including it only causes trouble.
-    // tldr: just use the baseline_mapping_error constant and forget about depth_err for now. 
-    //double error_rate = std::min(0.05, depth_err + baseline_mapping_error);
-
-    // we toggle the baseline error 
-    size_t threshold = support_finder.get_average_traversal_support_switch_threshold();
-    double error_rate = max_trav_size >= threshold ? baseline_error_large : baseline_error_small;
-    // and multiply by the insertion bias if the site looks like an insertion
-    if (ref_trav_idx >= 0 && max_trav_size >= insertion_threshold * ref_trav_size) {
-        error_rate *= (max_trav_size >= threshold ? insertion_bias_large : insertion_bias_small);
-    }
+        // how many reads would we expect to not map to our genotype due to error
+        // Note: The bin size is set quite a bit smaller than originally intended as it seems to
+        // help nearly nevery benchmark.  But the small bin sizes means that depth_err, the
+        // error from the binned coverage, is way too high and including it only causes trouble.
+        // tldr: just use the baseline_mapping_error constant and forget about depth_err for now. 
+        //double error_rate = std::min(0.05, depth_err + baseline_mapping_error);
+
+        // we toggle the baseline error 
+        double error_rate = genotype_max_trav_size >= threshold ? baseline_error_large : baseline_error_small;
+        // and multiply by the insertion bias if the site looks like an insertion
+        if (ref_trav_idx >= 0 && genotype_max_trav_size >= insertion_threshold * ref_trav_size) {
+            error_rate *= (genotype_max_trav_size >= threshold ? insertion_bias_large : insertion_bias_small);
+        }
     
-    // error rate for non-allele traversals
-    double other_error_rate = error_rate;
-    if (use_mapq && total_other_length > 0) {
-        other_error_rate += phred_to_prob(total_other_mapq / total_other_length);
+        // error rate for non-allele traversals
+        double other_error_rate = error_rate;
+        if (use_mapq && total_other_length > 0) {
+            other_error_rate += phred_to_prob(total_other_mapq / total_other_length);
 #ifdef debug
-        cerr << "adding phred " << total_other_mapq << " / " << total_other_length << " to other error rate of "
-             << error_rate << " gives " << other_error_rate << endl;
+            cerr << "adding phred " << total_other_mapq << " / " << total_other_length << " to other error rate of "
+                 << error_rate << " gives " << other_error_rate << endl;
 #endif
         
-    }    
-    double other_poisson_lambda = other_error_rate * exp_depth; //support_val(total_site_support);
+        }    
+        double other_poisson_lambda = other_error_rate * exp_depth; //support_val(total_site_support);
 
-    // and our likelihood for the unmapped reads we see:
-    double other_log_likelihood = poisson_prob_ln(std::round(support_val(total_other_support)), other_poisson_lambda);
+        // and our likelihood for the unmapped reads we see:
+        double other_log_likelihood = poisson_prob_ln(std::round(support_val(total_other_support)), other_poisson_lambda,
+                                                      get_log_lambda(other_poisson_lambda));
 
-    double allele_error_rate = error_rate;
-    if (use_mapq && total_genotype_length > 0) {
-        allele_error_rate += phred_to_prob(total_genotype_mapq / total_genotype_length);
+        double allele_error_rate = error_rate;
+        if (use_mapq && total_genotype_length > 0) {
+            allele_error_rate += phred_to_prob(total_genotype_mapq / total_genotype_length);
 #ifdef debug
-        cerr << "adding phred " << total_genotype_mapq << " / " << total_genotype_length << " to allele error rate of "
-             << error_rate << " gives " << allele_error_rate << endl;
+            cerr << "adding phred " << total_genotype_mapq << " / " << total_genotype_length << " to allele error rate of "
+                 << error_rate << " gives " << allele_error_rate << endl;
 #endif        
-    }
+        }
     
-    // how many reads do we expect for an allele?  we use the expected coverage and just
-    // divide it out by the size of the genotype.  
-    double allele_poisson_lambda = (exp_depth / (double)genotype.size()) * (1. - allele_error_rate);
+        // how many reads do we expect for an allele?  we use the expected coverage and just
+        // divide it out by the size of the genotype.  
+        double allele_poisson_lambda = (exp_depth / (double)genotype.size()) * (1. - allele_error_rate);
+        real_t allele_log_lambda = get_log_lambda(allele_poisson_lambda);
 
 #ifdef debug
-    cerr << "Computing prob of genotype: {";
-    for (int i = 0; i < genotype.size(); ++i) {
-        cerr << genotype[i] << ",";
-    }
-    cerr << "}: tot_other_sup = " << total_other_support << " tot site sup = " << total_site_support 
-         << " exp-depth = " << exp_depth << " depth-err = " << depth_err << " other-lambda = " << other_poisson_lambda
-         << " allele-lambda " << allele_poisson_lambda << " ref-idx " << ref_trav_idx << endl;
+        // get the total support over the site
+        Support total_site_support = std::accumulate(genotype_supports.begin(), genotype_supports.end(), Support());
+        cerr << "Computing prob of genotype: {";
+        for (int i = 0; i < genotype.size(); ++i) {
+            cerr << genotype[i] << ",";
+        }
+        cerr << "}: tot_other_sup = " << total_other_support << " tot site sup = " << total_site_support 
+             << " exp-depth = " << exp_depth << " depth-err = " << depth_err << " other-lambda = " << other_poisson_lambda
+             << " allele-lambda " << allele_poisson_lambda << " ref-idx " << ref_trav_idx << endl;
 #endif
     
-    // now we compute the likelihood of our genotype
-    double alleles_log_likelihood = 0;
-    for (int allele : genotype) {
-        const Support& allele_support = fixed_genotype_supports[allele];
-        double allele_ll = poisson_prob_ln(std::round(support_val(allele_support)), allele_poisson_lambda);
-        alleles_log_likelihood += allele_ll;
+        // now we compute the likelihood of our genotype
+        double alleles_log_likelihood = 0;
+        for (int allele : genotype) {
+            // split the homozygous support into two
+            // from now on we'll treat it like two separate observations, each with half coverage
+            Support allele_support = homozygous ? genotype_supports[allele] / (double)genotype.size() : genotype_supports[allele];
+            double allele_ll = poisson_prob_ln(std::round(support_val(allele_support)), allele_poisson_lambda, allele_log_lambda);
+            alleles_log_likelihood += allele_ll;
 
 #ifdef debug
-        cerr << "  a[" << allele <<"]=" << " sup=" << genotype_supports[allele] << " fix-sup=" << allele_support
-             << " prob " << allele_ll << endl;
+            cerr << "  a[" << allele <<"]=" << " sup=" << genotype_supports[allele] << " fix-sup=" << allele_support
+                 << " prob " << allele_ll << endl;
 #endif        
-    }
+        }
 
 #ifdef debug
-    cerr  << " allele-log-prob " << alleles_log_likelihood << " other-log-prob " << other_log_likelihood
-          << " total-prob " << (alleles_log_likelihood + other_log_likelihood) << endl;
+        cerr  << " allele-log-prob " << alleles_log_likelihood << " other-log-prob " << other_log_likelihood
+              << " total-prob " << (alleles_log_likelihood + other_log_likelihood) << endl;
 #endif
 
-    return alleles_log_likelihood + other_log_likelihood;
+        likelihoods.push_back(alleles_log_likelihood + other_log_likelihood);
+    }
+    return likelihoods;
 }
 
 void PoissonSupportSnarlCaller::update_vcf_info(const Snarl& snarl,
@@ -844,11 +881,19 @@ void PoissonSupportSnarlCaller::update_vcf_info(const Snarl& snarl,
 
     if (genotype.size() == 2) {
         // assume ploidy 2
+        // score every pair of traversals in one batch, in the order they go in the GL field
+        vector<vector<int>> all_genotypes;
         for (int i = 0; i < traversals.size(); ++i) {
             for (int j = i; j < traversals.size(); ++j) {
-                double gl = genotype_likelihood({i, j}, traversals, {}, traversal_sizes, traversal_mapqs,
-                                                ref_trav_idx, p_call_info->expected_depth, depth_err, max_trav_size, ref_trav_size);
-                gen_likelihoods.push_back(gl);
+                all_genotypes.push_back({i, j});
+            }
+        }
+        gen_likelihoods = genotype_likelihoods(all_genotypes, traversals, {}, traversal_sizes, traversal_mapqs,
+                                               ref_trav_idx, p_call_info->expected_depth, depth_err, max_trav_size, ref_trav_size);
+        size_t gl_idx = 0;
+        for (int i = 0; i < traversals.size(); ++i) {
+            for (int j = i; j < traversals.size(); ++j) {
+                double gl = gen_likelihoods[gl_idx++];
                 if (vector<int>({i, j}) == genotype || vector<int>({j,i}) == genotype) {
                     gen_likelihood = gl;
                 }
@@ -865,10 +910,14 @@ void PoissonSupportSnarlCaller::update_vcf_info(const Snarl& snarl,
     } else if (genotype.size() == 1) {
         // assume ploidy 1
         // todo: generalize this iteration (as is, it is copy pased from above)
+        vector<vector<int>> all_genotypes;
+        for (int i = 0; i < traversals.size(); ++i) {
+            all_genotypes.push_back({i});
+        }
+        gen_likelihoods = genotype_likelihoods(all_genotypes, traversals, {}, traversal_sizes, traversal_mapqs,
+                                               ref_trav_idx, p_call_info->expected_depth, depth_err, max_trav_size, ref_trav_size);
         for (int i = 0; i < traversals.size(); ++i) {
-            double gl = genotype_likelihood({i}, traversals, {}, traversal_sizes, traversal_mapqs,
-                                            ref_trav_idx, p_call_info->expected_depth, depth_err, max_trav_size, ref_trav_size);
-            gen_likelihoods.push_back(gl);
+            double gl = gen_likelihoods[i];
             if (vector<int>({i}) == genotype) {
                 gen_likelihood = gl;
             }
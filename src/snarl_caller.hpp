@@ -249,6 +249,17 @@ protected:
                                int ref_trav_idx, double exp_depth, double depth_err,
                                int max_trav_size, int ref_trav_size);
 
+    /// Compute the above likelihood for each of a list of genotypes in one pass, working out
+    /// the error rates and expected supports (and their logs) once rather than per genotype.
+    /// The values are exactly the same as calling genotype_likelihood() on each.
+    vector<double> genotype_likelihoods(const vector<vector<int>>& genotypes,
+                                        const vector<SnarlTraversal>& traversals,
+                                        const set<int>& trav_subset,
+                                        const vector<int>& traversal_sizes,
+                                        const vector<double>& traversal_mapqs,
+                                        int ref_trav_idx, double exp_depth, double depth_err,
+                                        int max_trav_size, int ref_trav_size);
+
     /// Rank supports
     vector<int> rank_by_support(const vector<Support>& supports);
 
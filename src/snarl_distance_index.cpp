@@ -36,6 +36,296 @@ void fill_in_distance_index(SnarlDistanceIndex* distance_index, const HandleGrap
     indexes.emplace_back(&temp_index);
     distance_index->get_snarl_tree_records(indexes, graph);
 }
+
+/*Fill in the distances in a snarl, like populate_snarl_index, but return the predicted size of
+ * the snarl in the index instead of adding it to temp_index, so that independent snarls can be
+ * filled in concurrently
+ */
+static size_t populate_snarl_distances(SnarlDistanceIndex::TemporaryDistanceIndex& temp_index,
+                                       pair<SnarlDistanceIndex::temp_record_t, size_t> snarl_index, size_t size_limit,
+                                       const HandleGraph* graph);
+
+/*Fill in the prefix sums, loop distances and lengths of one chain. All chains nested in it and
+ * all snarls on it must already be done. Updates max_distance instead of the one in temp_index,
+ * so that independent chains can be filled in concurrently
+ */
+static void fill_in_chain_distances(SnarlDistanceIndex::TemporaryDistanceIndex& temp_index, size_t i,
+                                    size_t size_limit, const HandleGraph* graph, size_t& max_distance) {
+
+    SnarlDistanceIndex::TemporaryDistanceIndex::TemporaryChainRecord& temp_chain_record = temp_index.temp_chain_records[i];
+#ifdef debug_distance_indexing
+    assert(!temp_chain_record.is_trivial);
+    cerr << "  At "  << (temp_chain_record.is_trivial ? " trivial " : "") << " chain " << temp_index.structure_start_end_as_string(make_pair(SnarlDistanceIndex::TEMP_CHAIN, i)) << endl;
+#endif
+
+    //Add the first values for the prefix sum and backwards loop vectors
+    temp_chain_record.prefix_sum.emplace_back(0);
+    temp_chain_record.max_prefix_sum.emplace_back(0);
+    temp_chain_record.backward_loops.emplace_back(std::numeric_limits<size_t>::max());
+    temp_chain_record.chain_components.emplace_back(0);
+
+
+    /*First, go through each of the snarls in the chain in the forward direction and
+     * fill in the distances in the snarl. Also fill in the prefix sum and backwards
+     * loop vectors here
+     */
+    size_t curr_component = 0; //which component of the chain are we in
+    size_t last_node_length = 0;
+    for (size_t chain_child_i = 0 ; chain_child_i < temp_chain_record.children.size() ; chain_child_i++ ){
+        const pair<SnarlDistanceIndex::temp_record_t, size_t>& chain_child_index = temp_chain_record.children[chain_child_i];
+        //Go through each of the children in the chain, skipping nodes
+        //The snarl may be trivial, in which case don't fill in the distances
+#ifdef debug_distance_indexing
+        cerr << "    Looking at child " << temp_index.structure_start_end_as_string(chain_child_index) << " current max prefi xum " << temp_chain_record.max_prefix_sum.back() << endl;
+#endif
+
+        if (chain_child_index.first == SnarlDistanceIndex::TEMP_SNARL){
+            //This is where all the work gets done. Need to go through the snarl and add
+            //all distances, then add distances to the chain that this is in
+            //The parent chain will be the last thing in the stack
+            SnarlDistanceIndex::TemporaryDistanceIndex::TemporarySnarlRecord& temp_snarl_record = 
+                    temp_index.temp_snarl_records.at(chain_child_index.second);
+
+            bool new_component = temp_snarl_record.min_length == std::numeric_limits<size_t>::max();
+            if (new_component){
+                curr_component++;
+            }
+
+            //And get the distance values for the end node of the snarl in the chain
+            if (new_component) {
+                //If this snarl wasn't start-end connected, then we start 
+                //tracking the distance vectors here
+
+                //Update the maximum distance
+                max_distance = std::max(max_distance, temp_chain_record.max_prefix_sum.back());
+
+                temp_chain_record.prefix_sum.emplace_back(0);
+                temp_chain_record.max_prefix_sum.emplace_back(0);
+                temp_chain_record.backward_loops.emplace_back(temp_snarl_record.distance_end_end);
+                //If the chain is disconnected, the max length is infinite
+                temp_chain_record.max_length =  std::numeric_limits<size_t>::max();
+            } else {
+                temp_chain_record.prefix_sum.emplace_back(SnarlDistanceIndex::sum(SnarlDistanceIndex::sum(
+                                                          temp_chain_record.prefix_sum.back(),
+                                                          temp_snarl_record.min_length), 
+                                                          temp_snarl_record.start_node_length));
+                temp_chain_record.max_prefix_sum.emplace_back(SnarlDistanceIndex::sum(SnarlDistanceIndex::sum(
+                                                               temp_chain_record.max_prefix_sum.back(),
+                                                               temp_snarl_record.max_length), 
+                                                               temp_snarl_record.start_node_length));
+                temp_chain_record.backward_loops.emplace_back(std::min(temp_snarl_record.distance_end_end,
+                    SnarlDistanceIndex::sum(temp_chain_record.backward_loops.back()
+                    , 2 * (temp_snarl_record.start_node_length + temp_snarl_record.min_length))));
+                temp_chain_record.max_length = SnarlDistanceIndex::sum(temp_chain_record.max_length,
+                                                                       temp_snarl_record.max_length);
+            }
+            temp_chain_record.chain_components.emplace_back(curr_component);
+            if (chain_child_i == temp_chain_record.children.size() - 2 && temp_snarl_record.min_length == std::numeric_limits<size_t>::max()) {
+                temp_chain_record.loopable = false;
+            }
+            last_node_length = 0;
+        } else {
+            if (last_node_length != 0) {
+                //If this is a node and the last thing was also a node,
+                //then there was a trivial snarl 
+                SnarlDistanceIndex::TemporaryDistanceIndex::TemporaryNodeRecord& temp_node_record = 
+                        temp_index.temp_node_records.at(chain_child_index.second-temp_index.min_node_id);
+
+                //Check if there is a loop in this node
+                //Snarls get counted as trivial if they contain no nodes but they might still have edges
+                size_t backward_loop = std::numeric_limits<size_t>::max();
+
+                graph->follow_edges(graph->get_handle(temp_node_record.node_id, !temp_node_record.reversed_in_parent), false, [&](const handle_t next_handle) {
+                    if (graph->get_id(next_handle) == temp_node_record.node_id) {
+                        //If there is a loop going backwards (relative to the chain) back to the same node
+                        backward_loop = 0;
+                    }
+                });
+
+                temp_chain_record.prefix_sum.emplace_back(SnarlDistanceIndex::sum(temp_chain_record.prefix_sum.back(), last_node_length));
+                temp_chain_record.max_prefix_sum.emplace_back(SnarlDistanceIndex::sum(temp_chain_record.max_prefix_sum.back(), last_node_length));
+                temp_chain_record.backward_loops.emplace_back(std::min(backward_loop,
+                    SnarlDistanceIndex::sum(temp_chain_record.backward_loops.back(), 2 * last_node_length)));
+
+                if (chain_child_i == temp_chain_record.children.size()-1) {
+                    //If this is the last node
+                    temp_chain_record.loopable=false;
+                }
+                temp_chain_record.chain_components.emplace_back(curr_component);
+            }
+            last_node_length = temp_index.temp_node_records.at(chain_child_index.second - temp_index.min_node_id).node_length;
+            //And update the chains max length
+            temp_chain_record.max_length = SnarlDistanceIndex::sum(temp_chain_record.max_length,
+                                                                   last_node_length);
+        }
+    } //Finished walking through chain
+    if (temp_chain_record.start_node_id == temp_chain_record.end_node_id && temp_chain_record.chain_components.back() != 0) {
+        //If this is a looping, multicomponent chain, the start/end node could end up in separate chain components
+        //despite being the same node.
+        //Since the first component will always be 0, set the first node's component to be whatever the last
+        //component was
+        temp_chain_record.chain_components[0] = temp_chain_record.chain_components.back();
+
+    }
+
+    //For a multicomponent chain, the actual minimum length will always be infinite, but since we sometimes need
+    //the length of the last component, save that here
+    temp_chain_record.min_length = !temp_chain_record.is_trivial && temp_chain_record.start_node_id == temp_chain_record.end_node_id
+                    ? temp_chain_record.prefix_sum.back()
+                    : SnarlDistanceIndex::sum(temp_chain_record.prefix_sum.back() , temp_chain_record.end_node_length);
+
+#ifdef debug_distance_indexing
+    assert(temp_chain_record.prefix_sum.size() == temp_chain_record.backward_loops.size());
+    assert(temp_chain_record.prefix_sum.size() == temp_chain_record.chain_components.size());
+#endif
+
+
+    /*Now that we've gone through all the snarls in the chain, fill in the forward loop vector
+     * by going through the chain in the backwards direction
+     */
+    temp_chain_record.forward_loops.resize(temp_chain_record.prefix_sum.size(),
+                                           std::numeric_limits<size_t>::max());
+    if (temp_chain_record.start_node_id == temp_chain_record.end_node_id && temp_chain_record.children.size() > 1) {
+
+        //If this is a looping chain, then check the first snarl for a loop
+        if (temp_chain_record.children.at(1).first == SnarlDistanceIndex::TEMP_SNARL) {
+            SnarlDistanceIndex::TemporaryDistanceIndex::TemporarySnarlRecord& temp_snarl_record = temp_index.temp_snarl_records.at(temp_chain_record.children.at(1).second);
+            temp_chain_record.forward_loops[temp_chain_record.forward_loops.size()-1] = temp_snarl_record.distance_start_start;
+        } 
+    }
+
+    size_t node_i = temp_chain_record.prefix_sum.size() - 2;
+    // We start at the next to last node because we need to look at this record and the next one.
+    last_node_length = 0;
+    for (int j = (int)temp_chain_record.children.size() - 1 ; j >= 0 ; j--) {
+        auto& child = temp_chain_record.children.at(j);
+        if (child.first == SnarlDistanceIndex::TEMP_SNARL){
+            SnarlDistanceIndex::TemporaryDistanceIndex::TemporarySnarlRecord& temp_snarl_record = temp_index.temp_snarl_records.at(child.second);
+            if (temp_chain_record.chain_components.at(node_i) != temp_chain_record.chain_components.at(node_i+1) &&
+                temp_chain_record.chain_components.at(node_i+1) != 0){
+                //If this is a new chain component, then add the loop distance from the snarl
+                //If the component of the next node is 0, then we're still in the same component since we're going backwards
+                temp_chain_record.forward_loops.at(node_i) = temp_snarl_record.distance_start_start;
+            } else {
+                temp_chain_record.forward_loops.at(node_i) =
+                    std::min(SnarlDistanceIndex::sum(SnarlDistanceIndex::sum(
+                                temp_chain_record.forward_loops.at(node_i+1), 
+                                2* temp_snarl_record.min_length),
+                                2*temp_snarl_record.end_node_length), 
+                            temp_snarl_record.distance_start_start);
+            }
+            node_i --;
+            last_node_length = 0;
+        } else {
+            if (last_node_length != 0) {
+                SnarlDistanceIndex::TemporaryDistanceIndex::TemporaryNodeRecord& temp_node_record = 
+                        temp_index.temp_node_records.at(child.second-temp_index.min_node_id);
+
+
+                //Check if there is a loop in this node
+                //Snarls get counted as trivial if they contain no nodes but they might still have edges
+                size_t forward_loop = std::numeric_limits<size_t>::max();
+                graph->follow_edges(graph->get_handle(temp_node_record.node_id, temp_node_record.reversed_in_parent), false, [&](const handle_t next_handle) {
+                    if (graph->get_id(next_handle) == temp_node_record.node_id) {
+                        //If there is a loop going forward (relative to the chain) back to the same node
+                        forward_loop = 0;
+                    }
+                });
+                temp_chain_record.forward_loops.at(node_i) = std::min( forward_loop,
+                    SnarlDistanceIndex::sum(temp_chain_record.forward_loops.at(node_i+1) , 
+                                             2*last_node_length));
+                node_i--;
+            }
+            last_node_length = temp_index.temp_node_records.at(child.second - temp_index.min_node_id).node_length;
+        }
+    }
+
+
+    //If this is a looping chain, check if the loop distances can be improved by going around the chain
+
+    if (temp_chain_record.start_node_id == temp_chain_record.end_node_id && temp_chain_record.children.size() > 1) {
+
+
+        //Also check if the reverse loop values would be improved if we went around again
+
+        if (temp_chain_record.backward_loops.back() < temp_chain_record.backward_loops.front()) {
+            temp_chain_record.backward_loops[0] = temp_chain_record.backward_loops.back();
+            size_t node_i = 1;
+            size_t last_node_length = 0;
+            for (size_t i = 1 ; i < temp_chain_record.children.size()-1 ; i++ ) {
+                auto& child = temp_chain_record.children.at(i);
+                if (child.first == SnarlDistanceIndex::TEMP_SNARL) {
+                    SnarlDistanceIndex::TemporaryDistanceIndex::TemporarySnarlRecord& temp_snarl_record = temp_index.temp_snarl_records.at(child.second);
+                    size_t new_loop_distance = SnarlDistanceIndex::sum(SnarlDistanceIndex::sum(
+                                                  temp_chain_record.backward_loops.at(node_i-1), 
+                                                  2*temp_snarl_record.min_length), 
+                                                  2*temp_snarl_record.start_node_length); 
+                    if (temp_chain_record.chain_components.at(node_i)!= 0 || new_loop_distance >= temp_chain_record.backward_loops.at(node_i)) {
+                        //If this is a new chain component or it doesn't improve, stop
+                        break;
+                    } else {
+                        //otherwise record the better distance
+                        temp_chain_record.backward_loops.at(node_i) = new_loop_distance;
+
+                    }
+                    node_i++;
+                    last_node_length = 0;
+                } else {
+                    if (last_node_length != 0) {
+                        size_t new_loop_distance = SnarlDistanceIndex::sum(temp_chain_record.backward_loops.at(node_i-1), 
+                                2*last_node_length); 
+                        size_t old_loop_distance = temp_chain_record.backward_loops.at(node_i);
+                        temp_chain_record.backward_loops.at(node_i) = std::min(old_loop_distance,new_loop_distance);
+                        node_i++;
+                    }
+                    last_node_length = temp_index.temp_node_records.at(child.second - temp_index.min_node_id).node_length;
+                }
+            }
+        }
+        if (temp_chain_record.forward_loops.front() < temp_chain_record.forward_loops.back()) {
+            //If this is a looping chain and looping improves the forward loops, 
+            //then we have to keep going around to update distance
+
+            temp_chain_record.forward_loops.back() = temp_chain_record.forward_loops.front();
+            size_t last_node_length = 0;
+            node_i = temp_chain_record.prefix_sum.size() - 2;
+            for (int j = (int)temp_chain_record.children.size() - 1 ; j >= 0 ; j--) {
+                auto& child = temp_chain_record.children.at(j);
+                if (child.first == SnarlDistanceIndex::TEMP_SNARL){
+                    SnarlDistanceIndex::TemporaryDistanceIndex::TemporarySnarlRecord& temp_snarl_record = temp_index.temp_snarl_records.at(child.second);
+                    size_t new_distance = SnarlDistanceIndex::sum(SnarlDistanceIndex::sum(
+                                            temp_chain_record.forward_loops.at(node_i+1), 
+                                            2* temp_snarl_record.min_length),
+                                            2*temp_snarl_record.end_node_length);
+                    if (temp_chain_record.chain_components.at(node_i) != temp_chain_record.chain_components.at(node_i+1) ||
+                        new_distance >= temp_chain_record.forward_loops.at(node_i)){
+                        //If this is a new component or the distance doesn't improve, stop looking
+                        break;
+                    } else {
+                        //otherwise, update the distance
+                        temp_chain_record.forward_loops.at(node_i) = new_distance;
+                    }
+                    node_i --;
+                    last_node_length =0;
+                } else {
+                    if (last_node_length != 0) {
+                        size_t new_distance = SnarlDistanceIndex::sum(temp_chain_record.forward_loops.at(node_i+1) , 2* last_node_length);
+                        size_t old_distance = temp_chain_record.forward_loops.at(node_i);
+                        temp_chain_record.forward_loops.at(node_i) = std::min(old_distance, new_distance);
+                        node_i--;
+                    }
+                    last_node_length = temp_index.temp_node_records.at(child.second - temp_index.min_node_id).node_length;
+                }
+            } 
+        }
+    }
+
+    max_distance = std::max(max_distance, temp_chain_record.max_prefix_sum.back());
+    max_distance = temp_chain_record.forward_loops.back() == std::numeric_limits<size_t>::max() ? max_distance : std::max(max_distance, temp_chain_record.forward_loops.back());
+    max_distance = temp_chain_record.backward_loops.front() == std::numeric_limits<size_t>::max() ? max_distance : std::max(max_distance, temp_chain_record.backward_loops.front());
+    assert(max_distance <= 2742664019);
+}
+
 SnarlDistanceIndex::TemporaryDistanceIndex make_temporary_distance_index(
     const HandleGraph* graph, const HandleGraphSnarlFinder* snarl_finder, size_t size_limit)  {
 
@@ -446,285 +736,54 @@ SnarlDistanceIndex::TemporaryDistanceIndex make_temporary_distance_index(
 #ifdef debug_distance_indexing
     cerr << "Filling in the distances in snarls" << endl;
 #endif
-    for (int i = temp_index.temp_chain_records.size()-1 ; i >= 0 ; i--) {
-
-        SnarlDistanceIndex::TemporaryDistanceIndex::TemporaryChainRecord& temp_chain_record = temp_index.temp_chain_records[i];
-#ifdef debug_distance_indexing
-        assert(!temp_chain_record.is_trivial);
-        cerr << "  At "  << (temp_chain_record.is_trivial ? " trivial " : "") << " chain " << temp_index.structure_start_end_as_string(make_pair(SnarlDistanceIndex::TEMP_CHAIN, i)) << endl;
-#endif
-
-        //Add the first values for the prefix sum and backwards loop vectors
-        temp_chain_record.prefix_sum.emplace_back(0);
-        temp_chain_record.max_prefix_sum.emplace_back(0);
-        temp_chain_record.backward_loops.emplace_back(std::numeric_limits<size_t>::max());
-        temp_chain_record.chain_components.emplace_back(0);
-
-
-        /*First, go through each of the snarls in the chain in the forward direction and
-         * fill in the distances in the snarl. Also fill in the prefix sum and backwards
-         * loop vectors here
-         */
-        size_t curr_component = 0; //which component of the chain are we in
-        size_t last_node_length = 0;
-        for (size_t chain_child_i = 0 ; chain_child_i < temp_chain_record.children.size() ; chain_child_i++ ){
-            const pair<SnarlDistanceIndex::temp_record_t, size_t>& chain_child_index = temp_chain_record.children[chain_child_i];
-            //Go through each of the children in the chain, skipping nodes
-            //The snarl may be trivial, in which case don't fill in the distances
-#ifdef debug_distance_indexing
-            cerr << "    Looking at child " << temp_index.structure_start_end_as_string(chain_child_index) << " current max prefi xum " << temp_chain_record.max_prefix_sum.back() << endl;
-#endif
-
-            if (chain_child_index.first == SnarlDistanceIndex::TEMP_SNARL){
-                //This is where all the work gets done. Need to go through the snarl and add
-                //all distances, then add distances to the chain that this is in
-                //The parent chain will be the last thing in the stack
-                SnarlDistanceIndex::TemporaryDistanceIndex::TemporarySnarlRecord& temp_snarl_record = 
-                        temp_index.temp_snarl_records.at(chain_child_index.second);
-
-                //Fill in this snarl's distances
-                populate_snarl_index(temp_index, chain_child_index, size_limit, graph);
-
-                bool new_component = temp_snarl_record.min_length == std::numeric_limits<size_t>::max();
-                if (new_component){
-                    curr_component++;
-                }
-
-                //And get the distance values for the end node of the snarl in the chain
-                if (new_component) {
-                    //If this snarl wasn't start-end connected, then we start 
-                    //tracking the distance vectors here
-
-                    //Update the maximum distance
-                    temp_index.max_distance = std::max(temp_index.max_distance, temp_chain_record.max_prefix_sum.back());
-
-                    temp_chain_record.prefix_sum.emplace_back(0);
-                    temp_chain_record.max_prefix_sum.emplace_back(0);
-                    temp_chain_record.backward_loops.emplace_back(temp_snarl_record.distance_end_end);
-                    //If the chain is disconnected, the max length is infinite
-                    temp_chain_record.max_length =  std::numeric_limits<size_t>::max();
-                } else {
-                    temp_chain_record.prefix_sum.emplace_back(SnarlDistanceIndex::sum(SnarlDistanceIndex::sum(
-                                                              temp_chain_record.prefix_sum.back(),
-                                                              temp_snarl_record.min_length), 
-                                                              temp_snarl_record.start_node_length));
-                    temp_chain_record.max_prefix_sum.emplace_back(SnarlDistanceIndex::sum(SnarlDistanceIndex::sum(
-                                                                   temp_chain_record.max_prefix_sum.back(),
-                                                                   temp_snarl_record.max_length), 
-                                                                   temp_snarl_record.start_node_length));
-                    temp_chain_record.backward_loops.emplace_back(std::min(temp_snarl_record.distance_end_end,
-                        SnarlDistanceIndex::sum(temp_chain_record.backward_loops.back()
-                        , 2 * (temp_snarl_record.start_node_length + temp_snarl_record.min_length))));
-                    temp_chain_record.max_length = SnarlDistanceIndex::sum(temp_chain_record.max_length,
-                                                                           temp_snarl_record.max_length);
-                }
-                temp_chain_record.chain_components.emplace_back(curr_component);
-                if (chain_child_i == temp_chain_record.children.size() - 2 && temp_snarl_record.min_length == std::numeric_limits<size_t>::max()) {
-                    temp_chain_record.loopable = false;
-                }
-                last_node_length = 0;
-            } else {
-                if (last_node_length != 0) {
-                    //If this is a node and the last thing was also a node,
-                    //then there was a trivial snarl 
-                    SnarlDistanceIndex::TemporaryDistanceIndex::TemporaryNodeRecord& temp_node_record = 
-                            temp_index.temp_node_records.at(chain_child_index.second-temp_index.min_node_id);
-
-                    //Check if there is a loop in this node
-                    //Snarls get counted as trivial if they contain no nodes but they might still have edges
-                    size_t backward_loop = std::numeric_limits<size_t>::max();
-
-                    graph->follow_edges(graph->get_handle(temp_node_record.node_id, !temp_node_record.reversed_in_parent), false, [&](const handle_t next_handle) {
-                        if (graph->get_id(next_handle) == temp_node_record.node_id) {
-                            //If there is a loop going backwards (relative to the chain) back to the same node
-                            backward_loop = 0;
-                        }
-                    });
-
-                    temp_chain_record.prefix_sum.emplace_back(SnarlDistanceIndex::sum(temp_chain_record.prefix_sum.back(), last_node_length));
-                    temp_chain_record.max_prefix_sum.emplace_back(SnarlDistanceIndex::sum(temp_chain_record.max_prefix_sum.back(), last_node_length));
-                    temp_chain_record.backward_loops.emplace_back(std::min(backward_loop,
-                        SnarlDistanceIndex::sum(temp_chain_record.backward_loops.back(), 2 * last_node_length)));
-
-                    if (chain_child_i == temp_chain_record.children.size()-1) {
-                        //If this is the last node
-                        temp_chain_record.loopable=false;
-                    }
-                    temp_chain_record.chain_components.emplace_back(curr_component);
-                }
-                last_node_length = temp_index.temp_node_records.at(chain_child_index.second - temp_index.min_node_id).node_length;
-                //And update the chains max length
-                temp_chain_record.max_length = SnarlDistanceIndex::sum(temp_chain_record.max_length,
-                                                                       last_node_length);
+    // Each snarl only depends on the chains nested in it, and each chain only depends on the
+    // snarls on it, so we go up the snarl tree one level of nesting at a time. At each level, all
+    // of the snarls on the chains are filled in concurrently, and then all of the chains. Every
+    // record is written by the same code as before, so the index is the same for any number of
+    // threads. Parents were found before their children, so their depths are known first.
+    vector<size_t> chain_depth (temp_index.temp_chain_records.size(), 0);
+    vector<vector<size_t>> chains_by_depth;
+    for (size_t i = 0 ; i < temp_index.temp_chain_records.size() ; i++) {
+        const auto& parent = temp_index.temp_chain_records[i].parent;
+        if (parent.first == SnarlDistanceIndex::TEMP_SNARL) {
+            const auto& grandparent = temp_index.temp_snarl_records[parent.second].parent;
+            if (grandparent.first == SnarlDistanceIndex::TEMP_CHAIN) {
+                chain_depth[i] = chain_depth[grandparent.second] + 1;
             }
-        } //Finished walking through chain
-        if (temp_chain_record.start_node_id == temp_chain_record.end_node_id && temp_chain_record.chain_components.back() != 0) {
-            //If this is a looping, multicomponent chain, the start/end node could end up in separate chain components
-            //despite being the same node.
-            //Since the first component will always be 0, set the first node's component to be whatever the last
-            //component was
-            temp_chain_record.chain_components[0] = temp_chain_record.chain_components.back();
-
         }
-
-        //For a multicomponent chain, the actual minimum length will always be infinite, but since we sometimes need
-        //the length of the last component, save that here
-        temp_chain_record.min_length = !temp_chain_record.is_trivial && temp_chain_record.start_node_id == temp_chain_record.end_node_id
-                        ? temp_chain_record.prefix_sum.back()
-                        : SnarlDistanceIndex::sum(temp_chain_record.prefix_sum.back() , temp_chain_record.end_node_length);
-
-#ifdef debug_distance_indexing
-        assert(temp_chain_record.prefix_sum.size() == temp_chain_record.backward_loops.size());
-        assert(temp_chain_record.prefix_sum.size() == temp_chain_record.chain_components.size());
-#endif
-
-
-        /*Now that we've gone through all the snarls in the chain, fill in the forward loop vector
-         * by going through the chain in the backwards direction
-         */
-        temp_chain_record.forward_loops.resize(temp_chain_record.prefix_sum.size(),
-                                               std::numeric_limits<size_t>::max());
-        if (temp_chain_record.start_node_id == temp_chain_record.end_node_id && temp_chain_record.children.size() > 1) {
-
-            //If this is a looping chain, then check the first snarl for a loop
-            if (temp_chain_record.children.at(1).first == SnarlDistanceIndex::TEMP_SNARL) {
-                SnarlDistanceIndex::TemporaryDistanceIndex::TemporarySnarlRecord& temp_snarl_record = temp_index.temp_snarl_records.at(temp_chain_record.children.at(1).second);
-                temp_chain_record.forward_loops[temp_chain_record.forward_loops.size()-1] = temp_snarl_record.distance_start_start;
-            } 
+        if (chains_by_depth.size() <= chain_depth[i]) {
+            chains_by_depth.resize(chain_depth[i] + 1);
         }
+        chains_by_depth[chain_depth[i]].push_back(i);
+    }
 
-        size_t node_i = temp_chain_record.prefix_sum.size() - 2;
-        // We start at the next to last node because we need to look at this record and the next one.
-        last_node_length = 0;
-        for (int j = (int)temp_chain_record.children.size() - 1 ; j >= 0 ; j--) {
-            auto& child = temp_chain_record.children.at(j);
-            if (child.first == SnarlDistanceIndex::TEMP_SNARL){
-                SnarlDistanceIndex::TemporaryDistanceIndex::TemporarySnarlRecord& temp_snarl_record = temp_index.temp_snarl_records.at(child.second);
-                if (temp_chain_record.chain_components.at(node_i) != temp_chain_record.chain_components.at(node_i+1) &&
-                    temp_chain_record.chain_components.at(node_i+1) != 0){
-                    //If this is a new chain component, then add the loop distance from the snarl
-                    //If the component of the next node is 0, then we're still in the same component since we're going backwards
-                    temp_chain_record.forward_loops.at(node_i) = temp_snarl_record.distance_start_start;
-                } else {
-                    temp_chain_record.forward_loops.at(node_i) =
-                        std::min(SnarlDistanceIndex::sum(SnarlDistanceIndex::sum(
-                                    temp_chain_record.forward_loops.at(node_i+1), 
-                                    2* temp_snarl_record.min_length),
-                                    2*temp_snarl_record.end_node_length), 
-                                temp_snarl_record.distance_start_start);
-                }
-                node_i --;
-                last_node_length = 0;
-            } else {
-                if (last_node_length != 0) {
-                    SnarlDistanceIndex::TemporaryDistanceIndex::TemporaryNodeRecord& temp_node_record = 
-                            temp_index.temp_node_records.at(child.second-temp_index.min_node_id);
-
-
-                    //Check if there is a loop in this node
-                    //Snarls get counted as trivial if they contain no nodes but they might still have edges
-                    size_t forward_loop = std::numeric_limits<size_t>::max();
-                    graph->follow_edges(graph->get_handle(temp_node_record.node_id, temp_node_record.reversed_in_parent), false, [&](const handle_t next_handle) {
-                        if (graph->get_id(next_handle) == temp_node_record.node_id) {
-                            //If there is a loop going forward (relative to the chain) back to the same node
-                            forward_loop = 0;
-                        }
-                    });
-                    temp_chain_record.forward_loops.at(node_i) = std::min( forward_loop,
-                        SnarlDistanceIndex::sum(temp_chain_record.forward_loops.at(node_i+1) , 
-                                                 2*last_node_length));
-                    node_i--;
+    size_t max_distance = temp_index.max_distance;
+    for (size_t depth = chains_by_depth.size() ; depth-- > 0 ;) {
+        const vector<size_t>& chains = chains_by_depth[depth];
+        vector<size_t> snarls;
+        for (size_t i : chains) {
+            for (const auto& chain_child_index : temp_index.temp_chain_records[i].children) {
+                if (chain_child_index.first == SnarlDistanceIndex::TEMP_SNARL) {
+                    snarls.push_back(chain_child_index.second);
                 }
-                last_node_length = temp_index.temp_node_records.at(child.second - temp_index.min_node_id).node_length;
             }
         }
 
-
-        //If this is a looping chain, check if the loop distances can be improved by going around the chain
-
-        if (temp_chain_record.start_node_id == temp_chain_record.end_node_id && temp_chain_record.children.size() > 1) {
-
-
-            //Also check if the reverse loop values would be improved if we went around again
-
-            if (temp_chain_record.backward_loops.back() < temp_chain_record.backward_loops.front()) {
-                temp_chain_record.backward_loops[0] = temp_chain_record.backward_loops.back();
-                size_t node_i = 1;
-                size_t last_node_length = 0;
-                for (size_t i = 1 ; i < temp_chain_record.children.size()-1 ; i++ ) {
-                    auto& child = temp_chain_record.children.at(i);
-                    if (child.first == SnarlDistanceIndex::TEMP_SNARL) {
-                        SnarlDistanceIndex::TemporaryDistanceIndex::TemporarySnarlRecord& temp_snarl_record = temp_index.temp_snarl_records.at(child.second);
-                        size_t new_loop_distance = SnarlDistanceIndex::sum(SnarlDistanceIndex::sum(
-                                                      temp_chain_record.backward_loops.at(node_i-1), 
-                                                      2*temp_snarl_record.min_length), 
-                                                      2*temp_snarl_record.start_node_length); 
-                        if (temp_chain_record.chain_components.at(node_i)!= 0 || new_loop_distance >= temp_chain_record.backward_loops.at(node_i)) {
-                            //If this is a new chain component or it doesn't improve, stop
-                            break;
-                        } else {
-                            //otherwise record the better distance
-                            temp_chain_record.backward_loops.at(node_i) = new_loop_distance;
-
-                        }
-                        node_i++;
-                        last_node_length = 0;
-                    } else {
-                        if (last_node_length != 0) {
-                            size_t new_loop_distance = SnarlDistanceIndex::sum(temp_chain_record.backward_loops.at(node_i-1), 
-                                    2*last_node_length); 
-                            size_t old_loop_distance = temp_chain_record.backward_loops.at(node_i);
-                            temp_chain_record.backward_loops.at(node_i) = std::min(old_loop_distance,new_loop_distance);
-                            node_i++;
-                        }
-                        last_node_length = temp_index.temp_node_records.at(child.second - temp_index.min_node_id).node_length;
-                    }
-                }
-            }
-            if (temp_chain_record.forward_loops.front() < temp_chain_record.forward_loops.back()) {
-                //If this is a looping chain and looping improves the forward loops, 
-                //then we have to keep going around to update distance
-
-                temp_chain_record.forward_loops.back() = temp_chain_record.forward_loops.front();
-                size_t last_node_length = 0;
-                node_i = temp_chain_record.prefix_sum.size() - 2;
-                for (int j = (int)temp_chain_record.children.size() - 1 ; j >= 0 ; j--) {
-                    auto& child = temp_chain_record.children.at(j);
-                    if (child.first == SnarlDistanceIndex::TEMP_SNARL){
-                        SnarlDistanceIndex::TemporaryDistanceIndex::TemporarySnarlRecord& temp_snarl_record = temp_index.temp_snarl_records.at(child.second);
-                        size_t new_distance = SnarlDistanceIndex::sum(SnarlDistanceIndex::sum(
-                                                temp_chain_record.forward_loops.at(node_i+1), 
-                                                2* temp_snarl_record.min_length),
-                                                2*temp_snarl_record.end_node_length);
-                        if (temp_chain_record.chain_components.at(node_i) != temp_chain_record.chain_components.at(node_i+1) ||
-                            new_distance >= temp_chain_record.forward_loops.at(node_i)){
-                            //If this is a new component or the distance doesn't improve, stop looking
-                            break;
-                        } else {
-                            //otherwise, update the distance
-                            temp_chain_record.forward_loops.at(node_i) = new_distance;
-                        }
-                        node_i --;
-                        last_node_length =0;
-                    } else {
-                        if (last_node_length != 0) {
-                            size_t new_distance = SnarlDistanceIndex::sum(temp_chain_record.forward_loops.at(node_i+1) , 2* last_node_length);
-                            size_t old_distance = temp_chain_record.forward_loops.at(node_i);
-                            temp_chain_record.forward_loops.at(node_i) = std::min(old_distance, new_distance);
-                            node_i--;
-                        }
-                        last_node_length = temp_index.temp_node_records.at(child.second - temp_index.min_node_id).node_length;
-                    }
-                } 
-            }
+        // The sizes of the snarls are added up separately, rather than into the shared total
+        size_t snarls_index_size = 0;
+#pragma omp parallel for schedule(dynamic, 1) reduction(+ : snarls_index_size)
+        for (size_t j = 0 ; j < snarls.size() ; j++) {
+            snarls_index_size += populate_snarl_distances(temp_index, make_pair(SnarlDistanceIndex::TEMP_SNARL, snarls[j]),
+                                                          size_limit, graph);
         }
+        temp_index.max_index_size += snarls_index_size;
 
-        temp_index.max_distance = std::max(temp_index.max_distance, temp_chain_record.max_prefix_sum.back());
-        temp_index.max_distance = temp_chain_record.forward_loops.back() == std::numeric_limits<size_t>::max() ? temp_index.max_distance : std::max(temp_index.max_distance, temp_chain_record.forward_loops.back());
-        temp_index.max_distance = temp_chain_record.backward_loops.front() == std::numeric_limits<size_t>::max() ? temp_index.max_distance : std::max(temp_index.max_distance, temp_chain_record.backward_loops.front());
-        assert(temp_index.max_distance <= 2742664019);
-
+#pragma omp parallel for schedule(dynamic, 1) reduction(max : max_distance)
+        for (size_t j = 0 ; j < chains.size() ; j++) {
+            fill_in_chain_distances(temp_index, chains[j], size_limit, graph, max_distance);
+        }
     }
+    temp_index.max_distance = max_distance;
 
 #ifdef debug_distance_indexing
     cerr << "Filling in the distances in root snarls and distances along chains" << endl;
@@ -756,6 +815,13 @@ void populate_snarl_index(
                 SnarlDistanceIndex::TemporaryDistanceIndex& temp_index,
                 pair<SnarlDistanceIndex::temp_record_t, size_t> snarl_index, size_t size_limit,
                 const HandleGraph* graph) {
+    temp_index.max_index_size += populate_snarl_distances(temp_index, snarl_index, size_limit, graph);
+}
+
+static size_t populate_snarl_distances(
+                SnarlDistanceIndex::TemporaryDistanceIndex& temp_index,
+                pair<SnarlDistanceIndex::temp_record_t, size_t> snarl_index, size_t size_limit,
+                const HandleGraph* graph) {
 #ifdef debug_distance_indexing
     cerr << "Getting the distances for snarl " << temp_index.structure_start_end_as_string(snarl_index) << endl;
     assert(snarl_index.first == SnarlDistanceIndex::TEMP_SNARL);
@@ -1068,6 +1134,7 @@ void populate_snarl_index(
             : temp_snarl_record.node_count * temp_snarl_record.node_count);
 
     if (size_limit != 0 && temp_snarl_record.node_count > size_limit) {
+#pragma omp critical (use_oversized_snarls)
         temp_index.use_oversized_snarls = true;
     }
 
@@ -1457,12 +1524,11 @@ void populate_snarl_index(
     }
 
     //Now that the distances are filled in, predict the size of the snarl in the index
-    temp_index.max_index_size += temp_snarl_record.get_max_record_length();
+    size_t snarl_index_size = temp_snarl_record.get_max_record_length();
     if (temp_snarl_record.is_simple) {
-        temp_index.max_index_size -= (temp_snarl_record.children.size() * SnarlDistanceIndex::TemporaryDistanceIndex::TemporaryNodeRecord::get_max_record_length());
+        snarl_index_size -= (temp_snarl_record.children.size() * SnarlDistanceIndex::TemporaryDistanceIndex::TemporaryNodeRecord::get_max_record_length());
     }
-
-
+    return snarl_index_size;
 }
 
 
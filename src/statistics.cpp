@@ -10,6 +10,19 @@
 namespace vg {
 
 
+const vector<real_t>& factorial_ln_table() {
+    // function-local static, so it's built exactly once even with many threads
+    static const vector<real_t> table = []() {
+        vector<real_t> values(FACTORIAL_LN_TABLE_SIZE);
+        values[0] = 0.0;
+        for (int n = 1; n < FACTORIAL_LN_TABLE_SIZE; ++n) {
+            values[n] = gamma_ln(n + 1.0);
+        }
+        return values;
+    }();
+    return table;
+}
+
 double median(std::vector<int> &v) {
     size_t n = v.size() / 2;
     std::nth_element(v.begin(), v.begin()+n, v.end());
@@ -450,9 +450,18 @@ inline real_t gamma_ln(real_t x) {
     return y;
 }
 
+/// Number of factorial_ln() values that are looked up in a table rather than computed
+const int FACTORIAL_LN_TABLE_SIZE = 4096;
+
 /**
- * Calculate the natural log of the factorial of the given integer. TODO:
- * replace with a cache or giant lookup table from Freebayes.
+ * Get the table of factorial_ln(n) for 0 <= n < FACTORIAL_LN_TABLE_SIZE. It's
+ * computed (in the same way as factorial_ln()) the first time it's needed.
+ */
+const vector<real_t>& factorial_ln_table();
+
+/**
+ * Calculate the natural log of the factorial of the given integer. Small
+ * values (like read counts) are looked up in a table.
  */
 inline real_t factorial_ln(int n) {
     if (n < 0) {
@@ -461,6 +470,9 @@ inline real_t factorial_ln(int n) {
     else if (n == 0) {
         return (long double)0.0;
     }
+    else if (n < FACTORIAL_LN_TABLE_SIZE) {
+        return factorial_ln_table()[n];
+    }
     else {
         return gamma_ln(n + 1.0);
     }
@@ -523,6 +535,14 @@ inline real_t poisson_prob_ln(int observed, real_t expected) {
     return log(expected) * (real_t) observed - expected - factorial_ln(observed);
 }
 
+/**
+ * As above, but with log(expected) already computed, for when many
+ * observations are scored against the same expectation.
+ */
+inline real_t poisson_prob_ln(int observed, real_t expected, real_t log_expected) {
+    return log_expected * (real_t) observed - expected - factorial_ln(observed);
+}
+
 /**
  * Get the probability for sampling the counts in obs from a set of categories
  * weighted by the probabilities in probs. Works for both double and real_t
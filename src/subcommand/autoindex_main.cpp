@@ -16,6 +16,7 @@
 
 #include "subcommand.hpp"
 #include "index_registry.hpp"
+#include "job_schedule.hpp"
 #include "utility.hpp"
 
 using namespace std;
@@ -123,6 +124,12 @@ void help_autoindex(char** argv) {
 //    << "                           increased for graphs with long haplotypes (default: " << IndexingParameters::gbwt_insert_batch_size / gbwt::MILLION << ")" << endl
 //    << "    --gcsa-size-limit NUM  limit on size of GCSA2 temporary files on disk in bytes" << endl
     << "    -t, --threads NUM      number of threads (default: all available)" << endl
+    << "    --cache-dir DIR        reuse indexes from earlier runs that are stored in DIR, and store" << endl
+    << "                           this run's indexes there" << endl
+    << "    --cost-cache FILE      learn memory estimates for parallel jobs from measurements, and" << endl
+    << "                           keep them in FILE for later runs" << endl
+    << "    --max-recipes NUM      max number of independent indexes to build at once, sharing" << endl
+    << "                           the threads and memory (default: " << IndexingParameters::max_concurrent_recipes << ")" << endl
     << "    -V, --verbosity NUM    log to stderr (0 = none, 1 = basic, 2 = debug; default " << (int) IndexingParameters::verbosity << ")" << endl
     //<< "    -d, --dot              print the dot-formatted graph of index recipes and exit" << endl
     << "    -h, --help             print this help message to stderr and exit" << endl;
@@ -140,6 +147,9 @@ int main_autoindex(int argc, char** argv) {
 #define OPT_FORCE_PHASED 1002
 #define OPT_GBWT_BUFFER_SIZE 1003
 #define OPT_GCSA_SIZE_LIMIT 1004
+#define OPT_MAX_RECIPES 1005
+#define OPT_COST_CACHE 1006
+#define OPT_CACHE_DIR 1007
     
     // load the registry
     IndexRegistry registry = VGIndexes::get_vg_index_registry();
@@ -180,6 +190,9 @@ int main_autoindex(int argc, char** argv) {
             {"keep-intermediate", no_argument, 0, OPT_KEEP_INTERMEDIATE},
             {"force-unphased", no_argument, 0, OPT_FORCE_UNPHASED},
             {"force-phased", no_argument, 0, OPT_FORCE_PHASED},
+            {"max-recipes", required_argument, 0, OPT_MAX_RECIPES},
+            {"cost-cache", required_argument, 0, OPT_COST_CACHE},
+            {"cache-dir", required_argument, 0, OPT_CACHE_DIR},
             {0, 0, 0, 0}
         };
 
@@ -292,6 +305,19 @@ int main_autoindex(int argc, char** argv) {
             case OPT_GCSA_SIZE_LIMIT:
                 IndexingParameters::gcsa_size_limit = parse<int64_t>(optarg);
                 break;
+            case OPT_CACHE_DIR:
+                registry.set_cache_dir(optarg);
+                break;
+            case OPT_COST_CACHE:
+                JobSchedule::set_cost_cache(optarg);
+                break;
+            case OPT_MAX_RECIPES:
+                IndexingParameters::max_concurrent_recipes = parse<int>(optarg);
+                if (IndexingParameters::max_concurrent_recipes < 1) {
+                    cerr << "error: Max recipes (--max-recipes) must be a positive integer: " << optarg << endl;
+                    return 1;
+                }
+                break;
             case 'h':
                 help_autoindex(argv);
                 return 0;
@@ -16,6 +16,9 @@
 
 #include "../gbwt_extender.hpp"
 #include "../gbwt_helper.hpp"
+#include "../multipath_alignment_graph.hpp"
+
+#include "bdsg/hash_graph.hpp"
 
 
 
@@ -173,6 +176,73 @@ int main_benchmark(int argc, char** argv) {
         }));
     }
         
+    for (bool repetitive : {false, true}) {
+        // Benchmark the gap-filling DP in MultipathAlignmentGraph::align. In
+        // a tandem repeat, every copy of the repeat unit in the read hits
+        // every copy in the graph, so many of the gaps are the same problem.
+        
+        size_t unit_count = 8;
+        std::vector<std::string> units;
+        std::string base_unit = "CATGCAGT";
+        for (size_t i = 0; i < unit_count; i++) {
+            // Unique units are distinct rotations of the base unit
+            size_t rotation = repetitive ? 0 : i % base_unit.size();
+            units.push_back(base_unit.substr(rotation) + base_unit.substr(0, rotation));
+        }
+        
+        // Lay the units out in a linear graph
+        bdsg::HashGraph graph;
+        handle_t prev;
+        for (size_t i = 0; i < unit_count; i++) {
+            handle_t h = graph.create_handle(units[i], i + 1);
+            if (i != 0) {
+                graph.create_edge(prev, h);
+            }
+            prev = h;
+        }
+        auto identity = MultipathAlignmentGraph::create_identity_projection_trans(graph);
+        
+        // The read has an inserted base between each unit
+        Alignment read;
+        std::stringstream read_stream;
+        for (size_t i = 0; i < unit_count; i++) {
+            read_stream << (i == 0 ? "" : "A") << units[i];
+        }
+        read.set_sequence(read_stream.str());
+        
+        // Make a MEM for each unit, hitting every node with the same sequence
+        std::vector<MaximalExactMatch> mems;
+        mems.reserve(unit_count);
+        MultipathMapper::memcluster_t hits;
+        hits.second = 1.0;
+        size_t read_offset = 0;
+        for (size_t i = 0; i < unit_count; i++) {
+            mems.emplace_back(read.sequence().begin() + read_offset, read.sequence().begin() + read_offset + units[i].size(),
+                              gcsa::range_type(0, 0), 1);
+            read_offset += units[i].size() + 1;
+            for (size_t j = 0; j < unit_count; j++) {
+                if (units[j] == units[i]) {
+                    hits.first.emplace_back(&mems.back(), make_pos_t(j + 1, false, 0));
+                }
+            }
+        }
+        
+        Aligner aligner;
+        std::unique_ptr<MultipathAlignmentGraph> mpg;
+        
+        results.push_back(run_benchmark(std::string("MultipathAlignmentGraph::align() on ") + (repetitive ? "repetitive" : "unique") + " gaps",
+                                        100, [&]() {
+            // Build the graph outside the timed section
+            MultipathMapper::memcluster_t cluster = hits;
+            std::vector<size_t> provenance;
+            mpg.reset(new MultipathAlignmentGraph(graph, cluster, identity, provenance));
+        }, [&]() {
+            multipath_alignment_t out;
+            mpg->align(read, graph, &aligner, true, 4, false, 100, 0.0, std::numeric_limits<size_t>::max(), false, 0, 5, out);
+            assert(out.subpath_size() > 0);
+        }));
+    }
+    
     // Do the control against itself
     results.push_back(run_benchmark("control", 1000, benchmark_control));
     
@@ -20,6 +20,8 @@
 #include <vg/io/stream.hpp>
 #include <vg/io/vpkg.hpp>
 #include <bdsg/overlays/overlay_helper.hpp>
+#include <htslib/bgzf.h>
+#include <htslib/tbx.h>
 
 using namespace std;
 using namespace vg;
@@ -29,16 +31,23 @@ using namespace vg::subcommand;
 typedef bdsg::PairOverlayHelper<PathPositionHandleGraph, bdsg::PackedReferencePathOverlay, PathHandleGraph,
                                 VectorizableHandleGraph, bdsg::PathPositionVectorizableOverlay, PathPositionHandleGraph> ReferencePathVectorizableOverlayHelper;
 
+/// Window size used by --bgzip-out when --window isn't given
+static const size_t default_window_size = 10000;
+
 void help_call(char** argv) {
   cerr << "usage: " << argv[0] << " call [options] <graph> > output.vcf" << endl
        << "Call variants or genotype known variants" << endl
        << endl
        << "support calling options:" << endl
-       << "    -k, --pack FILE          Supports created from vg pack for given input graph" << endl
+       << "    -k, --pack FILE          Supports created from vg pack for given input graph.  Give once per sample (along with" << endl
+       << "                             -s) to genotype several samples jointly into a multi-sample VCF" << endl
        << "    -m, --min-support M,N    Minimum allele support (M) and minimum site support (N) for call [default = 2,4]" << endl
        << "    -e, --baseline-error X,Y Baseline error rates for Poisson model for small (X) and large (Y) variants [default= 0.005,0.01]" << endl
        << "    -B, --bias-mode          Use old ratio-based genotyping algorithm as opposed to porbablistic model" << endl
        << "    -b, --het-bias M,N       Homozygous alt/ref allele must have >= M/N times more support than the next best allele [default = 6,6]" << endl
+       << "        --depth-index FILE   Use the depth index (from vg depth --index-out on the same pack) instead of computing it" << endl
+       << "        --precompute-supports  Read all node, edge and snarl supports out of the pack up front, instead of on demand" << endl
+       << "                             (faster genotyping when most of the pack is visited, but scans the whole pack)" << endl
        << "GAF options:" << endl
        << "    -G, --gaf               Output GAF genotypes instead of VCF" << endl
        << "    -T, --traversals        Output all candidate traversals in GAF without doing any genotyping" << endl
@@ -51,7 +60,7 @@ void help_call(char** argv) {
        << "    -C, --max-length N      Genotype only snarls where all traversals have length <= N" << endl
        << "    -f, --ref-fasta FILE    Reference fasta (required if VCF contains symbolic deletions or inversions)" << endl
        << "    -i, --ins-fasta FILE    Insertions fasta (required if VCF contains symbolic insertions)" << endl
-       << "    -s, --sample NAME       Sample name [default=SAMPLE]" << endl
+       << "    -s, --sample NAME       Sample name [default=SAMPLE] (multiple allowed, 1 per pack)" << endl
        << "    -r, --snarls FILE       Snarls (from vg snarls) to avoid recomputing." << endl
        << "    -g, --gbwt FILE         Only call genotypes that are present in given GBWT index." << endl
        << "    -z, --gbz               Only call genotypes that are present in GBZ index (applies only if input graph is GBZ)." << endl
@@ -67,15 +76,18 @@ void help_call(char** argv) {
        << "                                from if no samples are used. Unmatched contigs get ploidy 2 (or that from -d)." << endl
        << "    -n, --nested            Activate nested calling mode (experimental)" << endl
        << "    -I, --chains            Call chains instead of snarls (experimental)" << endl
+       << "        --window N          Call top-level snarls in windows of N, sorted along the reference paths, and" << endl
+       << "                            write out each window's VCF as soon as it is done (bounds memory)" << endl
+       << "        --bgzip-out FILE    Write the VCF to FILE with BGZF compression and tabix-index it (implies --window " << default_window_size << ")" << endl
        << "        --progress          Show progress" << endl
        << "    -t, --threads N         number of threads to use" << endl;
 }    
 
 int main_call(int argc, char** argv) {
 
-    string pack_filename;
+    vector<string> pack_filenames;
     string vcf_filename;
-    string sample_name = "SAMPLE";
+    vector<string> sample_names;
     string snarl_filename;
     string gbwt_filename;
     bool   gbz_paths = false;
@@ -110,18 +122,23 @@ int main_call(int argc, char** argv) {
     size_t min_allele_len = 0;
     size_t max_allele_len = numeric_limits<size_t>::max();
     bool show_progress = false;
+    size_t window_size = 0;
+    string bgzip_out_filename;
+    string depth_index_filename;
+    bool precompute_supports = false;
 
     // constants
     const size_t avg_trav_threshold = 50;
     const size_t avg_node_threshold = 50;
-    const size_t min_depth_bin_width = 50;
-    const size_t max_depth_bin_width = 50000000;
-    const double depth_scale_fac = 1.5;
     const size_t max_yens_traversals = traversals_only ? 100 : 50;
     // used to merge up snarls from chains when generating traversals
     const size_t max_chain_edges = 1000; 
     const size_t max_chain_trivial_travs = 5;
     const int OPT_PROGRESS = 1000;
+    const int OPT_WINDOW = 1001;
+    const int OPT_BGZIP_OUT = 1002;
+    const int OPT_DEPTH_INDEX = 1003;
+    const int OPT_PRECOMPUTE_SUPPORTS = 1004;
     int c;
     optind = 2; // force optind past command positional argument
     while (true) {
@@ -159,6 +176,10 @@ int main_call(int argc, char** argv) {
             {"chains", no_argument, 0, 'I'},            
             {"threads", required_argument, 0, 't'},
             {"progress", no_argument, 0, OPT_PROGRESS },
+            {"window", required_argument, 0, OPT_WINDOW },
+            {"bgzip-out", required_argument, 0, OPT_BGZIP_OUT },
+            {"depth-index", required_argument, 0, OPT_DEPTH_INDEX },
+            {"precompute-supports", no_argument, 0, OPT_PRECOMPUTE_SUPPORTS },
             {"help", no_argument, 0, 'h'},
             {0, 0, 0, 0}
         };
@@ -175,7 +196,7 @@ int main_call(int argc, char** argv) {
         switch (c)
         {
         case 'k':
-            pack_filename = optarg;
+            pack_filenames.push_back(optarg);
             break;
         case 'B':
             ratio_caller = true;
@@ -211,7 +232,7 @@ int main_call(int argc, char** argv) {
             ins_fasta_filename = optarg;
             break;
         case 's':
-            sample_name = optarg;
+            sample_names.push_back(optarg);
             break;
         case 'r':
             snarl_filename = optarg;
@@ -286,6 +307,18 @@ int main_call(int argc, char** argv) {
         case OPT_PROGRESS:
             show_progress = true;
             break;
+        case OPT_WINDOW:
+            window_size = parse<size_t>(optarg);
+            break;
+        case OPT_BGZIP_OUT:
+            bgzip_out_filename = optarg;
+            break;
+        case OPT_DEPTH_INDEX:
+            depth_index_filename = optarg;
+            break;
+        case OPT_PRECOMPUTE_SUPPORTS:
+            precompute_supports = true;
+            break;
         case 't':
         {
             int num_threads = parse<int>(optarg);
@@ -373,6 +406,38 @@ int main_call(int argc, char** argv) {
         cerr << "error [vg call]: -S cannot be used with -p" << endl;
         return 1;
     }
+    if (!bgzip_out_filename.empty() && gaf_output) {
+        cerr << "error [vg call]: --bgzip-out cannot be used with -G or -T" << endl;
+        return 1;
+    }
+    if (!bgzip_out_filename.empty() && window_size == 0) {
+        window_size = default_window_size;
+    }
+    if (sample_names.empty()) {
+        sample_names.push_back("SAMPLE");
+    }
+    if (pack_filenames.size() > 1) {
+        if (sample_names.size() != pack_filenames.size()) {
+            cerr << "error [vg call]: a sample name (-s) must be given for each pack file (-k)" << endl;
+            return 1;
+        }
+        if (!vcf_filename.empty() || legacy || nested || gaf_output || traversals_only) {
+            cerr << "error [vg call]: multiple pack files (-k) cannot be used with -v, -L, -n, -G or -T" << endl;
+            return 1;
+        }
+        if (!depth_index_filename.empty()) {
+            cerr << "error [vg call]: --depth-index cannot be used with multiple pack files (-k)" << endl;
+            return 1;
+        }
+        if (set<string>(sample_names.begin(), sample_names.end()).size() != sample_names.size()) {
+            cerr << "error [vg call]: sample names (-s) must be distinct" << endl;
+            return 1;
+        }
+    } else if (sample_names.size() > 1) {
+        cerr << "error [vg call]: only one sample name (-s) can be given per pack file (-k)" << endl;
+        return 1;
+    }
+    const string& sample_name = sample_names.front();
 
     // Read the graph
     unique_ptr<PathHandleGraph> path_handle_graph;
@@ -435,7 +500,7 @@ int main_call(int argc, char** argv) {
     
     // Apply overlays as necessary
     bool need_path_positions = vcf_filename.empty();
-    bool need_vectorizable = !pack_filename.empty();
+    bool need_vectorizable = !pack_filenames.empty();
     bdsg::ReferencePathOverlayHelper pp_overlay_helper;
     ReferencePathVectorizableOverlayHelper ppv_overlay_helper;
     bdsg::PathVectorizableOverlayHelper pv_overlay_helper;
@@ -638,21 +703,32 @@ int main_call(int argc, char** argv) {
         snarl_manager = unique_ptr<SnarlManager>(new SnarlManager(std::move(finder.find_snarls_parallel())));
     }
     
-    // Make a Packed Support Caller
-    unique_ptr<SnarlCaller> snarl_caller;
-    algorithms::BinnedDepthIndex depth_index;
-
-    unique_ptr<Packer> packer;
-    unique_ptr<TraversalSupportFinder> support_finder;
-    if (!pack_filename.empty()) {        
+    // Make a Packed Support Caller for each sample (the first one is the snarl_caller the graph caller is built with)
+    vector<unique_ptr<SnarlCaller>> sample_callers;
+    vector<algorithms::BinnedDepthIndex> depth_indexes(pack_filenames.size());
+    vector<unique_ptr<Packer>> packers;
+    vector<unique_ptr<TraversalSupportFinder>> support_finders;
+    for (size_t sample_i = 0; sample_i < pack_filenames.size(); ++sample_i) {
+        const string& pack_filename = pack_filenames[sample_i];
+        algorithms::BinnedDepthIndex& depth_index = depth_indexes[sample_i];
+        
         // Load our packed supports (they must have come from vg pack on graph)
-        packer = unique_ptr<Packer>(new Packer(graph));
+        packers.emplace_back(new Packer(graph));
+        unique_ptr<Packer>& packer = packers.back();
         if (show_progress) cerr << "[vg call]: Loading pack file " << pack_filename << endl;
         packer->load_from_file(pack_filename);
         if (show_progress) cerr << "[vg call]: Loaded pack file" << endl;
+        support_finders.emplace_back();
+        unique_ptr<TraversalSupportFinder>& support_finder = support_finders.back();
         if (nested) {
             // Make a nested packed traversal support finder (using cached veresion important for poisson caller)
             support_finder.reset(new NestedCachedPackedTraversalSupportFinder(*packer, *snarl_manager));
+        } else if (precompute_supports) {
+            // Make a packed traversal support finder, with all the node, edge and child snarl
+            // supports worked out up front (fast lookups important for poisson caller)
+            if (show_progress) cerr << "[vg call]: Precomputing supports" << endl;
+            support_finder.reset(new PrecomputedPackedTraversalSupportFinder(*packer, *snarl_manager));
+            if (show_progress) cerr << "[vg call]: Precomputed supports" << endl;
         } else {
             // Make a packed traversal support finder (using cached veresion important for poisson caller)
             support_finder.reset(new CachedPackedTraversalSupportFinder(*packer, *snarl_manager));
@@ -670,11 +746,29 @@ int main_call(int argc, char** argv) {
         SupportBasedSnarlCaller* packed_caller = nullptr;
 
         if (ratio_caller == false) {
-            // Make a depth index
-            if (show_progress) cerr << "[vg call]: Computing coverage statistics" << endl;
-            depth_index = algorithms::binned_packed_depth_index(*packer, ref_paths, min_depth_bin_width, max_depth_bin_width,
-                                                                depth_scale_fac, 0, true, true);
-            if (show_progress) cerr << "[vg call]: Computed coverage statistics" << endl;
+            // Make a depth index (or load the one we were given)
+            if (!depth_index_filename.empty()) {
+                if (show_progress) cerr << "[vg call]: Loading depth index " << depth_index_filename << endl;
+                get_input_file(depth_index_filename, [&](istream& depth_stream) {
+                        depth_index = algorithms::load_depth_index(depth_stream);
+                    });
+                for (const string& ref_path : ref_paths) {
+                    if (!depth_index.count(ref_path)) {
+                        cerr << "error [vg call]: Reference path \"" << ref_path << "\" not found in depth index "
+                             << depth_index_filename << endl;
+                        return 1;
+                    }
+                }
+                if (show_progress) cerr << "[vg call]: Loaded depth index" << endl;
+            } else {
+                if (show_progress) cerr << "[vg call]: Computing coverage statistics" << endl;
+                depth_index = algorithms::binned_packed_depth_index(*packer, ref_paths,
+                                                                    algorithms::DEFAULT_MIN_DEPTH_BIN_SIZE,
+                                                                    algorithms::DEFAULT_MAX_DEPTH_BIN_SIZE,
+                                                                    algorithms::DEFAULT_DEPTH_BIN_GROWTH_FACTOR,
+                                                                    0, true, true);
+                if (show_progress) cerr << "[vg call]: Computed coverage statistics" << endl;
+            }
             // Make a new-stype probablistic caller
             auto poisson_caller = new PoissonSupportSnarlCaller(*graph, *snarl_manager, *support_finder, depth_index,
                                                                 //todo: qualities need to be used better in conjunction with
@@ -698,13 +792,15 @@ int main_call(int argc, char** argv) {
             packed_caller->set_min_supports(min_allele_support, min_allele_support, min_site_support);
         }
         
-        snarl_caller = unique_ptr<SnarlCaller>(packed_caller);
+        sample_callers.emplace_back(packed_caller);
     }
+    SnarlCaller* snarl_caller_ptr = sample_callers.empty() ? nullptr : sample_callers.front().get();
 
-    if (!snarl_caller) {
+    if (snarl_caller_ptr == nullptr) {
         cerr << "error [vg call]: pack file (-k) is required" << endl;
         return 1;
     }
+    SnarlCaller& snarl_caller = *snarl_caller_ptr;
 
     unique_ptr<AlignmentEmitter> alignment_emitter;
     if (gaf_output) {
@@ -737,7 +833,7 @@ int main_call(int argc, char** argv) {
             ins_fasta->open(ins_fasta_filename);
         }
         
-        VCFGenotyper* vcf_genotyper = new VCFGenotyper(*graph, *snarl_caller,
+        VCFGenotyper* vcf_genotyper = new VCFGenotyper(*graph, snarl_caller,
                                                        *snarl_manager, variant_file,
                                                        sample_name, ref_paths, ref_path_ploidies,
                                                        ref_fasta.get(),
@@ -750,7 +846,7 @@ int main_call(int argc, char** argv) {
     } else if (legacy) {
         // de-novo caller (port of the old vg call code, which requires a support based caller)
         LegacyCaller* legacy_caller = new LegacyCaller(*dynamic_cast<PathPositionHandleGraph*>(graph),
-                                                       *dynamic_cast<SupportBasedSnarlCaller*>(snarl_caller.get()),
+                                                       dynamic_cast<SupportBasedSnarlCaller&>(snarl_caller),
                                                        *snarl_manager,
                                                        sample_name, ref_paths, ref_path_offsets, ref_path_ploidies);
         graph_caller = unique_ptr<GraphCaller>(legacy_caller);
@@ -773,12 +869,21 @@ int main_call(int argc, char** argv) {
             // Flow traversals (Yen's algorithm)
             
             // todo: do we ever want to toggle in min-support?
+            // (with several samples, the traversals are found once on their pooled support)
             function<double(handle_t)> node_support = [&] (handle_t h) {
-                return support_finder->support_val(support_finder->get_avg_node_support(graph->get_id(h)));
+                double support = 0;
+                for (auto& sample_support_finder : support_finders) {
+                    support += sample_support_finder->support_val(sample_support_finder->get_avg_node_support(graph->get_id(h)));
+                }
+                return support;
             };
             
             function<double(edge_t)> edge_support = [&] (edge_t e) {
-                return support_finder->support_val(support_finder->get_edge_support(e));
+                double support = 0;
+                for (auto& sample_support_finder : support_finders) {
+                    support += sample_support_finder->support_val(sample_support_finder->get_edge_support(e));
+                }
+                return support;
             };
 
             // create the flow traversal finder
@@ -790,7 +895,7 @@ int main_call(int argc, char** argv) {
 
         if (nested) {
             graph_caller.reset(new NestedFlowCaller(*dynamic_cast<PathPositionHandleGraph*>(graph),
-                                                    *dynamic_cast<SupportBasedSnarlCaller*>(snarl_caller.get()),
+                                                    dynamic_cast<SupportBasedSnarlCaller&>(snarl_caller),
                                                     *snarl_manager,
                                                     sample_name, *traversal_finder, ref_paths, ref_path_offsets,
                                                     ref_path_ploidies,
@@ -800,17 +905,22 @@ int main_call(int argc, char** argv) {
                                                     trav_padding,
                                                     genotype_snarls));
         } else {
-            graph_caller.reset(new FlowCaller(*dynamic_cast<PathPositionHandleGraph*>(graph),
-                                              *dynamic_cast<SupportBasedSnarlCaller*>(snarl_caller.get()),
-                                              *snarl_manager,
-                                              sample_name, *traversal_finder, ref_paths, ref_path_offsets,
-                                              ref_path_ploidies,
-                                              alignment_emitter.get(),
-                                              traversals_only,
-                                              gaf_output,
-                                              trav_padding,
-                                              genotype_snarls,
-                                              make_pair(min_allele_len, max_allele_len)));
+            FlowCaller* flow_caller = new FlowCaller(*dynamic_cast<PathPositionHandleGraph*>(graph),
+                                                     dynamic_cast<SupportBasedSnarlCaller&>(snarl_caller),
+                                                     *snarl_manager,
+                                                     sample_name, *traversal_finder, ref_paths, ref_path_offsets,
+                                                     ref_path_ploidies,
+                                                     alignment_emitter.get(),
+                                                     traversals_only,
+                                                     gaf_output,
+                                                     trav_padding,
+                                                     genotype_snarls,
+                                                     make_pair(min_allele_len, max_allele_len));
+            // the other samples are genotyped on the same traversals
+            for (size_t sample_i = 1; sample_i < sample_callers.size(); ++sample_i) {
+                flow_caller->add_sample(dynamic_cast<SupportBasedSnarlCaller&>(*sample_callers[sample_i]), sample_names[sample_i]);
+            }
+            graph_caller.reset(flow_caller);
         }
     }
 
@@ -837,6 +947,38 @@ int main_call(int argc, char** argv) {
     }
 
     graph_caller->set_show_progress(show_progress);
+
+    // VCF text goes to stdout, or through BGZF to the --bgzip-out file
+    BGZF* bgzf_out = nullptr;
+    if (!bgzip_out_filename.empty()) {
+        bgzf_out = bgzf_open(bgzip_out_filename.c_str(), "w");
+        if (bgzf_out == nullptr) {
+            cerr << "error [vg call]: unable to open " << bgzip_out_filename << " for writing" << endl;
+            return 1;
+        }
+    }
+    auto write_vcf_text = [&](const string& text) {
+        if (bgzf_out != nullptr) {
+            if (bgzf_write(bgzf_out, text.c_str(), text.length()) != (ssize_t)text.length()) {
+                cerr << "error [vg call]: failed to write to " << bgzip_out_filename << endl;
+                exit(1);
+            }
+        } else {
+            cout << text << flush;
+        }
+    };
+
+    if (!gaf_output && window_size > 0) {
+        // Stream the VCF out as each window of snarls is called, rather than all at the end
+        VCFOutputCaller* vcf_caller = dynamic_cast<VCFOutputCaller*>(graph_caller.get());
+        assert(vcf_caller != nullptr);
+        write_vcf_text(header);
+        graph_caller->set_window_size(window_size, [&](const pair<string, size_t>* next_position) {
+                stringstream window_stream;
+                vcf_caller->flush_variants(window_stream, next_position, snarl_manager.get());
+                write_vcf_text(window_stream.str());
+            });
+    }
     
     // Call the graph
     if (!call_chains) {
@@ -858,11 +1000,30 @@ int main_call(int argc, char** argv) {
         // Output VCF
         VCFOutputCaller* vcf_caller = dynamic_cast<VCFOutputCaller*>(graph_caller.get());
         assert(vcf_caller != nullptr);
-        cout << header << flush;
         if (show_progress) cerr << "[vg call]: Writing VCF Variants" << endl;
-        vcf_caller->write_variants(cout, snarl_manager.get());
+        if (window_size > 0) {
+            // Anything the windows couldn't place is left in the buffer
+            stringstream window_stream;
+            vcf_caller->flush_variants(window_stream, nullptr, snarl_manager.get());
+            write_vcf_text(window_stream.str());
+        } else {
+            cout << header << flush;
+            vcf_caller->write_variants(cout, snarl_manager.get());
+        }
         if (show_progress) cerr << "[vg call]: VCF complete" << endl;        
     }
+
+    if (bgzf_out != nullptr) {
+        if (bgzf_close(bgzf_out) != 0) {
+            cerr << "error [vg call]: failed to close " << bgzip_out_filename << endl;
+            return 1;
+        }
+        // parameters inferred from tabix main's sourcecode
+        tbx_conf_t conf = tbx_conf_vcf;
+        if (tbx_index_build(bgzip_out_filename.c_str(), 0, &conf) != 0) {
+            cerr << "warning [vg call]: could not tabix index " << bgzip_out_filename << endl;
+        }
+    }
     
     return 0;
 }
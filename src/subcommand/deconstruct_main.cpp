@@ -54,6 +54,8 @@ void help_deconstruct(char** argv){
          << "    -L, --cluster F          Cluster traversals whose (handle) Jaccard coefficient is >= F together (default: 1.0) [experimental]" << endl
          << "    -n, --nested             Write a nested VCF, including special tags. [experimental]" << endl
          << "    -R, --star-allele        Use *-alleles to denote alleles that span but do not cross the site. Only works with -n" << endl
+         << "    --window N               Deconstruct N top-level snarls at a time in reference order, writing out finished" << endl
+         << "                             variants after each batch to bound memory (default: write everything at the end)" << endl
          << "    -t, --threads N          Use N threads" << endl
          << "    -v, --verbose            Print some status messages" << endl
          << endl;
@@ -83,7 +85,9 @@ int main_deconstruct(int argc, char** argv){
     double cluster_threshold = 1.0;
     bool nested = false;
     bool star_allele = false;
-    
+    size_t window_size = 0;
+
+    const int OPT_WINDOW = 1000;
     int c;
     optind = 2; // force optind past command positional argument
     while (true) {
@@ -109,6 +113,7 @@ int main_deconstruct(int argc, char** argv){
                 {"start-allele", no_argument, 0, 'R'},
                 {"threads", required_argument, 0, 't'},
                 {"verbose", no_argument, 0, 'v'},
+                {"window", required_argument, 0, OPT_WINDOW},
                 {0, 0, 0, 0}
             };
 
@@ -183,6 +188,9 @@ int main_deconstruct(int argc, char** argv){
         case 'v':
             show_progress = true;
             break;
+        case OPT_WINDOW:
+            window_size = parse<size_t>(optarg);
+            break;
         case '?':
         case 'h':
             help_deconstruct(argv);
@@ -194,6 +202,11 @@ int main_deconstruct(int argc, char** argv){
 
     }
 
+    if (nested == true && window_size > 0) {
+        cerr << "Error [vg deconstruct]: --window cannot be used with -n" << endl;
+        return 1;
+    }
+
     if (nested == true && contig_only_ref == true) {
         cerr << "Error [vg deconstruct]: -C cannot be used with -n" << endl;
         return 1;
@@ -372,6 +385,7 @@ int main_deconstruct(int argc, char** argv){
     }
     dd.set_translation(translation.get());
     dd.set_nested(all_snarls || nested);
+    dd.set_window_size(window_size);
     dd.deconstruct(refpaths, graph, snarl_manager.get(),
                    all_snarls,
                    context_jaccard_window,
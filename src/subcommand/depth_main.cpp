@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <fstream>
 
 #include "subcommand.hpp"
 
@@ -19,6 +20,7 @@
 #include <bdsg/overlays/overlay_helper.hpp>
 #include "../utility.hpp"
 #include "../packer.hpp"
+#include "../region.hpp"
 #include "algorithms/coverage_depth.hpp"
 
 using namespace std;
@@ -27,10 +29,16 @@ using namespace vg::subcommand;
 
 void help_depth(char** argv) {
     cerr << "usage: " << argv[0] << " depth [options] <graph>" << endl
+         << "   or: " << argv[0] << " depth [options] -i FILE -r REGION" << endl
          << "options:" << endl
          << "  packed coverage depth (print 1-based positional depths along path):" << endl
          << "    -k, --pack FILE        supports created from vg pack for given input graph" << endl
          << "    -d, --count-dels       count deletion edges within the bin as covering reference positions" << endl
+         << "    -o, --index-out FILE   instead of printing depths, save an index of binned depths (mean and standard error)" << endl
+         << "                           at several bin sizes, as used by vg call, to FILE (not with -b, -m or -d)" << endl
+         << "  depth index queries (print path, 1-based start, end, mean and standard error for each region):" << endl
+         << "    -i, --index-in FILE    query the depth index (from -o) in FILE, without needing the graph or pack" << endl
+         << "    -r, --region PATH:S-E  region (1-based, inclusive) to query (multiple allowed)" << endl
          << "  GAM/GAF coverage depth (print <mean> <stddev> for depth):" << endl
          << "    -g, --gam FILE         read alignments from this GAM file (could be '-' for stdin)" << endl
          << "    -a, --gaf FILE         read alignments from this GAF file (could be '-' for stdin)" << endl
@@ -70,6 +78,10 @@ int main_depth(int argc, char** argv) {
 
     size_t min_coverage = 1;
 
+    string index_out_filename;
+    string index_in_filename;
+    vector<string> regions;
+
     int c;
     optind = 2; // force optind past command positional argument
     while (true) {
@@ -87,13 +99,16 @@ int main_depth(int argc, char** argv) {
             {"min-mapq", required_argument, 0, 'Q'},
             {"min-coverage", required_argument, 0, 'm'},
             {"count-cycles", no_argument, 0, 'c'},
+            {"index-out", required_argument, 0, 'o'},
+            {"index-in", required_argument, 0, 'i'},
+            {"region", required_argument, 0, 'r'},
             {"threads", required_argument, 0, 't'},
             {"help", no_argument, 0, 'h'},
             {0, 0, 0, 0}
         };
 
         int option_index = 0;
-        c = getopt_long (argc, argv, "hk:p:P:b:dg:a:n:s:m:ct:",
+        c = getopt_long (argc, argv, "hk:p:P:b:dg:a:n:s:m:co:i:r:t:",
                 long_options, &option_index);
 
         // Detect the end of the options.
@@ -138,6 +153,15 @@ int main_depth(int argc, char** argv) {
         case 'c':
             count_cycles = true;
             break;
+        case 'o':
+            index_out_filename = optarg;
+            break;
+        case 'i':
+            index_in_filename = optarg;
+            break;
+        case 'r':
+            regions.push_back(optarg);
+            break;
         case 't':
         {
             int num_threads = parse<int>(optarg);
@@ -164,6 +188,44 @@ int main_depth(int argc, char** argv) {
         return 1;
     }
 
+    if (!index_in_filename.empty()) {
+        // Query the depth index, which doesn't need the graph or the pack
+        if (regions.empty()) {
+            cerr << "error:[vg depth] At least one region (-r) must be given to query the depth index (-i)" << endl;
+            exit(1);
+        }
+        algorithms::BinnedDepthIndex depth_index;
+        get_input_file(index_in_filename, [&](istream& index_stream) {
+                depth_index = algorithms::load_depth_index(index_stream);
+            });
+        for (const string& region : regions) {
+            string path_name;
+            int64_t start, end;
+            parse_region(region, path_name, start, end);
+            if (!depth_index.count(path_name)) {
+                cerr << "error:[vg depth] Path \"" << path_name << "\" not found in depth index" << endl;
+                exit(1);
+            }
+            if (start < 1 || end < start) {
+                cerr << "error:[vg depth] Region \"" << region << "\" must be of the form PATH:START-END" << endl;
+                exit(1);
+            }
+            pair<float, float> depth = algorithms::get_depth_from_index(depth_index, path_name, start - 1, end - 1);
+            cout << path_name << "\t" << start << "\t" << end << "\t" << depth.first << "\t" << depth.second << endl;
+        }
+        return 0;
+    }
+
+    if (!index_out_filename.empty() && pack_filename.empty()) {
+        cerr << "error:[vg depth] A pack file (-k) is required to make a depth index (-o)" << endl;
+        exit(1);
+    }
+    if (!index_out_filename.empty() && (bin_size != 1 || min_coverage != 1 || count_dels)) {
+        // the index always uses vg call's bin sizes and settings
+        cerr << "error:[vg depth] Options -b, -m and -d cannot be used when making a depth index (-o)" << endl;
+        exit(1);
+    }
+
     size_t input_count = pack_filename.empty() ? 0 : 1;
     if (!gam_filename.empty()) ++input_count;
     if (!gaf_filename.empty()) ++input_count;
@@ -230,6 +292,27 @@ int main_depth(int argc, char** argv) {
             }
         }
 
+        if (!index_out_filename.empty()) {
+            // Save the same depth index that vg call would compute for these paths
+            vector<string> ref_path_names;
+            for (const auto& ref_coord_path : ref_paths) {
+                ref_path_names.push_back(ref_coord_path.second);
+            }
+            algorithms::BinnedDepthIndex depth_index =
+                algorithms::binned_packed_depth_index(*packer, ref_path_names,
+                                                      algorithms::DEFAULT_MIN_DEPTH_BIN_SIZE,
+                                                      algorithms::DEFAULT_MAX_DEPTH_BIN_SIZE,
+                                                      algorithms::DEFAULT_DEPTH_BIN_GROWTH_FACTOR,
+                                                      0, true, true);
+            ofstream index_stream(index_out_filename, std::ios_base::binary);
+            if (!index_stream) {
+                cerr << "error:[vg depth] Unable to open depth index file " << index_out_filename << endl;
+                exit(1);
+            }
+            algorithms::save_depth_index(depth_index, index_stream);
+            return 0;
+        }
+
         for (const auto& ref_coord_path : ref_paths) {
             const string& ref_path = ref_coord_path.second;
             const string& base_path = ref_coord_path.first.first;
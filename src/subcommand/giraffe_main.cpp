@@ -24,6 +24,8 @@
 #include <vg/io/vpkg.hpp>
 #include <vg/io/stream.hpp>
 #include "../hts_alignment_emitter.hpp"
+#include "../packing_alignment_emitter.hpp"
+#include "../packer.hpp"
 #include "../minimizer_mapper.hpp"
 #include "../index_registry.hpp"
 #include "../watchdog.hpp"
@@ -410,7 +412,9 @@ void help_giraffe(char** argv, const BaseOptionGroup& parser, bool full_help) {
     << "  -R, --read-group NAME         add this read group" << endl
     << "  -o, --output-format NAME      output the alignments in NAME format (gam / gaf / json / tsv / SAM / BAM / CRAM) [gam]" << endl
     << "  --ref-paths FILE              ordered list of paths in the graph, one per line or HTSlib .dict, for HTSLib @SQ headers" << endl
-    << "  --named-coordinates           produce GAM/GAF outputs in named-segment (GFA) space" << endl;
+    << "  --named-coordinates           produce GAM/GAF outputs in named-segment (GFA) space" << endl
+    << "  --pack-out FILE               also write the coverage of the alignments to FILE (like vg pack -o; use with -n to skip the alignments)" << endl
+    << "  --pack-min-mapq INT           ignore alignments with MAPQ below INT and bases with quality below INT in --pack-out [0]" << endl;
     if (full_help) {
         cerr
         << "  -P, --prune-low-cplx          prune short and low complexity anchors during linear format realignment" << endl
@@ -461,6 +465,8 @@ int main_giraffe(int argc, char** argv) {
     #define OPT_REF_PATHS 1010
     #define OPT_SHOW_WORK 1011
     #define OPT_NAMED_COORDINATES 1012
+    #define OPT_PACK_OUT 1013
+    #define OPT_PACK_MIN_MAPQ 1014
     constexpr int OPT_HAPLOTYPE_NAME = 1100;
     constexpr int OPT_KFF_NAME = 1101;
     constexpr int OPT_INDEX_BASENAME = 1102;
@@ -542,6 +548,10 @@ int main_giraffe(int argc, char** argv) {
     // For GAM format, should we report in named-segment space instead of node ID space?
     bool named_coordinates = false;
 
+    // Should we also record the coverage of the alignments in a pack file, and with what filter?
+    std::string pack_out_name;
+    int pack_min_mapq = 0;
+
     // Map algorithm names to rescue algorithms
     std::map<std::string, MinimizerMapper::RescueAlgorithm> rescue_algorithms = {
         { "none", MinimizerMapper::rescue_none },
@@ -599,6 +609,8 @@ int main_giraffe(int argc, char** argv) {
         {"ref-paths", required_argument, 0, OPT_REF_PATHS},
         {"prune-low-cplx", no_argument, 0, 'P'},
         {"named-coordinates", no_argument, 0, OPT_NAMED_COORDINATES},
+        {"pack-out", required_argument, 0, OPT_PACK_OUT},
+        {"pack-min-mapq", required_argument, 0, OPT_PACK_MIN_MAPQ},
         {"discard", no_argument, 0, 'n'},
         {"output-basename", required_argument, 0, OPT_OUTPUT_BASENAME},
         {"report-name", required_argument, 0, OPT_REPORT_NAME},
@@ -808,6 +820,14 @@ int main_giraffe(int argc, char** argv) {
                 named_coordinates = true;
                 break;
 
+            case OPT_PACK_OUT:
+                pack_out_name = optarg;
+                break;
+
+            case OPT_PACK_MIN_MAPQ:
+                pack_min_mapq = parse<int>(optarg);
+                break;
+
             case 'n':
                 discard_alignments = true;
                 break;
@@ -1301,6 +1321,16 @@ int main_giraffe(int argc, char** argv) {
         // If we see any, we will issue a warning.
         unique_ptr<Watchdog> watchdog(new Watchdog(thread_count, chrono::seconds(main_options.watchdog_timeout)));
 
+        // If we are writing coverage, count it in node ID space over the GBZ graph,
+        // so the pack matches what vg pack would make from GAM output on the GBZ.
+        bdsg::VectorizableOverlayHelper pack_overlay_helper;
+        unique_ptr<Packer> packer;
+        if (!pack_out_name.empty()) {
+            const HandleGraph* pack_graph = dynamic_cast<const HandleGraph*>(pack_overlay_helper.apply(&gbz->graph));
+            packer = make_unique<Packer>(pack_graph, true, true, false, true, 0,
+                                         Packer::estimate_bin_count(thread_count), Packer::estimate_data_width(128), true);
+        }
+
         {
         
             // Look up all the paths we might need to surject to.
@@ -1337,6 +1367,11 @@ int main_giraffe(int argc, char** argv) {
                                                           paths, thread_count,
                                                           emitter_graph, flags);
             }
+            if (packer) {
+                // Count coverage on the way to the real emitter, before any translation or surjection.
+                alignment_emitter = make_unique<PackingAlignmentEmitter>(packer.get(), std::move(alignment_emitter),
+                                                                         pack_min_mapq, pack_min_mapq);
+            }
             
 #ifdef USE_CALLGRIND
             // We want to profile the alignment, not the loading.
@@ -1540,6 +1575,13 @@ int main_giraffe(int argc, char** argv) {
             }
         
         } // Make sure alignment emitter is destroyed and all alignments are on disk.
+
+        if (packer) {
+            if (show_progress) {
+                cerr << "Writing coverage to " << pack_out_name << endl;
+            }
+            packer->save_to_file(pack_out_name);
+        }
         
         // Now mapping is done
         std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now();
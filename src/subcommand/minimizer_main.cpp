@@ -84,10 +84,15 @@ void help_minimizer(char** argv) {
     std::cerr << "Other options:" << std::endl;
     std::cerr << "    -l, --load-index X      load the index from file X and insert the new kmers into it" << std::endl;
     std::cerr << "                            (overrides minimizer / weighted minimizer options)" << std::endl;
+    std::cerr << "        --new-haplotypes X  with --load-index, only index the haplotypes in GBWT file X" << std::endl;
+    std::cerr << "                            (for adding haplotypes to an unchanged graph; the graph only" << std::endl;
+    std::cerr << "                            provides the sequences and the distance index is reused)" << std::endl;
     std::cerr << "    -g, --gbwt-name X       use the GBWT index in file X (required with a non-GBZ graph)" << std::endl;
     std::cerr << "    -p, --progress          show progress information" << std::endl;
     std::cerr << "    -t, --threads N         use N threads for index construction (default " << get_default_threads() << ")" << std::endl;
     std::cerr << "                            (using more than " << DEFAULT_MAX_THREADS << " threads rarely helps)" << std::endl;
+    std::cerr << "        --shards N          collect the hits into N shards without a global lock and insert" << std::endl;
+    std::cerr << "                            them at the end (scales to more threads; uses more memory)" << std::endl;
     std::cerr << "        --no-dist           build the index without distance index annotations (not recommended)" << std::endl;
     std::cerr << std::endl;
 }
@@ -100,19 +105,22 @@ int main_minimizer(int argc, char** argv) {
     }
 
     // Command-line options.
-    std::string output_name, distance_name, load_index, gbwt_name, graph_name;
+    std::string output_name, distance_name, load_index, gbwt_name, graph_name, new_haplotypes_name;
     bool use_syncmers = false;
     bool weighted = false, space_efficient_counting = false;
     size_t threshold = DEFAULT_THRESHOLD, iterations = DEFAULT_ITERATIONS, hash_table_size = 0;
     bool progress = false;
     int threads = get_default_threads();
     bool require_distance_index = true;
+    size_t shards = 0;
 
     constexpr int OPT_THRESHOLD = 1001;
     constexpr int OPT_ITERATIONS = 1002;
     constexpr int OPT_FAST_COUNTING = 1003;
     constexpr int OPT_SAVE_MEMORY = 1004;
     constexpr int OPT_HASH_TABLE = 1005;
+    constexpr int OPT_NEW_HAPLOTYPES = 1006;
+    constexpr int OPT_SHARDS = 1007;
     constexpr int OPT_NO_DIST = 1100;
 
     int c;
@@ -136,9 +144,11 @@ int main_minimizer(int argc, char** argv) {
             { "save-memory", no_argument, 0, OPT_SAVE_MEMORY },
             { "hash-table", required_argument, 0, OPT_HASH_TABLE },
             { "load-index", required_argument, 0, 'l' },
+            { "new-haplotypes", required_argument, 0, OPT_NEW_HAPLOTYPES },
             { "gbwt-graph", no_argument, 0, 'G' }, // deprecated
             { "progress", no_argument, 0, 'p' },
             { "threads", required_argument, 0, 't' },
+            { "shards", required_argument, 0, OPT_SHARDS },
             { "no-dist", no_argument, 0, OPT_NO_DIST },
             { 0, 0, 0, 0 }
         };
@@ -209,6 +219,9 @@ int main_minimizer(int argc, char** argv) {
         case 'l':
             load_index = optarg;
             break;
+        case OPT_NEW_HAPLOTYPES:
+            new_haplotypes_name = optarg;
+            break;
         case 'G':
             std::cerr << "[vg minimizer] warning: --gbwt-graph is deprecated, graph format is now autodetected" << std::endl;
             break;
@@ -220,6 +233,9 @@ int main_minimizer(int argc, char** argv) {
             threads = std::min(threads, omp_get_max_threads());
             threads = std::max(threads, 1);
             break;
+        case OPT_SHARDS:
+            shards = parse<size_t>(optarg);
+            break;
         case OPT_NO_DIST:
             require_distance_index = false;
             break;
@@ -245,6 +261,10 @@ int main_minimizer(int argc, char** argv) {
         std::cerr << "[vg minimizer] error: one of options --distance-index and --no-dist is required" << std::endl;
         return 1;
     }
+    if (!new_haplotypes_name.empty() && load_index.empty()) {
+        std::cerr << "[vg minimizer] error: option --new-haplotypes requires --load-index" << std::endl;
+        return 1;
+    }
     if (!load_index.empty() || use_syncmers) {
         weighted = false;
     }
@@ -346,9 +366,27 @@ int main_minimizer(int argc, char** argv) {
         distance_index->preload(true);
     }
 
+    // When adding haplotypes to an existing index, we only visit the windows of the
+    // new haplotypes. The graph topology is unchanged, so the node ids and the
+    // distance index annotations of the new hits agree with the existing ones,
+    // and windows shared with old haplotypes only yield hits the index already has.
+    std::unique_ptr<gbwt::GBWT> new_haplotypes;
+    std::unique_ptr<gbwtgraph::GBWTGraph> new_haplotype_graph;
+    if (!new_haplotypes_name.empty()) {
+        if (progress) {
+            std::cerr << "Loading new haplotypes from " << new_haplotypes_name << std::endl;
+        }
+        new_haplotypes = vg::io::VPKG::load_one<gbwt::GBWT>(new_haplotypes_name);
+        if (progress) {
+            std::cerr << "Building GBWTGraph for " << new_haplotypes->sequences() / 2 << " new haplotype paths" << std::endl;
+        }
+        new_haplotype_graph = std::make_unique<gbwtgraph::GBWTGraph>(*new_haplotypes, gbz->graph);
+    }
+    const gbwtgraph::GBWTGraph& haplotype_graph = (new_haplotype_graph ? *new_haplotype_graph : gbz->graph);
+
     // Build the index.
     if (progress) {
-        std::cerr << "Building MinimizerIndex with k = " << index->k();
+        std::cerr << (new_haplotype_graph ? "Updating" : "Building") << " MinimizerIndex with k = " << index->k();
         if (index->uses_syncmers()) {
             std::cerr << ", s = " << index->s();
         } else {
@@ -356,12 +394,25 @@ int main_minimizer(int argc, char** argv) {
         }
         std::cerr << std::endl;
     }
-    if (distance_name.empty()) {
-        gbwtgraph::index_haplotypes(gbz->graph, *index, [](const pos_t&) -> gbwtgraph::Payload {
+    if (shards > 0) {
+        if (progress) {
+            std::cerr << "Collecting the hits into " << shards << " shards" << std::endl;
+        }
+        if (distance_name.empty()) {
+            index_haplotypes_sharded(haplotype_graph, *index, [](nid_t) -> gbwtgraph::Payload {
+                return MIPayload::NO_CODE;
+            }, shards);
+        } else {
+            index_haplotypes_sharded(haplotype_graph, *index, [&](nid_t node_id) -> gbwtgraph::Payload {
+                return MIPayload::encode(get_minimizer_distances(*distance_index, make_pos_t(node_id, false, 0)));
+            }, shards);
+        }
+    } else if (distance_name.empty()) {
+        gbwtgraph::index_haplotypes(haplotype_graph, *index, [](const pos_t&) -> gbwtgraph::Payload {
             return MIPayload::NO_CODE;
         });
     } else {
-        gbwtgraph::index_haplotypes(gbz->graph, *index, [&](const pos_t& pos) -> gbwtgraph::Payload {
+        gbwtgraph::index_haplotypes(haplotype_graph, *index, [&](const pos_t& pos) -> gbwtgraph::Payload {
             return MIPayload::encode(get_minimizer_distances(*distance_index,pos));
         });
     }
@@ -149,6 +149,9 @@ void help_mpmap(char** argv) {
     //<< "  -K, --clust-length INT       minimum MEM length used in clustering [automatic]" << endl
     //<< "  -F, --stripped-match         use stripped match algorithm instead of MEMs" << endl
     << "  -c, --hit-max INT         use at most this many hits for any match seeds (0 for no limit) [1024 DNA / 100 RNA]" << endl
+    << "  --sparse-accel-kmers INT  also memoize up to this many of the most frequent longer k-mers to speed up seeding, at" << endl
+    << "                            a startup cost of up to 4*INT GCSA queries per base of extra length (0 to disable) [0]" << endl
+    << "  --sparse-accel-length INT length of the k-mers memoized with --sparse-accel-kmers (at most 32) [20]" << endl
     //<< "  --approx-exp FLOAT           let the approximate likelihood miscalculate likelihood ratios by this power [10.0 DNA / 5.0 RNA]" << endl
     //<< "  --recombination-penalty FLOAT use this log recombination penalty for GBWT haplotype scoring [20.7]" << endl
     //<< "  --always-check-population    always try to population-score reads, even if there is only a single mapping" << endl
@@ -216,6 +219,9 @@ int main_mpmap(int argc, char** argv) {
     #define OPT_RESEED_LENGTH 1035
     #define OPT_MAX_MOTIF_PAIRS 1036
     #define OPT_SUPPRESS_MISMAPPING_DETECTION 1037
+    #define OPT_NO_EDIT_DISTANCE_PREFILTER 1038
+    #define OPT_SPARSE_ACCEL_LENGTH 1040
+    #define OPT_SPARSE_ACCEL_KMERS 1041
     string matrix_file_name;
     string graph_name;
     string gcsa_name;
@@ -315,6 +321,7 @@ int main_mpmap(int argc, char** argv) {
     double frag_length_stddev = NAN;
     bool same_strand = false;
     bool suppress_mismapping_detection = false;
+    bool use_edit_distance_prefilter = true;
     bool auto_calibrate_mismapping_detection = true;
     double max_mapping_p_value = 0.0001;
     double max_rescue_p_value = 0.03;
@@ -365,6 +372,8 @@ int main_mpmap(int argc, char** argv) {
     int reversing_walk_length = 1;
     int min_splice_length = 20;
     int mem_accelerator_length = 12;
+    int sparse_accelerator_length = 20;
+    int64_t sparse_accelerator_kmers = 0;
     bool no_output = false;
     string out_format = "GAMP";
 
@@ -418,6 +427,7 @@ int main_mpmap(int argc, char** argv) {
             {"report-group-mapq", no_argument, 0, 'U'},
             {"report-allelic-mapq", no_argument, 0, OPT_REPORT_ALLELIC_MAPQ},
             {"suppress-mismapping", no_argument, 0, OPT_SUPPRESS_MISMAPPING_DETECTION},
+            {"no-ed-prefilter", no_argument, 0, OPT_NO_EDIT_DISTANCE_PREFILTER},
             {"padding-mult", required_argument, 0, OPT_BAND_PADDING_MULTIPLIER},
             {"map-attempts", required_argument, 0, 'u'},
             {"max-paths", required_argument, 0, OPT_MAX_PATHS},
@@ -452,6 +462,8 @@ int main_mpmap(int argc, char** argv) {
             {"splice-odds", required_argument, 0, OPT_SPLICE_ODDS},
             {"intron-distr", required_argument, 0, 'r'},
             {"max-motif-pairs", required_argument, 0, OPT_MAX_MOTIF_PAIRS},
+            {"sparse-accel-length", required_argument, 0, OPT_SPARSE_ACCEL_LENGTH},
+            {"sparse-accel-kmers", required_argument, 0, OPT_SPARSE_ACCEL_KMERS},
             {"read-length", required_argument, 0, 'l'},
             {"nt-type", required_argument, 0, 'n'},
             {"error-rate", required_argument, 0, 'e'},
@@ -619,6 +631,10 @@ int main_mpmap(int argc, char** argv) {
                 suppress_mismapping_detection = true;
                 break;
                 
+            case OPT_NO_EDIT_DISTANCE_PREFILTER:
+                use_edit_distance_prefilter = false;
+                break;
+                
             case 'v':
                 use_tvs_clusterer = true;
                 use_min_dist_clusterer = false;
@@ -817,6 +833,14 @@ int main_mpmap(int argc, char** argv) {
                 max_motif_pairs = parse<int>(optarg);
                 break;
                 
+            case OPT_SPARSE_ACCEL_LENGTH:
+                sparse_accelerator_length = parse<int>(optarg);
+                break;
+                
+            case OPT_SPARSE_ACCEL_KMERS:
+                sparse_accelerator_kmers = parse<int64_t>(optarg);
+                break;
+                
             case 'r':
                 intron_distr_name = optarg;
                 break;
@@ -1431,6 +1455,16 @@ int main_mpmap(int argc, char** argv) {
         exit(1);
     }
     
+    if (sparse_accelerator_length < 0 || sparse_accelerator_length > 32) {
+        cerr << "error:[vg mpmap] Sparse MEM accelerator length (--sparse-accel-length) set to " << sparse_accelerator_length << ", must set to a number between 0 and 32." << endl;
+        exit(1);
+    }
+    
+    if (sparse_accelerator_kmers < 0) {
+        cerr << "error:[vg mpmap] Sparse MEM accelerator size (--sparse-accel-kmers) set to " << sparse_accelerator_kmers << ", must set to a non-negative number." << endl;
+        exit(1);
+    }
+    
     if ((match_score_arg != std::numeric_limits<int>::min() || mismatch_score_arg != std::numeric_limits<int>::min()) && !matrix_file_name.empty())  {
         cerr << "error:[vg mpmap] Cannot choose custom scoring matrix (-w) and custom match/mismatch score (-q/-z) simultaneously." << endl;
         exit(1);
@@ -1788,14 +1822,16 @@ int main_mpmap(int argc, char** argv) {
             // take back the increment and don't let it go multithreaded
             --threads_active;
             log_progress("Memoizing GCSA2 queries");
-            mem_accelerator = unique_ptr<MEMAccelerator>(new MEMAccelerator(*gcsa_index, mem_accelerator_length));
+            mem_accelerator = unique_ptr<MEMAccelerator>(new MEMAccelerator(*gcsa_index, mem_accelerator_length,
+                                                                            sparse_accelerator_length, sparse_accelerator_kmers));
             log_progress("Completed memoizing GCSA2 queries");
         }
         else {
             // do the process in a background thread
             background_processes.emplace_back([&]() {
                 log_progress("Memoizing GCSA2 queries (in background)");
-                mem_accelerator = unique_ptr<MEMAccelerator>(new MEMAccelerator(*gcsa_index, mem_accelerator_length));
+                mem_accelerator = unique_ptr<MEMAccelerator>(new MEMAccelerator(*gcsa_index, mem_accelerator_length,
+                                                                                sparse_accelerator_length, sparse_accelerator_kmers));
                 --threads_active;
                 log_progress("Completed memoizing GCSA2 queries");
             });
@@ -1937,6 +1973,7 @@ int main_mpmap(int argc, char** argv) {
     multipath_mapper.max_mapping_p_value = max_mapping_p_value;
     multipath_mapper.max_rescue_p_value = max_rescue_p_value;
     multipath_mapper.suppress_mismapping_detection = suppress_mismapping_detection;
+    multipath_mapper.use_edit_distance_prefilter = use_edit_distance_prefilter;
     if (min_clustering_mem_length) {
         multipath_mapper.min_clustering_mem_length = min_clustering_mem_length;
     }
@@ -2437,6 +2474,9 @@ int main_mpmap(int argc, char** argv) {
             num_reads_mapped += uncounted_mappings;
         }
         log_progress("Mapping finished. Mapped " + to_string(num_reads_mapped) + " " + (fastq_name_2.empty() && !interleaved_input ? "reads" : "read pairs") + ".");
+        if (use_edit_distance_prefilter && !suppress_mismapping_detection) {
+            log_progress("Skipped " + to_string(multipath_mapper.get_num_prefiltered_clusters()) + " cluster graphs that could not yield a confident alignment.");
+        }
     }
     
 #ifdef record_read_run_times
@@ -32,6 +32,8 @@ void help_pack(char** argv) {
          << "    -Q, --min-mapq N       ignore reads with MAPQ < N and positions with base quality < N [default: 0]" << endl
          << "    -c, --expected-cov N   expected coverage.  used only for memory tuning [default : 128]" << endl
          << "    -s, --trim-ends N      ignore the first and last N bases of each read" << endl 
+         << "    -m, --mappable         write the output in a format that can be used without loading it" << endl
+         << "    -A, --atomic           count with lock-free atomic counters (faster with many threads, more memory)" << endl
          << "    -t, --threads N        use N threads (defaults to numCPUs)" << endl;
 }
 
@@ -54,6 +56,8 @@ int main_pack(int argc, char** argv) {
     int min_baseq = 0;
     size_t expected_coverage = 128;
     int trim_ends = 0;
+    bool atomic_counters = false;
+    bool mappable = false;
 
     if (argc == 2) {
         help_pack(argv);
@@ -82,11 +86,13 @@ int main_pack(int argc, char** argv) {
             {"min-mapq", required_argument, 0, 'Q'},
             {"expected-cov", required_argument, 0, 'c'},
             {"trim-ends", required_argument, 0, 's'},
+            {"atomic", no_argument, 0, 'A'},
+            {"mappable", no_argument, 0, 'm'},
             {0, 0, 0, 0}
 
         };
         int option_index = 0;
-        c = getopt_long (argc, argv, "hx:o:i:g:a:dDut:eb:n:N:Q:c:s:",
+        c = getopt_long (argc, argv, "hx:o:i:g:a:dDut:eb:n:N:Q:c:s:Am",
                 long_options, &option_index);
 
         // Detect the end of the options.
@@ -156,6 +162,12 @@ int main_pack(int argc, char** argv) {
         case 's':
             trim_ends = parse<int>(optarg);
             break;
+        case 'A':
+            atomic_counters = true;
+            break;
+        case 'm':
+            mappable = true;
+            break;
         default:
             abort();
         }
@@ -216,7 +228,7 @@ int main_pack(int argc, char** argv) {
     size_t bin_count = Packer::estimate_bin_count(num_threads);
 
     // create our packer
-    Packer packer(graph, true, true, record_edits, true, bin_size, bin_count, data_width);
+    Packer packer(graph, true, true, record_edits, true, bin_size, bin_count, data_width, atomic_counters);
     
     // todo one packer per thread and merge
     if (packs_in.size() == 1) {
@@ -250,7 +262,7 @@ int main_pack(int argc, char** argv) {
     }
 
     if (!packs_out.empty()) {
-        packer.save_to_file(packs_out);
+        packer.save_to_file(packs_out, mappable);
     }
     if (write_table || write_edge_table || write_qual_table) {
         packer.make_compact();
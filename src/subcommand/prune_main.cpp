@@ -130,6 +130,8 @@ void help_prune(char** argv) {
     std::cerr << "    -g, --gbwt-name FILE   unfold the threads from this GBWT index" << std::endl;
     std::cerr << "    -m, --mapping FILE     store the node mapping for duplicates in this file (required with -u)" << std::endl;
     std::cerr << "    -a, --append-mapping   append to the existing node mapping" << std::endl;
+    std::cerr << "    -z, --unfold-mem N     unfold components in parallel while trying to use at most" << std::endl;
+    std::cerr << "                           N GB for them (default: no limit)" << std::endl;
     std::cerr << std::endl;
     std::cerr << "Other options:" << std::endl;
     std::cerr << "    -p, --progress         show progress" << std::endl;
@@ -154,6 +156,7 @@ int main_prune(int argc, char** argv) {
     int threads = omp_get_max_threads();
     bool verify_paths = false, append_mapping = false, show_progress = false, dry_run = false;
     std::string vg_name, gbwt_name, mapping_name;
+    int64_t unfold_memory = std::numeric_limits<int64_t>::max();
 
     // Derived variables.
     bool kmer_length_set = false, edge_max_set = false, subgraph_min_set = false, max_degree_set = false;
@@ -175,6 +178,7 @@ int main_prune(int argc, char** argv) {
             { "gbwt-name", required_argument, 0, 'g' },
             { "mapping", required_argument, 0, 'm' },
             { "append-mapping", no_argument, 0, 'a' },
+            { "unfold-mem", required_argument, 0, 'z' },
             { "progress", no_argument, 0, 'p' },
             { "threads", required_argument, 0, 't' },
             { "dry-run", no_argument, 0, 'd' },
@@ -183,7 +187,7 @@ int main_prune(int argc, char** argv) {
         };
 
         int option_index = 0;
-        c = getopt_long(argc, argv, "k:e:s:M:Pruvx:g:m:apt:dh", long_options, &option_index);
+        c = getopt_long(argc, argv, "k:e:s:M:Pruvx:g:m:az:pt:dh", long_options, &option_index);
         if (c == -1) { break; } // End of options.
 
         switch (c)
@@ -228,6 +232,13 @@ int main_prune(int argc, char** argv) {
         case 'a':
             append_mapping = true;
             break;
+        case 'z':
+            unfold_memory = parse<double>(optarg) * 1024 * 1024 * 1024;
+            if (unfold_memory <= 0) {
+                std::cerr << "error: [vg prune] --unfold-mem must be positive" << std::endl;
+                return 1;
+            }
+            break;
         case 'p':
             show_progress = true;
             break;
@@ -425,7 +436,7 @@ int main_prune(int argc, char** argv) {
         if (append_mapping) {
             unfolder.read_mapping(mapping_name);
         }
-        unfolder.unfold(*graph, show_progress);
+        unfolder.unfold(*graph, show_progress, unfold_memory);
         if (!mapping_name.empty()) {
             unfolder.write_mapping(mapping_name);
         }
@@ -523,6 +523,125 @@ size_t PackedTraversalSupportFinder::get_avg_node_mapq(id_t node) const {
 }
 
 
+PrecomputedPackedTraversalSupportFinder::PrecomputedPackedTraversalSupportFinder(const Packer& packer, SnarlManager& snarl_manager) :
+    PackedTraversalSupportFinder(packer, snarl_manager),
+    vectorizable_graph(dynamic_cast<const VectorizableHandleGraph*>(packer.get_graph())) {
+    assert(vectorizable_graph != nullptr);
+
+    // scan each node's coverage once, getting both its min and average
+    // (edge coverage and qualities are optional in the pack, so we leave those arrays empty if missing)
+    bool have_mapqs = packer.node_quality_vector_size() > 0;
+    min_node_supports.resize(graph.get_node_count() + 1);
+    avg_node_supports.resize(graph.get_node_count() + 1);
+    avg_node_mapqs.resize(have_mapqs ? graph.get_node_count() + 1 : 0);
+    graph.for_each_handle([&](const handle_t& handle) {
+            id_t node_id = graph.get_id(handle);
+            size_t rank = vectorizable_graph->id_to_rank(node_id);
+            Position pos;
+            pos.set_node_id(node_id);
+            size_t offset = packer.position_in_basis(pos);
+            size_t length = graph.get_length(handle);
+            size_t min_coverage = packer.coverage_at_position(offset);
+            size_t total_coverage = 0;
+            for (size_t i = 0; i < length; ++i) {
+                size_t coverage = packer.coverage_at_position(offset + i);
+                min_coverage = min(min_coverage, coverage);
+                total_coverage += coverage;
+            }
+            min_node_supports[rank] = min_coverage;
+            avg_node_supports[rank] = (double)total_coverage / (double)length;
+            if (have_mapqs) {
+                avg_node_mapqs[rank] = packer.average_node_quality(packer.node_index(node_id));
+            }
+        }, true);
+
+    if (packer.edge_vector_size() > 0) {
+        edge_supports.resize(packer.edge_vector_size() + 1);
+        graph.for_each_edge([&](const edge_t& edge) {
+                edge_supports[vectorizable_graph->edge_index(edge)] = PackedTraversalSupportFinder::get_edge_support(edge).forward();
+            }, true);
+    }
+
+    // then fill in the child supports bottom-up, one snarl tree per thread
+    child_supports.resize(snarl_manager.num_snarls());
+    snarl_manager.for_each_top_level_snarl_parallel([&](const Snarl* snarl) {
+            summarize_snarl(snarl);
+        });
+}
+
+PrecomputedPackedTraversalSupportFinder::~PrecomputedPackedTraversalSupportFinder() {
+}
+
+void PrecomputedPackedTraversalSupportFinder::summarize_snarl(const Snarl* snarl) {
+    const vector<const Snarl*>& children = snarl_manager.children_of(snarl);
+    for (const Snarl* child : children) {
+        summarize_snarl(child);
+    }
+
+    // the deep contents are the shallow contents (which include the children's boundaries)
+    // plus the deep contents of each child inside its boundaries
+    pair<unordered_set<id_t>, unordered_set<edge_t>> contents = snarl_manager.shallow_contents(snarl, graph, true);
+    double max_support = 0;
+    size_t length = 0;
+    for (id_t node_id : contents.first) {
+        max_support = max(max_support, avg_node_supports[vectorizable_graph->id_to_rank(node_id)]);
+        length += graph.get_length(graph.get_handle(node_id));
+    }
+    for (const Snarl* child : children) {
+        const pair<double, size_t>& child_support = child_supports[snarl_manager.snarl_number(child)];
+        max_support = max(max_support, child_support.first);
+        length += child_support.second - graph.get_length(graph.get_handle(child->start().node_id()));
+        if (child->end().node_id() != child->start().node_id()) {
+            length -= graph.get_length(graph.get_handle(child->end().node_id()));
+        }
+    }
+    child_supports[snarl_manager.snarl_number(snarl)] = make_pair(max_support, length);
+}
+
+Support PrecomputedPackedTraversalSupportFinder::get_edge_support(id_t from, bool from_reverse,
+                                                                  id_t to, bool to_reverse) const {
+    edge_t edge = graph.edge_handle(graph.get_handle(from, from_reverse), graph.get_handle(to, to_reverse));
+    if (edge_supports.empty() || !graph.has_edge(edge)) {
+        return PackedTraversalSupportFinder::get_edge_support(from, from_reverse, to, to_reverse);
+    }
+    Support support;
+    support.set_forward(edge_supports[vectorizable_graph->edge_index(edge)]);
+    return support;
+}
+
+Support PrecomputedPackedTraversalSupportFinder::get_min_node_support(id_t node) const {
+    Support support;
+    support.set_forward(min_node_supports[vectorizable_graph->id_to_rank(node)]);
+    return support;
+}
+
+Support PrecomputedPackedTraversalSupportFinder::get_avg_node_support(id_t node) const {
+    Support support;
+    support.set_forward(avg_node_supports[vectorizable_graph->id_to_rank(node)]);
+    return support;
+}
+
+size_t PrecomputedPackedTraversalSupportFinder::get_avg_node_mapq(id_t node) const {
+    if (avg_node_mapqs.empty()) {
+        return PackedTraversalSupportFinder::get_avg_node_mapq(node);
+    }
+    return avg_node_mapqs[vectorizable_graph->id_to_rank(node)];
+}
+
+tuple<Support, Support, int> PrecomputedPackedTraversalSupportFinder::get_child_support(const Snarl& snarl) const {
+    // the snarl usually comes from a visit, so find the managed copy (in either orientation)
+    const Snarl* managed = snarl_manager.into_which_snarl(snarl.start());
+    if (managed == nullptr ||
+        !((managed->start().node_id() == snarl.start().node_id() && managed->end().node_id() == snarl.end().node_id()) ||
+          (managed->start().node_id() == snarl.end().node_id() && managed->end().node_id() == snarl.start().node_id()))) {
+        return TraversalSupportFinder::get_child_support(snarl);
+    }
+    const pair<double, size_t>& child_support = child_supports[snarl_manager.snarl_number(managed)];
+    Support support;
+    support.set_forward(child_support.first);
+    return std::make_tuple(support, support, (int)child_support.second);
+}
+
 CachedPackedTraversalSupportFinder::CachedPackedTraversalSupportFinder(const Packer& packer, SnarlManager& snarl_manager, size_t cache_size) :
     PackedTraversalSupportFinder(packer, snarl_manager) {
     size_t num_threads = get_thread_count();
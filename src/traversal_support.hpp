@@ -151,6 +151,53 @@ protected:
     const Packer& packer;
 };
 
+/**
+ * Precompute everything the PackedTraversalSupportFinder would look up, in one parallel
+ * pass over the graph and the snarl tree, so that genotyping reads supports out of flat
+ * arrays (indexed by node rank, edge index and snarl number) instead of scanning the
+ * pack or going through per-thread LRU caches.  Uses a few words of memory per node,
+ * edge and snarl, so is best when most of the graph is going to be called anyway.
+ */
+class PrecomputedPackedTraversalSupportFinder : public PackedTraversalSupportFinder {
+public:
+    PrecomputedPackedTraversalSupportFinder(const Packer& packer, SnarlManager& snarl_manager);
+    virtual ~PrecomputedPackedTraversalSupportFinder();
+
+    /// Support of an edge
+    virtual Support get_edge_support(id_t from, bool from_reverse, id_t to, bool to_reverse) const;
+    
+    /// Minimum support of a node
+    virtual Support get_min_node_support(id_t node) const;
+
+    /// Average support of a node
+    virtual Support get_avg_node_support(id_t node) const;
+
+    /// Average MAPQ of reads that map to a node
+    virtual size_t get_avg_node_mapq(id_t node) const;
+
+    /// Max average node support and total length of a child snarl's deep contents
+    virtual tuple<Support, Support, int> get_child_support(const Snarl& snarl) const;
+
+protected:
+
+    /// Fill in the summary of a snarl from its shallow contents and its children's summaries
+    void summarize_snarl(const Snarl* snarl);
+
+    /// The graph, for converting ids and edges to ranks
+    const VectorizableHandleGraph* vectorizable_graph;
+
+    /// Supports by node rank
+    vector<double> min_node_supports;
+    vector<double> avg_node_supports;
+    vector<size_t> avg_node_mapqs;
+
+    /// Supports by edge index
+    vector<double> edge_supports;
+
+    /// Child support (max average node support) and length by snarl number
+    vector<pair<double, size_t>> child_supports;
+};
+
 /**
  * Add a caching overlay to the PackedTravesalSupportFinder to avoid frequent
  * base queries which can become expensive.  Even caching the edges seems
@@ -0,0 +1,75 @@
+/// \file graph_edit_distance.cpp
+///
+/// unit tests for the bit-parallel sequence-to-DAG edit distance
+///
+
+#include "../handle.hpp"
+#include "../split_strand_graph.hpp"
+#include "../algorithms/graph_edit_distance.hpp"
+#include "catch.hpp"
+
+#include "bdsg/hash_graph.hpp"
+
+namespace vg {
+namespace unittest {
+
+TEST_CASE("dag_edit_distance finds the best walk through a DAG", "[algorithms][handle][editdistance]") {
+
+    bdsg::HashGraph graph;
+
+    handle_t h1 = graph.create_handle("GATTACA");
+    handle_t h2 = graph.create_handle("C");
+    handle_t h3 = graph.create_handle("GG");
+    handle_t h4 = graph.create_handle("TTAGCAT");
+
+    graph.create_edge(h1, h2);
+    graph.create_edge(h1, h3);
+    graph.create_edge(h2, h4);
+    graph.create_edge(h3, h4);
+
+    SECTION("An exact match across a bubble has distance 0") {
+        REQUIRE(algorithms::dag_edit_distance(graph, "TACAGGTTAG") == 0);
+        REQUIRE(algorithms::dag_edit_distance(graph, "ACACTT") == 0);
+    }
+
+    SECTION("Substitutions, insertions, and deletions are counted") {
+        REQUIRE(algorithms::dag_edit_distance(graph, "TACATGTTAG") == 1);
+        REQUIRE(algorithms::dag_edit_distance(graph, "TACAGGGTTAG") == 1);
+        REQUIRE(algorithms::dag_edit_distance(graph, "TACAGTTAG") == 1);
+        REQUIRE(algorithms::dag_edit_distance(graph, "TACAGCTTAG") == 1);
+    }
+
+    SECTION("Ns in the sequence never match") {
+        REQUIRE(algorithms::dag_edit_distance(graph, "GATNACA") == 1);
+    }
+
+    SECTION("Sequences longer than a word are handled") {
+        string seq;
+        for (size_t i = 0; i < 20; ++i) {
+            seq += "GATTACA";
+        }
+        bdsg::HashGraph repeat;
+        handle_t r = repeat.create_handle("GATTACA");
+        repeat.create_edge(r, r);
+        // cycles cannot be bounded
+        REQUIRE(algorithms::dag_edit_distance(repeat, seq) == 0);
+
+        bdsg::HashGraph line;
+        handle_t prev = line.create_handle("GATTACA");
+        for (size_t i = 1; i < 20; ++i) {
+            handle_t next = line.create_handle(i == 10 ? "GATCACA" : "GATTACA");
+            line.create_edge(prev, next);
+            prev = next;
+        }
+        REQUIRE(algorithms::dag_edit_distance(line, seq) == 1);
+        REQUIRE(algorithms::dag_edit_distance(line, seq, 1) <= 1);
+    }
+
+    SECTION("Both strands can be searched after splitting") {
+        StrandSplitGraph split(&graph);
+        REQUIRE(algorithms::dag_edit_distance(split, "CTAACCTG") == 0);
+    }
+}
+
+}
+}
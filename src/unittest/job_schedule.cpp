@@ -0,0 +1,95 @@
+/// \file job_schedule.cpp
+///  
+/// unit tests for the JobSchedule
+///
+
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <limits>
+#include <omp.h>
+#include "../job_schedule.hpp"
+#include "catch.hpp"
+
+
+namespace vg {
+namespace unittest {
+using namespace std;
+
+TEST_CASE("JobSchedule admits jobs that fit in the memory budget", "[jobschedule]") {
+    
+    // (memory estimate, job index) in priority order
+    list<pair<int64_t, int64_t>> queue{{50, 0}, {30, 1}, {10, 2}};
+    
+    SECTION("The first job is started when nothing is running, even if it is over budget") {
+        auto it = JobSchedule::next_job(queue, 0, 0, 20);
+        REQUIRE(it == queue.begin());
+        REQUIRE(it->second == 0);
+    }
+    
+    SECTION("The highest priority job that fits the estimated memory is started") {
+        auto it = JobSchedule::next_job(queue, 60, 0, 100);
+        REQUIRE(it != queue.end());
+        REQUIRE(it->second == 1);
+        
+        it = JobSchedule::next_job(queue, 80, 0, 100);
+        REQUIRE(it != queue.end());
+        REQUIRE(it->second == 2);
+    }
+    
+    SECTION("Jobs are held back if the measured memory would exceed the budget") {
+        auto it = JobSchedule::next_job(queue, 10, 60, 100);
+        REQUIRE(it != queue.end());
+        REQUIRE(it->second == 1);
+        
+        it = JobSchedule::next_job(queue, 10, 95, 100);
+        REQUIRE(it == queue.end());
+    }
+    
+    SECTION("No job is started if none fits in the budget") {
+        auto it = JobSchedule::next_job(queue, 95, 0, 100);
+        REQUIRE(it == queue.end());
+    }
+}
+
+TEST_CASE("JobSchedule executes each job once", "[jobschedule]") {
+    
+    vector<pair<int64_t, int64_t>> job_requirements{{1, 10}, {5, 10}, {3, 10}, {2, 10}};
+    vector<atomic<int>> times_run(job_requirements.size());
+    for (auto& count : times_run) {
+        count.store(0);
+    }
+    
+    JobSchedule schedule(job_requirements, [&](int64_t i) {
+        times_run[i].fetch_add(1);
+    });
+    schedule.execute(numeric_limits<int64_t>::max());
+    
+    for (auto& count : times_run) {
+        REQUIRE(count.load() == 1);
+    }
+}
+
+TEST_CASE("JobSchedule divides threads and memory between concurrent jobs", "[jobschedule]") {
+    
+    vector<pair<int64_t, int64_t>> job_requirements{{2, 10}, {1, 10}};
+    vector<int64_t> memory_budgets(job_requirements.size(), 0);
+    vector<int> thread_budgets(job_requirements.size(), 0);
+    vector<int> omp_threads(job_requirements.size(), 0);
+    
+    JobSchedule schedule(job_requirements, [&](int64_t i, int64_t memory_budget, int num_threads) {
+        memory_budgets[i] = memory_budget;
+        thread_budgets[i] = num_threads;
+        omp_threads[i] = omp_get_max_threads();
+    });
+    schedule.execute(int64_t(1) << 40, 4);
+    
+    for (size_t i = 0; i < job_requirements.size(); ++i) {
+        REQUIRE(memory_budgets[i] == int64_t(1) << 39);
+        REQUIRE(thread_budgets[i] == 2);
+        REQUIRE(omp_threads[i] == 2);
+    }
+}
+
+}
+}
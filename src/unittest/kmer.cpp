@@ -0,0 +1,52 @@
+/**
+ * \file 
+ * unittest/kmer.cpp: test cases for GCSA kmer generation.
+ */
+
+#include "catch.hpp"
+
+#include "../kmer.hpp"
+
+#include <vector>
+
+namespace vg {
+namespace unittest {
+
+TEST_CASE("Duplicate GCSA kmers are merged", "[kmer][gcsa]") {
+    
+    const gcsa::Alphabet alpha;
+    
+    auto make_kmer = [&](const string& seq, gcsa::byte_type pred, gcsa::byte_type succ,
+                         id_t from_id, size_t from_offset, id_t to_id) {
+        gcsa::KMer kmer;
+        kmer.key = gcsa::Key::encode(alpha, seq, pred, succ);
+        kmer.from = gcsa::Node::encode(from_id, from_offset, false);
+        kmer.to = gcsa::Node::encode(to_id, 0, false);
+        return kmer;
+    };
+    
+    vector<gcsa::KMer> kmers;
+    kmers.push_back(make_kmer("GATT", 1 << alpha.char2comp['A'], 1 << alpha.char2comp['C'], 2, 0, 3));
+    kmers.push_back(make_kmer("ACAC", 1 << alpha.char2comp['T'], 1 << alpha.char2comp['G'], 1, 4, 2));
+    kmers.push_back(make_kmer("GATT", 1 << alpha.char2comp['C'], 1 << alpha.char2comp['C'], 2, 0, 3));
+    kmers.push_back(make_kmer("GATT", 1 << alpha.char2comp['A'], 1 << alpha.char2comp['C'], 2, 0, 4));
+    kmers.push_back(make_kmer("ACAC", 1 << alpha.char2comp['T'], 1 << alpha.char2comp['T'], 1, 4, 2));
+    
+    REQUIRE(merge_duplicate_gcsa_kmers(kmers) == 2);
+    REQUIRE(kmers.size() == 3);
+    
+    // sorted by start position
+    REQUIRE(kmers[0].from == gcsa::Node::encode(1, 4, false));
+    REQUIRE(gcsa::Key::successors(kmers[0].key) == ((1 << alpha.char2comp['G']) | (1 << alpha.char2comp['T'])));
+    REQUIRE(kmers[1].to == gcsa::Node::encode(3, 0, false));
+    REQUIRE(gcsa::Key::predecessors(kmers[1].key) == ((1 << alpha.char2comp['A']) | (1 << alpha.char2comp['C'])));
+    REQUIRE(kmers[2].to == gcsa::Node::encode(4, 0, false));
+    REQUIRE(gcsa::Key::predecessors(kmers[2].key) == (1 << alpha.char2comp['A']));
+    
+    // merging again changes nothing
+    REQUIRE(merge_duplicate_gcsa_kmers(kmers) == 0);
+    REQUIRE(kmers.size() == 3);
+}
+
+}
+}
@@ -11,6 +11,10 @@
 #include "../build_index.hpp"
 #include "catch.hpp"
 #include "../algorithms/alignment_path_offsets.hpp"
+#include "random_graph.hpp"
+
+#include <random>
+#include <algorithm>
 
 namespace vg {
 namespace unittest {
@@ -646,5 +650,144 @@ TEST_CASE( "Mapper can walk paths from fan-out MEM algorithm", "[mapping][mapper
     delete lcpidx;
 }
 
+/// The stripped match algorithm as it was written before it searched the strips
+/// in batches, one strip after another, to check the batched one against
+static vector<MaximalExactMatch> serial_stripped_matches(const gcsa::GCSA& gcsa,
+                                                         string::const_iterator seq_begin,
+                                                         string::const_iterator seq_end,
+                                                         size_t strip_length, size_t max_match_length,
+                                                         size_t target_count) {
+    vector<MaximalExactMatch> matches;
+    if (seq_end == seq_begin) {
+        return matches;
+    }
+    int64_t seq_len = seq_end - seq_begin;
+    int64_t num_strips = (seq_len - 1) / strip_length + 1;
+    for (int64_t strip_num = 0; strip_num < num_strips; ++strip_num) {
+        auto strip_end = seq_end - strip_num * strip_length;
+        auto range = gcsa::range_type(0, gcsa.size() - 1);
+        auto cursor = strip_end - 1;
+        while (cursor >= seq_begin &&
+               (!max_match_length || strip_end - cursor <= max_match_length)) {
+            if (*cursor == 'N') {
+                break;
+            }
+            auto next_range = gcsa.LF(range, gcsa.alpha.char2comp[*cursor]);
+            if (gcsa::Range::empty(next_range)) {
+                break;
+            }
+            range = next_range;
+            --cursor;
+            if (target_count && gcsa::Range::length(next_range) <= target_count) {
+                break;
+            }
+        }
+        if (cursor + 1 == strip_end) {
+            continue;
+        }
+        if (!matches.empty() && matches.back().begin <= cursor + 1 && matches.back().end >= strip_end) {
+            continue;
+        }
+        matches.emplace_back(cursor + 1, strip_end, range, gcsa.count(range));
+        if (cursor < seq_begin) {
+            break;
+        }
+    }
+    // strips are searched from the end of the sequence
+    reverse(matches.begin(), matches.end());
+    return matches;
+}
+
+TEST_CASE( "Mapper finds the same stripped matches in batches", "[mapping][mapper][mem]" ) {
+    
+    bdsg::HashGraph graph;
+    random_graph(500, 4, 20, &graph);
+    
+    // Make GCSA quiet
+    gcsa::Verbosity::set(gcsa::Verbosity::SILENT);
+    
+    gcsa::GCSA* gcsaidx = nullptr;
+    gcsa::LCPArray* lcpidx = nullptr;
+    build_gcsa_lcp(graph, gcsaidx, lcpidx, 16, 3);
+    
+    xg::XG xg_index;
+    xg_index.from_path_handle_graph(graph);
+    
+    Mapper mapper(&xg_index, gcsaidx, lcpidx);
+    MEMAccelerator accelerator(*gcsaidx, 3, 6, 20);
+    
+    // make reads from random walks, with some errors
+    default_random_engine gen(6372);
+    vector<handle_t> handles;
+    graph.for_each_handle([&](const handle_t& handle) {
+        handles.push_back(handle);
+    });
+    vector<string> reads;
+    for (size_t i = 0; i < 20; ++i) {
+        handle_t handle = handles[uniform_int_distribution<size_t>(0, handles.size() - 1)(gen)];
+        string read = graph.get_sequence(handle);
+        bool done = false;
+        while (read.size() < 60 && !done) {
+            vector<handle_t> nexts;
+            graph.follow_edges(handle, false, [&](const handle_t& next) {
+                nexts.push_back(next);
+            });
+            if (nexts.empty()) {
+                done = true;
+            }
+            else {
+                handle = nexts[uniform_int_distribution<size_t>(0, nexts.size() - 1)(gen)];
+                read += graph.get_sequence(handle);
+            }
+        }
+        for (size_t j = 0; j < 2; ++j) {
+            read[uniform_int_distribution<size_t>(0, read.size() - 1)(gen)] = "ACGTN"[uniform_int_distribution<size_t>(0, 4)(gen)];
+        }
+        reads.push_back(read);
+    }
+    reads.push_back("");
+    
+    for (bool use_accelerator : {false, true}) {
+        mapper.accelerator = use_accelerator ? &accelerator : nullptr;
+        for (size_t strip_length : {4, 10}) {
+            for (size_t max_match_length : {0, 12}) {
+                for (size_t target_count : {1, 1000}) {
+                    
+                    vector<pair<string::const_iterator, string::const_iterator>> seqs;
+                    for (const string& read : reads) {
+                        seqs.emplace_back(read.begin(), read.end());
+                    }
+                    auto batch_matches = mapper.find_stripped_matches_batch(seqs, strip_length, max_match_length, target_count);
+                    REQUIRE(batch_matches.size() == reads.size());
+                    
+                    for (size_t i = 0; i < reads.size(); ++i) {
+                        auto expected = serial_stripped_matches(*gcsaidx, reads[i].begin(), reads[i].end(),
+                                                                strip_length, max_match_length, target_count);
+                        auto matches = mapper.find_stripped_matches(reads[i].begin(), reads[i].end(),
+                                                                    strip_length, max_match_length, target_count);
+                        REQUIRE(expected.size() == batch_matches[i].size());
+                        REQUIRE(expected.size() == matches.size());
+                        for (size_t j = 0; j < expected.size(); ++j) {
+                            REQUIRE(expected[j].begin == batch_matches[i][j].begin);
+                            REQUIRE(expected[j].end == batch_matches[i][j].end);
+                            REQUIRE(expected[j].range == batch_matches[i][j].range);
+                            REQUIRE(expected[j].match_count == batch_matches[i][j].match_count);
+                            REQUIRE(batch_matches[i][j].primary);
+                            
+                            REQUIRE(expected[j].begin == matches[j].begin);
+                            REQUIRE(expected[j].end == matches[j].end);
+                            REQUIRE(expected[j].range == matches[j].range);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    mapper.accelerator = nullptr;
+    
+    delete gcsaidx;
+    delete lcpidx;
+}
+
 }
 }
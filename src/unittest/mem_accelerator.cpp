@@ -92,6 +92,68 @@ TEST_CASE("MEMAccelerator returns same ranges as direct LF queries",
         delete lcpidx;
     }
 }
+
+TEST_CASE("MEMAccelerator sparse table and LF cache agree with direct LF queries",
+          "[mem][mapping][memaccelerator]" ) {
+    
+    int num_graphs = 5;
+    int seq_size = 200;
+    int var_count = 8;
+    int var_length = 3;
+    int memo_length = 3;
+    int sparse_length = 6;
+    for (int g = 0; g < num_graphs; ++g) {
+        
+        bdsg::HashGraph graph;
+        random_graph(seq_size, var_length, var_count, &graph);
+        
+        // Make GCSA quiet
+        gcsa::Verbosity::set(gcsa::Verbosity::SILENT);
+        
+        // Make pointers to fill in
+        gcsa::GCSA* gcsaidx = nullptr;
+        gcsa::LCPArray* lcpidx = nullptr;
+        
+        // Build the GCSA index
+        build_gcsa_lcp(graph, gcsaidx, lcpidx, 8, 2);
+        
+        // only room for some of the sparse k-mers
+        MEMAccelerator accelerator(*gcsaidx, memo_length, sparse_length, 50);
+        REQUIRE(accelerator.sparse_length() == sparse_length);
+        
+        int found = 0;
+        for (int k = 0; k < (1 << (2 * sparse_length)); ++k) {
+            
+            string seq(sparse_length, 'N');
+            for (int i = 0; i < sparse_length; ++i) {
+                seq[i] = "ACGT"[(k >> i) & 3];
+            }
+            
+            auto direct_range = gcsa::range_type(0, gcsaidx->size() - 1);
+            auto cached_range = direct_range;
+            for (auto cursor = seq.end() - 1; cursor >= seq.begin(); --cursor) {
+                direct_range = gcsaidx->LF(direct_range, gcsaidx->alpha.char2comp[*cursor]);
+                cached_range = accelerator.cached_LF(cached_range, gcsaidx->alpha.char2comp[*cursor]);
+                if (gcsa::Range::empty(direct_range)) {
+                    break;
+                }
+                REQUIRE(cached_range == direct_range);
+            }
+            
+            // sparse k-mers are either absent or correct
+            auto sparse_range = accelerator.sparse_memoized_LF(seq.end() - 1);
+            if (!gcsa::Range::empty(sparse_range)) {
+                REQUIRE(sparse_range == direct_range);
+                ++found;
+            }
+        }
+        REQUIRE(found > 0);
+        REQUIRE(found <= 50);
+        
+        delete gcsaidx;
+        delete lcpidx;
+    }
+}
    
 }
 }
@@ -3519,6 +3519,129 @@ TEST_CASE( "Low-scoring section of multipath alignments can be removed",
         REQUIRE(mpaln.start(0) == 0);
     }
 }
+
+TEST_CASE("The subpath DAG matches the subpath graph of a multipath alignment", "[alignment][multipath]") {
+    
+    // a branching subpath graph with both edges and scored connections:
+    //   0 -> 2, 0 -> 3, 1 => 3 (+1), 2 -> 4, 2 => 5 (-1), 3 -> 4, 4 -> 5
+    // where the optimal alignment passes through ties into both 3 and 4
+    multipath_alignment_t mpaln;
+    mpaln.set_sequence("AAAAAAAAAAAAAAAA");
+    vector<int32_t> scores{5, 4, 3, 3, 6, 2};
+    vector<int64_t> lengths{5, 4, 3, 2, 6, 2};
+    for (size_t i = 0; i < scores.size(); ++i) {
+        subpath_t* subpath = mpaln.add_subpath();
+        subpath->set_score(scores[i]);
+        path_mapping_t* mapping = subpath->mutable_path()->add_mapping();
+        mapping->mutable_position()->set_node_id(i + 1);
+        mapping->mutable_position()->set_offset(0);
+        mapping->mutable_position()->set_is_reverse(false);
+        edit_t* edit = mapping->add_edit();
+        edit->set_from_length(lengths[i]);
+        edit->set_to_length(lengths[i]);
+    }
+    mpaln.mutable_subpath(0)->add_next(2);
+    mpaln.mutable_subpath(0)->add_next(3);
+    connection_t* c1 = mpaln.mutable_subpath(1)->add_connection();
+    c1->set_next(3);
+    c1->set_score(1);
+    mpaln.mutable_subpath(2)->add_next(4);
+    connection_t* c2 = mpaln.mutable_subpath(2)->add_connection();
+    c2->set_next(5);
+    c2->set_score(-1);
+    mpaln.mutable_subpath(3)->add_next(4);
+    mpaln.mutable_subpath(4)->add_next(5);
+    mpaln.add_start(0);
+    mpaln.add_start(1);
+    
+    // the predecessors as the traceback used to collect them, by inverting the nexts and connections
+    vector<vector<pair<int64_t, int32_t>>> prev_subpaths(mpaln.subpath_size());
+    for (int64_t i = 0; i < mpaln.subpath_size(); ++i) {
+        for (auto next : mpaln.subpath(i).next()) {
+            prev_subpaths[next].emplace_back(i, 0);
+        }
+        for (const auto& connection : mpaln.subpath(i).connection()) {
+            prev_subpaths[connection.next()].emplace_back(i, connection.score());
+        }
+    }
+    
+    SECTION("The DAG lists the same predecessors in the same order") {
+        
+        SubpathDAG dag;
+        dag.build(mpaln);
+        for (size_t i = 0; i < mpaln.subpath_size(); ++i) {
+            REQUIRE(dag.score[i] == scores[i]);
+            REQUIRE(dag.length[i] == lengths[i]);
+            vector<pair<int64_t, int32_t>> preds(dag.predecessors(i).begin(), dag.predecessors(i).end());
+            REQUIRE(preds == prev_subpaths[i]);
+        }
+    }
+    
+    SECTION("The thread's workspace is rebuilt for each alignment") {
+        
+        multipath_alignment_t small;
+        small.set_sequence("AAAAA");
+        *small.add_subpath() = mpaln.subpath(0);
+        small.mutable_subpath(0)->clear_next();
+        small.add_start(0);
+        
+        SubpathDAG::workspace(mpaln);
+        const SubpathDAG& dag = SubpathDAG::workspace(small);
+        REQUIRE(dag.score.size() == 1);
+        REQUIRE(dag.pred_begin.size() == 2);
+        REQUIRE(dag.predecessors(0).empty());
+        
+        const SubpathDAG& big_dag = SubpathDAG::workspace(mpaln);
+        for (size_t i = 0; i < mpaln.subpath_size(); ++i) {
+            vector<pair<int64_t, int32_t>> preds(big_dag.predecessors(i).begin(), big_dag.predecessors(i).end());
+            REQUIRE(preds == prev_subpaths[i]);
+        }
+    }
+    
+    SECTION("The optimal alignment matches the one from pushing the DP along the nexts") {
+        
+        // the forward DP as it was done before the DAG, pushing scores along nexts and connections
+        vector<int32_t> prefix_score(mpaln.subpath_size(), 0);
+        vector<int64_t> prev_subpath(mpaln.subpath_size(), -1);
+        int64_t opt_subpath = -1;
+        int32_t opt_score = 0;
+        for (int64_t i = 0; i < mpaln.subpath_size(); ++i) {
+            const subpath_t& subpath = mpaln.subpath(i);
+            int32_t extended_score = prefix_score[i] + subpath.score();
+            for (auto next : subpath.next()) {
+                if (extended_score >= prefix_score[next]) {
+                    prev_subpath[next] = i;
+                    prefix_score[next] = extended_score;
+                }
+            }
+            for (const auto& connection : subpath.connection()) {
+                if (extended_score + connection.score() >= prefix_score[connection.next()]) {
+                    prev_subpath[connection.next()] = i;
+                    prefix_score[connection.next()] = extended_score + connection.score();
+                }
+            }
+            if (extended_score >= opt_score) {
+                opt_score = extended_score;
+                opt_subpath = i;
+            }
+        }
+        vector<int64_t> traceback;
+        for (int64_t i = opt_subpath; i >= 0; i = prev_subpath[i]) {
+            traceback.push_back(i + 1);
+        }
+        reverse(traceback.begin(), traceback.end());
+        
+        Alignment aln;
+        optimal_alignment(mpaln, aln);
+        REQUIRE(aln.score() == opt_score);
+        vector<int64_t> node_ids;
+        for (const auto& mapping : aln.path().mapping()) {
+            node_ids.push_back(mapping.position().node_id());
+        }
+        REQUIRE(node_ids == traceback);
+        REQUIRE(optimal_alignment_score(mpaln) == opt_score);
+    }
+}
 }
 
 
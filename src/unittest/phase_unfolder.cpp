@@ -6,6 +6,8 @@
 
 #include <iostream>
 #include <map>
+#include <set>
+#include <tuple>
 
 #include <omp.h>
 
@@ -613,5 +615,97 @@ TEST_CASE("PhaseUnfolder can extend short threads", "[phaseunfolder][indexing]")
     }
 }
 
+TEST_CASE("PhaseUnfolder gives the same result when unfolding components in parallel", "[phaseunfolder][indexing]") {
+
+    // Build an XG index with a path.
+    Graph graph_with_path;
+    json2pb(graph_with_path, unfolder_graph_path.c_str(), unfolder_graph_path.size());
+    xg::XG xg_index;
+    xg_index.from_path_handle_graph(VG(graph_with_path));
+
+    // Build a GBWT with two threads.
+    gbwt::vector_type alt_path {
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(1, false)),
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(2, false)),
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(4, false)),
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(5, false)),
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(6, false)),
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(8, false)),
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(9, false))
+    };
+    gbwt::vector_type short_path {
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(1, false)),
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(4, false)),
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(5, false)),
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(6, false)),
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(7, false)),
+        static_cast<gbwt::vector_type::value_type>(gbwt::Node::encode(9, false))
+    };
+    std::vector<gbwt::vector_type> gbwt_threads {
+        short_path, alt_path
+    };
+    gbwt::GBWT gbwt_index = get_gbwt(gbwt_threads);
+
+    std::set<vg::id_t> to_remove { 3, 4, 7, 8, 9 };
+    vg::id_t next_id = 10;
+
+    // Unfold once with a single thread.
+    VG serial_graph;
+    {
+        Graph temp_graph;
+        json2pb(temp_graph, unfolder_graph.c_str(), unfolder_graph.size());
+        serial_graph.merge(temp_graph);
+    }
+    for (vg::id_t node : to_remove) {
+        serial_graph.destroy_node(node);
+    }
+    PhaseUnfolder serial_unfolder(xg_index, gbwt_index, next_id);
+    omp_set_num_threads(1);
+    serial_unfolder.unfold(serial_graph);
+
+    // And again in two phases with several threads.
+    VG parallel_graph;
+    {
+        Graph temp_graph;
+        json2pb(temp_graph, unfolder_graph.c_str(), unfolder_graph.size());
+        parallel_graph.merge(temp_graph);
+    }
+    for (vg::id_t node : to_remove) {
+        parallel_graph.destroy_node(node);
+    }
+    PhaseUnfolder parallel_unfolder(xg_index, gbwt_index, next_id);
+    omp_set_num_threads(4);
+    auto unfolded = parallel_unfolder.unfold_components(parallel_graph);
+    REQUIRE(unfolded.components == 2);
+    parallel_unfolder.merge_components(unfolded, parallel_graph);
+    omp_set_num_threads(1);
+
+    SECTION("the node identifiers and mappings are the same") {
+        std::map<vg::id_t, vg::id_t> serial_nodes, parallel_nodes;
+        serial_graph.for_each_node([&](Node* node) {
+            serial_nodes[node->id()] = serial_unfolder.get_mapping(node->id());
+        });
+        parallel_graph.for_each_node([&](Node* node) {
+            parallel_nodes[node->id()] = parallel_unfolder.get_mapping(node->id());
+        });
+        REQUIRE(serial_nodes == parallel_nodes);
+    }
+
+    SECTION("the edges are the same") {
+        std::set<std::tuple<vg::id_t, bool, vg::id_t, bool>> serial_edges, parallel_edges;
+        serial_graph.for_each_edge([&](Edge* edge) {
+            serial_edges.emplace(edge->from(), edge->from_start(), edge->to(), edge->to_end());
+        });
+        parallel_graph.for_each_edge([&](Edge* edge) {
+            parallel_edges.emplace(edge->from(), edge->from_start(), edge->to(), edge->to_end());
+        });
+        REQUIRE(serial_edges == parallel_edges);
+    }
+
+    SECTION("the unfolded graph should contain all indexed paths") {
+        REQUIRE(parallel_unfolder.verify_paths(parallel_graph) == 0);
+    }
+}
+
 }
 }
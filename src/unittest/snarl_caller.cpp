@@ -0,0 +1,195 @@
+//
+//  snarl_caller.cpp
+//
+//  Unit tests for SnarlCaller
+//
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <set>
+#include <limits>
+#include "vg/io/json2pb.h"
+#include <vg/vg.pb.h>
+#include "catch.hpp"
+#include "snarl_caller.hpp"
+#include "traversal_support.hpp"
+#include "test_traversal_support.hpp"
+#include "../statistics.hpp"
+#include "../handle.hpp"
+#include "bdsg/hash_graph.hpp"
+
+//#define debug
+
+namespace vg {
+namespace unittest {
+
+/**
+ * Expose the genotype likelihoods of the Poisson caller for testing, next to
+ * a straight copy of the formula it used before it could do them in batches
+ */
+class TestPoissonSupportSnarlCaller : public PoissonSupportSnarlCaller {
+public:
+    using PoissonSupportSnarlCaller::PoissonSupportSnarlCaller;
+    using PoissonSupportSnarlCaller::genotype_likelihoods;
+
+    double reference_genotype_likelihood(const vector<int>& genotype,
+                                         const vector<SnarlTraversal>& traversals,
+                                         const set<int>& trav_subset,
+                                         const vector<int>& traversal_sizes,
+                                         const vector<double>& traversal_mapqs,
+                                         int ref_trav_idx, double exp_depth, double depth_err,
+                                         int max_trav_size,
+                                         int ref_trav_size) {
+        // the Poisson log-probability as it was computed before factorial_ln() had a table
+        auto poisson_ln = [](int observed, real_t expected) {
+            real_t log_factorial = observed == 0 ? 0. : gamma_ln(observed + 1.0);
+            return log(expected) * (real_t)observed - expected - log_factorial;
+        };
+
+        vector<Support> genotype_supports = support_finder.get_traversal_genotype_support(traversals, genotype, trav_subset, ref_trav_idx,
+                                                                                          &max_trav_size);
+
+        double total_genotype_mapq = 0;
+        size_t total_genotype_length = 0;
+        if (use_mapq) {
+            for (int i = 0; i < genotype.size(); ++i) {
+                total_genotype_mapq += traversal_mapqs[genotype[i]] * traversal_sizes[genotype[i]];
+                total_genotype_length += traversal_sizes[genotype[i]];
+            }
+        }
+
+        Support total_other_support;
+        double total_other_mapq = 0;
+        size_t total_other_length = 0;
+        set<int> genotype_set(genotype.begin(), genotype.end());
+        for (int i = 0; i < traversals.size(); ++i) {
+            if (!genotype_set.count(i)) {
+                total_other_support += genotype_supports[i];
+                if (use_mapq) {
+                    total_other_mapq += traversal_mapqs[i] * traversal_sizes[i];
+                    total_other_length += traversal_sizes[i];
+                }
+            }
+        }
+
+        vector<Support> fixed_genotype_supports = genotype_supports;
+        if (std::equal(genotype.begin() + 1, genotype.end(), genotype.begin())) {
+            for (int i = 0; i < genotype_supports.size(); ++i) {
+                fixed_genotype_supports[i] = genotype_supports[i] / (double)genotype.size();
+            }
+        }
+
+        size_t threshold = support_finder.get_average_traversal_support_switch_threshold();
+        double error_rate = max_trav_size >= threshold ? baseline_error_large : baseline_error_small;
+        if (ref_trav_idx >= 0 && max_trav_size >= insertion_threshold * ref_trav_size) {
+            error_rate *= (max_trav_size >= threshold ? insertion_bias_large : insertion_bias_small);
+        }
+
+        double other_error_rate = error_rate;
+        if (use_mapq && total_other_length > 0) {
+            other_error_rate += phred_to_prob(total_other_mapq / total_other_length);
+        }
+        double other_log_likelihood = poisson_ln(std::round(support_val(total_other_support)), other_error_rate * exp_depth);
+
+        double allele_error_rate = error_rate;
+        if (use_mapq && total_genotype_length > 0) {
+            allele_error_rate += phred_to_prob(total_genotype_mapq / total_genotype_length);
+        }
+        double allele_poisson_lambda = (exp_depth / (double)genotype.size()) * (1. - allele_error_rate);
+
+        double alleles_log_likelihood = 0;
+        for (int allele : genotype) {
+            alleles_log_likelihood += poisson_ln(std::round(support_val(fixed_genotype_supports[allele])), allele_poisson_lambda);
+        }
+
+        return alleles_log_likelihood + other_log_likelihood;
+    }
+};
+
+TEST_CASE( "Batched Poisson genotype likelihoods match the old one-at-a-time formula",
+           "[snarl_caller]" ) {
+
+    // a SNP-like site with an insertion and a deletion allele
+    bdsg::HashGraph graph;
+    handle_t n1 = graph.create_handle("CATG", 1);
+    handle_t n2 = graph.create_handle("A", 2);
+    handle_t n3 = graph.create_handle("TTGCA", 3);
+    handle_t n4 = graph.create_handle("GGAC", 4);
+    graph.create_edge(n1, n2);
+    graph.create_edge(n2, n4);
+    graph.create_edge(n1, n3);
+    graph.create_edge(n3, n4);
+    graph.create_edge(n1, n4);
+
+    unordered_map<nid_t, double> node_supports = {
+        {1, 21.5},
+        {2, 11.6},
+        {3, 7.3},
+        {4, 19.25}
+    };
+
+    unordered_map<edge_t, double> edge_supports = {
+        {graph.edge_handle(n1, n2), 12},
+        {graph.edge_handle(n2, n4), 11},
+        {graph.edge_handle(n1, n3), 7},
+        {graph.edge_handle(n3, n4), 8},
+        {graph.edge_handle(n1, n4), 2}
+    };
+
+    SnarlManager snarl_manager;
+    TestTraversalSupportFinder support_finder(graph, snarl_manager, node_supports, edge_supports);
+    algorithms::BinnedDepthIndex depth_index;
+
+    // reference first
+    vector<SnarlTraversal> traversals(3);
+    json2pb(traversals[0], R"({"visit": [{"node_id": "1"}, {"node_id": "2"}, {"node_id": "4"}]})");
+    json2pb(traversals[1], R"({"visit": [{"node_id": "1"}, {"node_id": "3"}, {"node_id": "4"}]})");
+    json2pb(traversals[2], R"({"visit": [{"node_id": "1"}, {"node_id": "4"}]})");
+    vector<int> traversal_sizes = {1, 5, 0};
+    vector<double> traversal_mapqs = {50, 30, 10};
+
+    for (size_t trav_thresh : {(size_t)1, numeric_limits<size_t>::max()}) {
+        // switches between the small and large baseline errors and insertion biases
+        support_finder.set_support_switch_threshold(trav_thresh, 50);
+        for (bool use_mapq : {false, true}) {
+            for (int ploidy : {1, 2}) {
+                TestPoissonSupportSnarlCaller snarl_caller(graph, snarl_manager, support_finder, depth_index, use_mapq);
+                snarl_caller.set_baseline_error(0.004, 0.02);
+                snarl_caller.set_insertion_bias(2., 3., 6.);
+
+                vector<vector<int>> genotypes;
+                for (int i = 0; i < traversals.size(); ++i) {
+                    if (ploidy == 1) {
+                        genotypes.push_back({i});
+                    } else {
+                        for (int j = i; j < traversals.size(); ++j) {
+                            genotypes.push_back({i, j});
+                        }
+                    }
+                }
+
+                for (const set<int>& trav_subset : {set<int>(), set<int>({0, 1})}) {
+                    for (double exp_depth : {3., 20.}) {
+                        vector<double> batched = snarl_caller.genotype_likelihoods(genotypes, traversals, trav_subset, traversal_sizes,
+                                                                                   traversal_mapqs, 0, exp_depth, 0., 5, 1);
+                        REQUIRE(batched.size() == genotypes.size());
+                        for (size_t i = 0; i < genotypes.size(); ++i) {
+                            double expected = snarl_caller.reference_genotype_likelihood(genotypes[i], traversals, trav_subset, traversal_sizes,
+                                                                                         traversal_mapqs, 0, exp_depth, 0., 5, 1);
+#ifdef debug
+                            cerr << "thresh=" << trav_thresh << " mapq=" << use_mapq << " ploidy=" << ploidy << " depth=" << exp_depth
+                                 << " genotype " << i << ": " << batched[i] << " vs " << expected << endl;
+#endif
+                            // exactly the same, not just close
+                            REQUIRE(batched[i] == expected);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
+}
@@ -9,6 +9,7 @@
 #include <iostream>
 #include <sstream>
 #include <set>
+#include <omp.h>
 #include "vg/io/json2pb.h"
 #include <vg/vg.pb.h>
 #include "catch.hpp"
@@ -7115,6 +7116,28 @@ namespace vg {
         }
         */
         
+        TEST_CASE( "Distance index construction does not depend on the number of threads",
+                  "[snarl_distance]" ) {
+
+            VG graph;
+            random_graph({300, 400, 500}, 10, 30, &graph);
+            IntegratedSnarlFinder finder(graph);
+
+            int thread_count_pre = omp_get_max_threads();
+            vector<string> serialized;
+            for (int num_threads : {1, 4}) {
+                omp_set_num_threads(num_threads);
+                SnarlDistanceIndex distance_index;
+                fill_in_distance_index(&distance_index, &graph, &finder, 50);
+                stringstream out;
+                distance_index.serialize(out);
+                serialized.push_back(out.str());
+            }
+            omp_set_num_threads(thread_count_pre);
+
+            REQUIRE(serialized[0] == serialized[1]);
+        }
+
         TEST_CASE( "Distance index can traverse all the snarls in random graphs",
                   "[snarl_distance_random]" ) {
         
@@ -201,6 +201,19 @@ TEST_CASE("Phred probability summation works", "[statistics]") {
     
 }
 
+TEST_CASE("Cached log factorials match the computed ones", "[statistics]") {
+
+    for (int n : {1, 2, 10, 100, FACTORIAL_LN_TABLE_SIZE - 1}) {
+        REQUIRE(factorial_ln(n) == gamma_ln(n + 1.0));
+    }
+    REQUIRE(factorial_ln(0) == 0.0);
+    REQUIRE(factorial_ln(5) == Approx(log(120.0)));
+    // past the end of the table, it's computed as before
+    REQUIRE(factorial_ln(FACTORIAL_LN_TABLE_SIZE) == gamma_ln(FACTORIAL_LN_TABLE_SIZE + 1.0));
+    // and the precomputed log gives the same poisson probability
+    REQUIRE(poisson_prob_ln(7, 3.5, log((real_t)3.5)) == poisson_prob_ln(7, 3.5));
+}
+
 TEST_CASE("Truncated normal functions produce correct results", "[statistics]") {
     
     random_device rd;
@@ -0,0 +1,53 @@
+#ifndef VG_TEST_TRAVERSAL_SUPPORT_HPP_INCLUDED
+#define VG_TEST_TRAVERSAL_SUPPORT_HPP_INCLUDED
+
+#include <unordered_map>
+#include "../traversal_support.hpp"
+
+namespace vg {
+namespace unittest {
+
+/**
+ * Get the read support from some maps
+ */ 
+class TestTraversalSupportFinder : public TraversalSupportFinder {
+public:
+    TestTraversalSupportFinder(const HandleGraph& graph, SnarlManager& snarl_manager,
+                               const unordered_map<nid_t, double>& node_supports,
+                               const unordered_map<edge_t, double>& edge_supports) :
+        TraversalSupportFinder(graph, snarl_manager),
+        node_supports(node_supports),
+        edge_supports(edge_supports) {
+    }    
+    ~TestTraversalSupportFinder() = default;
+
+    Support get_edge_support(const edge_t& edge) const {
+        Support s;
+        s.set_forward(edge_supports.at(edge));
+        return s;
+    }
+    Support get_edge_support(id_t from, bool from_reverse, id_t to, bool to_reverse) const {
+        return get_edge_support(graph.edge_handle(graph.get_handle(from, from_reverse),
+                                                  graph.get_handle(to, to_reverse)));
+    }
+    virtual Support get_min_node_support(id_t node) const {
+        Support s;
+        s.set_forward(node_supports.at(node));
+        return s;
+    }
+    virtual Support get_avg_node_support(id_t node) const {
+        return get_min_node_support(node);
+    }
+    virtual size_t get_avg_node_mapq(id_t node) const {
+        return 0;
+    }
+    
+protected:    
+    const unordered_map<nid_t, double> node_supports;
+    const unordered_map<edge_t, double> edge_supports;
+};
+
+}
+}
+
+#endif
@@ -12,8 +12,12 @@
 #include <vg/vg.pb.h>
 #include "catch.hpp"
 #include "traversal_support.hpp"
+#include "test_traversal_support.hpp"
 #include "traversal_finder.hpp"
 #include "../handle.hpp"
+#include "../integrated_snarl_finder.hpp"
+#include "bdsg/hash_graph.hpp"
+#include <bdsg/overlays/overlay_helper.hpp>
 #include <vg/io/protobuf_emitter.hpp>
 #include <vg/io/vpkg.hpp>
 
@@ -22,47 +26,6 @@
 namespace vg {
 namespace unittest {
 
-
-/**
- * Get the read support from some maps
- */ 
-class TestTraversalSupportFinder : public TraversalSupportFinder {
-public:
-    TestTraversalSupportFinder(const HandleGraph& graph, SnarlManager& snarl_manager,
-                               const unordered_map<nid_t, double>& node_supports,
-                               const unordered_map<edge_t, double>& edge_supports) :
-        TraversalSupportFinder(graph, snarl_manager),
-        node_supports(node_supports),
-        edge_supports(edge_supports) {
-    }    
-    ~TestTraversalSupportFinder() = default;
-
-    Support get_edge_support(const edge_t& edge) const {
-        Support s;
-        s.set_forward(edge_supports.at(edge));
-        return s;
-    }
-    Support get_edge_support(id_t from, bool from_reverse, id_t to, bool to_reverse) const {
-        return get_edge_support(graph.edge_handle(graph.get_handle(from, from_reverse),
-                                                  graph.get_handle(to, to_reverse)));
-    }
-    virtual Support get_min_node_support(id_t node) const {
-        Support s;
-        s.set_forward(node_supports.at(node));
-        return s;
-    }
-    virtual Support get_avg_node_support(id_t node) const {
-        return get_min_node_support(node);
-    }
-    virtual size_t get_avg_node_mapq(id_t node) const {
-        return 0;
-    }
-    
-protected:    
-    const unordered_map<nid_t, double> node_supports;
-    const unordered_map<edge_t, double> edge_supports;
-};
-
 TEST_CASE( "Deletion allele supports found correctly",
            "[traversal_support]" ) {
 
@@ -162,5 +125,77 @@ TEST_CASE( "Deletion allele supports found correctly",
     
 }
 
+TEST_CASE( "Precomputed pack supports match the on-demand ones",
+           "[traversal_support]" ) {
+
+    // a bubble with a nested bubble on one side
+    bdsg::HashGraph base;
+    handle_t n1 = base.create_handle("GATT", 1);
+    handle_t n2 = base.create_handle("A", 2);
+    handle_t n3 = base.create_handle("CAGT", 3);
+    handle_t n4 = base.create_handle("G", 4);
+    handle_t n5 = base.create_handle("TT", 5);
+    handle_t n6 = base.create_handle("ACA", 6);
+    handle_t n7 = base.create_handle("GGCAT", 7);
+    base.create_edge(n1, n2);
+    base.create_edge(n1, n3);
+    base.create_edge(n3, n4);
+    base.create_edge(n3, n5);
+    base.create_edge(n4, n6);
+    base.create_edge(n5, n6);
+    base.create_edge(n6, n7);
+    base.create_edge(n2, n7);
+
+    bdsg::VectorizableOverlayHelper overlay_helper;
+    const HandleGraph* graph = dynamic_cast<const HandleGraph*>(overlay_helper.apply(&base));
+
+    Packer packer(graph, true, true, false, true);
+    Alignment aln1;
+    json2pb(aln1, R"({"sequence": "GATTCAGTGACAGGCAT", "mapping_quality": 60, "path": {"mapping": [
+        {"position": {"node_id": 1}, "edit": [{"from_length": 4, "to_length": 4}]},
+        {"position": {"node_id": 3}, "edit": [{"from_length": 4, "to_length": 4}]},
+        {"position": {"node_id": 4}, "edit": [{"from_length": 1, "to_length": 1}]},
+        {"position": {"node_id": 6}, "edit": [{"from_length": 3, "to_length": 3}]},
+        {"position": {"node_id": 7}, "edit": [{"from_length": 5, "to_length": 5}]}]}})");
+    Alignment aln2;
+    json2pb(aln2, R"({"sequence": "TTCAGTTTAC", "mapping_quality": 20, "path": {"mapping": [
+        {"position": {"node_id": 1, "offset": 2}, "edit": [{"from_length": 2, "to_length": 2}]},
+        {"position": {"node_id": 3}, "edit": [{"from_length": 4, "to_length": 4}]},
+        {"position": {"node_id": 5}, "edit": [{"from_length": 2, "to_length": 2}]},
+        {"position": {"node_id": 6}, "edit": [{"from_length": 2, "to_length": 2}]}]}})");
+    packer.add(aln1);
+    packer.add(aln2);
+    packer.add(aln2);
+
+    IntegratedSnarlFinder snarl_finder(*graph);
+    SnarlManager snarl_manager(snarl_finder.find_snarls_parallel());
+    REQUIRE(snarl_manager.num_snarls() > 1);
+
+    PackedTraversalSupportFinder on_demand(packer, snarl_manager);
+    PrecomputedPackedTraversalSupportFinder precomputed(packer, snarl_manager);
+
+    graph->for_each_handle([&](const handle_t& handle) {
+            nid_t node_id = graph->get_id(handle);
+            REQUIRE(TraversalSupportFinder::support_val(precomputed.get_min_node_support(node_id)) ==
+                    TraversalSupportFinder::support_val(on_demand.get_min_node_support(node_id)));
+            REQUIRE(TraversalSupportFinder::support_val(precomputed.get_avg_node_support(node_id)) ==
+                    TraversalSupportFinder::support_val(on_demand.get_avg_node_support(node_id)));
+            REQUIRE(precomputed.get_avg_node_mapq(node_id) == on_demand.get_avg_node_mapq(node_id));
+        });
+
+    const TraversalSupportFinder& precomputed_finder = precomputed;
+    graph->for_each_edge([&](const edge_t& edge) {
+            REQUIRE(TraversalSupportFinder::support_val(precomputed_finder.get_edge_support(edge)) ==
+                    TraversalSupportFinder::support_val(on_demand.get_edge_support(edge)));
+        });
+
+    snarl_manager.for_each_snarl_preorder([&](const Snarl* snarl) {
+            tuple<Support, Support, int> expected = on_demand.get_child_support(*snarl);
+            tuple<Support, Support, int> found = precomputed.get_child_support(*snarl);
+            REQUIRE(TraversalSupportFinder::support_val(get<0>(found)) == TraversalSupportFinder::support_val(get<0>(expected)));
+            REQUIRE(get<2>(found) == get<2>(expected));
+        });
+}
+
 }
 }
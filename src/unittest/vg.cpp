@@ -1269,6 +1269,54 @@ TEST_CASE("find_breakpoints() should determine where the graph needs to break to
     }
     
 }
+TEST_CASE("ensure_breakpoints() divides each node once at all its breakpoints", "[vg][edit]") {
+
+    VG vg;
+
+    handle_t h1 = vg.create_handle("GATTACA");
+    handle_t h2 = vg.create_handle("CA");
+    vg.create_edge(h1, h2);
+
+    path_handle_t path = vg.create_path_handle("ref");
+    vg.append_step(path, h1);
+    vg.append_step(path, h2);
+
+    nid_t id1 = vg.get_id(h1);
+    nid_t id2 = vg.get_id(h2);
+
+    unordered_map<nid_t, set<pos_t>> breakpoints;
+    breakpoints[id1].insert(make_pos_t(id1, false, 5));
+    breakpoints[id1].insert(make_pos_t(id1, false, 2));
+    // breakpoints at the node ends are ignored
+    breakpoints[id1].insert(make_pos_t(id1, false, 0));
+    breakpoints[id1].insert(make_pos_t(id1, false, 7));
+
+    map<pos_t, nid_t> translation = ensure_breakpoints(&vg, breakpoints);
+
+    // the node is now in three parts, plus the untouched node
+    REQUIRE(vg.get_node_count() == 4);
+
+    REQUIRE(vg.get_sequence(vg.get_handle(translation.at(make_pos_t(id1, false, 0)))) == "GA");
+    REQUIRE(vg.get_sequence(vg.get_handle(translation.at(make_pos_t(id1, false, 2)))) == "TTA");
+    REQUIRE(vg.get_sequence(vg.get_handle(translation.at(make_pos_t(id1, false, 5)))) == "CA");
+
+    // the reverse strand positions map to the same parts
+    REQUIRE(translation.at(make_pos_t(id1, true, 0)) == translation.at(make_pos_t(id1, false, 5)));
+    REQUIRE(translation.at(make_pos_t(id1, true, 2)) == translation.at(make_pos_t(id1, false, 2)));
+    REQUIRE(translation.at(make_pos_t(id1, true, 5)) == translation.at(make_pos_t(id1, false, 0)));
+    REQUIRE(translation.at(make_pos_t(id1, false, 7)) == 0);
+    REQUIRE(translation.at(make_pos_t(id1, true, 7)) == 0);
+
+    // the path now runs through all the parts
+    string path_sequence;
+    vg.for_each_step_in_path(path, [&](const step_handle_t& step) {
+        path_sequence += vg.get_sequence(vg.get_handle_of_step(step));
+    });
+    REQUIRE(vg.get_step_count(path) == 4);
+    REQUIRE(path_sequence == "GATTACACA");
+    REQUIRE(vg.has_node(id2));
+}
+
 TEST_CASE("create_handle() correctly creates handles using given sequence and id", "[vg]") {
     VG vg;
         
@@ -6,7 +6,7 @@ BASH_TAP_ROOT=../deps/bash-tap
 PATH=../bin:$PATH # for vg
 
 
-plan tests 19
+plan tests 30
 
 # Toy example of hand-made pileup (and hand inspected truth) to make sure some
 # obvious (and only obvious) SNPs are detected by vg call
@@ -106,7 +106,15 @@ LESS_THREE=$(if (( $DIFF_COUNT < 3 )); then echo 1; else echo 0; fi)
 # there is some wobble here
 is "${LESS_THREE}" "1" "Fewer than 3 differences between allales called via traversals or directly"
 
-rm -f HGSVC_alts.vg HGSVC_alts.xg HGSVC_alts.pack HGSVC.vcf baseline_gts.txt gts.txt HGSVC1.vcf HGSVC2.vcf HGSVC_travs.gaf.gz HGSVC_travs.gbwt HGSVC_travs.vcf HGSVC_direct.vcf baseline_gts1.txt gts1.txt gts-travs.txt gts-direct.txt calls-travs.txt calls-direct.txt
+# Save the depth index and call with it instead of recomputing it
+vg depth HGSVC_alts.xg -k HGSVC_alts.pack -o HGSVC_alts.depth
+vg call HGSVC_alts.xg -k HGSVC_alts.pack -s HG00514 --depth-index HGSVC_alts.depth > HGSVC_depth.vcf
+diff <(grep -v '^#' HGSVC_direct.vcf | sort) <(grep -v '^#' HGSVC_depth.vcf | sort)
+is "$?" "0" "Calling with a depth index from vg depth gives the same VCF as computing the depths"
+vg depth HGSVC_alts.xg -k HGSVC_alts.pack -b 100 -o HGSVC_alts.depth 2> /dev/null
+is "$?" "1" "Bin size options are rejected when saving a depth index"
+
+rm -f HGSVC_alts.vg HGSVC_alts.xg HGSVC_alts.pack HGSVC.vcf baseline_gts.txt gts.txt HGSVC1.vcf HGSVC2.vcf HGSVC_travs.gaf.gz HGSVC_travs.gbwt HGSVC_travs.vcf HGSVC_direct.vcf baseline_gts1.txt gts1.txt gts-travs.txt gts-direct.txt calls-travs.txt calls-direct.txt HGSVC_alts.depth HGSVC_depth.vcf
 
 vg construct -a -r small/x.fa -v small/x.vcf.gz > x.vg
 vg index -x x.xg x.vg -L
@@ -188,8 +196,42 @@ grep -v "##contig" x_subs.vcf > x_subs_nocontig.vcf
 grep -v "##contig" x_subs_override.vcf > x_subs_override_nocontig.vcf
 diff x_subs_nocontig.vcf x_subs_override_nocontig.vcf
 is $? 0 "overriding contig length does not change calls"
-
-rm -f x_sub1.fa x_sub1.fa.fai x_sub2.fa x_sub2.fa.fai x_sub1.vcf.gz x_sub1.vcf.gz.tbi  x_sub2.vcf.gz x_sub2.vcf.gz.tbi sim.gam x_subs.vcf x_subs_override.vcf x_subs_nocontig.vcf x_subs_override_nocontig.vcf
+vg call x_subs.vg -k x_subs.pack --window 2 > x_subs_window.vcf
+diff x_subs.vcf x_subs_window.vcf
+is $? 0 "streaming the VCF out in windows does not change the output"
+vg call x_subs.vg -k x_subs.pack --bgzip-out x_subs_window.vcf.gz
+bgzip -dc x_subs_window.vcf.gz | diff x_subs.vcf -
+is $? 0 "vg call can write the VCF with bgzip"
+is "$(tabix x_subs_window.vcf.gz x | wc -l)" "$(grep -v "^#" x_subs.vcf | wc -l)" "vg call tabix-indexes the bgzipped VCF"
+vg call x_subs.vg -k x_subs.pack --precompute-supports > x_subs_precomputed.vcf
+diff x_subs.vcf x_subs_precomputed.vcf
+is $? 0 "precomputing the supports does not change the calls"
+vg call x_subs.vg -k x_subs.pack -s A -k x_subs.pack -s B > x_subs_joint.vcf
+is "$(grep "^#CHROM" x_subs_joint.vcf | cut -f 10-)" "$(printf "A\tB")" "joint calling makes a VCF column for each sample"
+is "$(grep -v "^#" x_subs_joint.vcf | awk '$10 != $11' | wc -l)" 0 "joint calling gives samples with the same pack the same genotypes"
+vg sim -x x_subs.vg -n 2000 -a -s 29 > sim2.gam
+vg pack -x x_subs.vg -o x_subs2.pack -g sim2.gam
+vg call x_subs.vg -k x_subs.pack -s A -a > x_subs_A.vcf
+vg call x_subs.vg -k x_subs2.pack -s B -a > x_subs_B.vcf
+vg call x_subs.vg -k x_subs.pack -s A -k x_subs2.pack -s B -a > x_subs_AB.vcf
+# compare the sites where the joint call and both single-sample calls agree on the alleles
+awk -F '\t' '
+    function dp(info,   fields, i) { split(info, fields, ";"); for (i in fields) if (fields[i] ~ /^DP=/) return substr(fields[i], 4) }
+    /^#/ { next }
+    { key = $1 ":" $2 ":" $3 ":" $4 ":" $5 }
+    FILENAME == "x_subs_A.vcf" { a[key] = $10; a_dp[key] = dp($8); next }
+    FILENAME == "x_subs_B.vcf" { b[key] = $10; b_dp[key] = dp($8); next }
+    (key in a) && (key in b) {
+        ++sites
+        if ($10 != a[key] || $11 != b[key]) ++bad_samples
+        if (dp($8) != a_dp[key] + b_dp[key]) ++bad_depths
+    }
+    END { print sites + 0, bad_samples + 0, bad_depths + 0 }' x_subs_A.vcf x_subs_B.vcf x_subs_AB.vcf > x_subs_AB.cmp
+is "$(cut -d ' ' -f 1 x_subs_AB.cmp | awk '$1 > 0' | wc -l)" 1 "joint calling with different packs has sites to compare with the single-sample calls"
+is "$(cut -d ' ' -f 2 x_subs_AB.cmp)" 0 "joint calling with different packs gives each sample the column of its single-sample call"
+is "$(cut -d ' ' -f 3 x_subs_AB.cmp)" 0 "joint calling with different packs sums the sample depths into INFO DP"
+
+rm -f x_sub1.fa x_sub1.fa.fai x_sub2.fa x_sub2.fa.fai x_sub1.vcf.gz x_sub1.vcf.gz.tbi  x_sub2.vcf.gz x_sub2.vcf.gz.tbi sim.gam x_subs.vcf x_subs_override.vcf x_subs_nocontig.vcf x_subs_override_nocontig.vcf x_subs_window.vcf x_subs_window.vcf.gz x_subs_window.vcf.gz.tbi x_subs_precomputed.vcf x_subs_joint.vcf sim2.gam x_subs2.pack x_subs_A.vcf x_subs_B.vcf x_subs_AB.vcf x_subs_AB.cmp
 
 
 
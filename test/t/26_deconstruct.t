@@ -5,7 +5,7 @@ BASH_TAP_ROOT=../deps/bash-tap
 
 PATH=../bin:$PATH # for vg
 
-plan tests 37
+plan tests 39
 
 vg msga -f GRCh38_alts/FASTA/HLA/V-352962.fa -t 1 -k 16 | vg mod -U 10 - | vg mod -c - > hla.vg
 vg index hla.vg -x hla.xg
@@ -139,7 +139,16 @@ gzip -dc x.decon.vcf.gz > x.decon.vcf
 diff x.decon.vcf x.gbz.decon.vcf
 is "$?" 0 "gbz deconstruction gives same output as gbwt deconstruction"
 
-rm -f x.vg x.xg x.gbwt x.decon.vcf.gz x.decon.vcf.gz.tbi x.decon.vcf x.gbz.decon.vcf x.giraffe.gbz x.min x.dist small.s1.h1.fa small.s1.h2.fa decon.s1.h1.fa decon.s1.h2.fa
+vg deconstruct x.giraffe.gbz --window 3 -t 2 > x.gbz.window.decon.vcf
+diff x.gbz.decon.vcf x.gbz.window.decon.vcf
+is "$?" 0 "windowed deconstruction gives same output as unwindowed deconstruction"
+
+vg deconstruct x.giraffe.gbz --window 2 -a > x.gbz.window.decon.vcf
+vg deconstruct x.giraffe.gbz -a > x.gbz.all.decon.vcf
+diff x.gbz.all.decon.vcf x.gbz.window.decon.vcf
+is "$?" 0 "windowed deconstruction of all snarls gives same output as unwindowed deconstruction"
+
+rm -f x.vg x.xg x.gbwt x.decon.vcf.gz x.decon.vcf.gz.tbi x.decon.vcf x.gbz.decon.vcf x.gbz.window.decon.vcf x.gbz.all.decon.vcf x.giraffe.gbz x.min x.dist small.s1.h1.fa small.s1.h2.fa decon.s1.h1.fa decon.s1.h2.fa
 
 # todo you could argue merging shouldn't happen here because there's no child snarl
 # this check should come into play with nesting support
@@ -5,7 +5,7 @@ BASH_TAP_ROOT=../deps/bash-tap
 
 PATH=../bin:$PATH # for vg
 
-plan tests 20
+plan tests 24
 
 vg construct -m 1000 -r tiny/tiny.fa >flat.vg
 vg view flat.vg| sed 's/CAAATAAGGCTTGGAAATTTTCTGGAGTTCTATTATATTCCAACTCTCTG/CAAATAAGGCTTGGAAATTTTCTGGAGATCTATTATACTCCAACTCTCTG/' | vg view -Fv - >2snp.vg
@@ -57,6 +57,16 @@ y=$(vg pack -x flat.xg -Di 2snp.gam.cx.3x | wc -c)
 
 is $x $y "pack index merging produces the expected result for edges"
 
+vg pack -x flat.xg -o 2snp.gam.cx -g 2snp.gam
+vg pack -x flat.xg -o 2snp.gam.atomic.cx -g 2snp.gam -A
+is $(vg pack -x flat.xg -di 2snp.gam.atomic.cx | md5sum | cut -f 1 -d\ ) $(vg pack -x flat.xg -di 2snp.gam.cx | md5sum | cut -f 1 -d\ ) "atomic counters give the same base coverage"
+is $(vg pack -x flat.xg -Di 2snp.gam.atomic.cx | md5sum | cut -f 1 -d\ ) $(vg pack -x flat.xg -Di 2snp.gam.cx | md5sum | cut -f 1 -d\ ) "atomic counters give the same edge coverage"
+vg pack -x flat.xg -o 2snp.gam.mapped.cx -g 2snp.gam -m
+is $(vg pack -x flat.xg -di 2snp.gam.mapped.cx | md5sum | cut -f 1 -d\ ) $(vg pack -x flat.xg -di 2snp.gam.cx | md5sum | cut -f 1 -d\ ) "mappable packs give the same base coverage"
+vg pack -x flat.xg -i 2snp.gam.mapped.cx -o 2snp.gam.unmapped.cx
+is $(md5sum 2snp.gam.unmapped.cx | cut -f 1 -d\ ) $(md5sum 2snp.gam.cx | cut -f 1 -d\ ) "mappable packs convert back to the compressed format"
+rm -f 2snp.gam.atomic.cx 2snp.gam.mapped.cx 2snp.gam.unmapped.cx
+
 rm -f flat.vg 2snp.vg 2snp.xg 2snp.sim flat.gcsa flat.gcsa.lcp flat.xg 2snp.xg 2snp.gam 2snp.gam.cx 2snp.gam.cx.3x 2snp.gam.vgpu
 
 vg construct -r tiny/tiny.fa -v tiny/tiny.vcf.gz > tiny.vg
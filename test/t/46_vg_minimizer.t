@@ -5,7 +5,7 @@ BASH_TAP_ROOT=../deps/bash-tap
 
 PATH=../bin:$PATH # for vg
 
-plan tests 16
+plan tests 22
 
 
 # Indexing a single graph
@@ -49,13 +49,41 @@ vg minimizer --no-dist -t 1 -o x.mi x.gbz
 is $? 0 "construction from GBZ"
 is $(md5sum x.mi | cut -f 1 -d\ ) 0d75343d78d1e7d9e9fbc3d7d2386ce2 "construction is deterministic"
 
+# Sharded construction does not depend on the number of threads
+vg minimizer --no-dist -t 1 --shards 4 -o x.mi x.gbz
+is $? 0 "sharded construction"
+vg minimizer --no-dist -t 2 --shards 4 -o x2.mi x.gbz
+is $? 0 "multithreaded sharded construction"
+cmp -s x.mi x2.mi
+is $? 0 "sharded construction is deterministic"
+vg minimizer --no-dist -t 1 -o x.mi x.gbz
+
+# Adding haplotypes to an existing index
+# Start from the reference path only and add the VCF haplotypes to it
+vg gbwt -x x.vg -E -o x.ref.gbwt
+vg gbwt -m -o x.full.gbwt x.ref.gbwt x.gbwt
+vg gbwt -x x.xg -g x.full.gbz --gbz-format x.full.gbwt
+vg minimizer -t 1 -d x.dist -o x.full.mi x.full.gbz
+vg minimizer -t 1 -d x.dist -g x.ref.gbwt -o x.ref.mi x.xg
+vg minimizer -t 1 -d x.dist -l x.ref.mi --new-haplotypes x.gbwt -o x.added.mi x.full.gbz
+is $? 0 "adding new haplotypes"
+# The hash tables may be laid out differently, so compare the mappings instead of the files
+vg sim -x x.xg -n 200 -l 40 -e 0.02 -i 0.005 -s 3 -a > x.reads.gam
+vg giraffe -t 1 -Z x.full.gbz -m x.full.mi -d x.dist -G x.reads.gam | vg view -aj - | jq -c '[.name, .score, .path]' > x.full.json
+vg giraffe -t 1 -Z x.full.gbz -m x.added.mi -d x.dist -G x.reads.gam | vg view -aj - | jq -c '[.name, .score, .path]' > x.added.json
+diff x.full.json x.added.json > /dev/null
+is $? 0 "adding haplotypes to an index gives the same mappings as indexing all of them"
+vg minimizer --no-dist -t 1 --new-haplotypes x.gbwt -o x2.mi x.gbz 2> /dev/null
+is $? 1 "adding new haplotypes requires an existing index"
+rm -f x.ref.gbwt x.full.gbwt x.full.gbz x.full.mi x.ref.mi x.added.mi x.reads.gam x.full.json x.added.json
+
 # Store payload in the index
 vg minimizer -t 1 -o x.mi -g x.gbwt -d x.dist x.gg
 is $? 0 "construction with payload"
 #Construction will not be deterministic because the snarls are not deterministic
 #is $(md5sum x.mi | cut -f 1 -d\ ) 6d377fdd427c7173e16e92516bf72b7b "construction is deterministic"
 
-rm -f x.vg x.xg x.gbwt x.snarls x.dist x.mi x.gg x.gbz
+rm -f x.vg x.xg x.gbwt x.snarls x.dist x.mi x2.mi x.gg x.gbz
 
 
 # Indexing two graphs
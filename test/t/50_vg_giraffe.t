@@ -5,7 +5,7 @@ BASH_TAP_ROOT=../deps/bash-tap
 
 PATH=../bin:$PATH # for vg
 
-plan tests 50
+plan tests 51
 
 vg construct -a -r small/x.fa -v small/x.vcf.gz >x.vg
 vg index -x x.xg x.vg
@@ -49,6 +49,11 @@ vg giraffe -Z x.giraffe.gbz -f reads/small.middle.ref.fq --full-l-bonus 0 > mapp
 is "$(vg view -aj  mapped-nobonus.gam | jq '.score')" "63" "Mapping without a full length bonus produces the correct score"
 rm -f mapped-nobonus.gam
 
+vg giraffe -Z x.giraffe.gbz -f reads/small.middle.ref.fq --pack-out mapped.pack > mapped.gam
+vg pack -x x.giraffe.gbz -g mapped.gam -o mapped.gam.pack
+is "$(vg pack -x x.giraffe.gbz -i mapped.pack -d | md5sum)" "$(vg pack -x x.giraffe.gbz -i mapped.gam.pack -d | md5sum)" "Mapping can write the same coverage pack as vg pack"
+rm -f mapped.gam mapped.pack mapped.gam.pack
+
 vg minimizer -k 29 -b -s 18 -d x.dist -g x.gbwt -o x.sync x.xg
 
 vg giraffe -x x.xg -H x.gbwt -m x.sync -d x.dist -f reads/small.middle.ref.fq > mapped.sync.gam